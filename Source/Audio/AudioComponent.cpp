@@ -22,6 +22,7 @@
 */
 
 #include "AudioComponent.h"
+#include "OfflineAudioDevice.h"
 #include "../AccessClass.h"
 #include "../Processors/ProcessorGraph/ProcessorGraph.h"
 #include <stdio.h>
@@ -29,10 +30,15 @@
 #include "../CoreServices.h"
 #include "../Utils/Utils.h"
 
-AudioComponent::AudioComponent() : isPlaying (false)
+AudioComponent::AudioComponent (bool isOffline) : isPlaying (false),
+                                                  offline (isOffline)
 {
     AccessClass::setAudioComponent (this);
 
+    // As the only registered device type, the offline device keeps hardware devices from being scanned or opened
+    if (offline)
+        deviceManager.addAudioDeviceType (std::make_unique<OfflineAudioIODeviceType>());
+
     bool initialized = false;
     while (! initialized)
     {
@@ -297,6 +303,10 @@ bool AudioComponent::beginCallbacks()
             LOGD ("Adding audio callback.");
             deviceManager.addAudioCallback (graphPlayer.get());
             isPlaying = true;
+
+            if (auto* offlineDevice = dynamic_cast<OfflineAudioIODevice*> (deviceManager.getCurrentAudioDevice()))
+                offlineDevice->setRendering (true);
+
             return true;
         }
         else
@@ -314,6 +324,9 @@ bool AudioComponent::beginCallbacks()
 
 void AudioComponent::endCallbacks()
 {
+    if (auto* offlineDevice = dynamic_cast<OfflineAudioIODevice*> (deviceManager.getCurrentAudioDevice()))
+        offlineDevice->setRendering (false);
+
     LOGD ("Removing audio callback.");
     deviceManager.removeAudioCallback (graphPlayer.get());
     isPlaying = false;
@@ -46,8 +46,9 @@ class TESTABLE AudioComponent
 {
 public:
     /** Constructor. Finds the audio component (if there is one), and sets the
-    default sample rate and buffer size.*/
-    AudioComponent();
+    default sample rate and buffer size. In offline mode, no hardware device is
+    opened, and the ProcessorGraph is driven as fast as possible instead.*/
+    AudioComponent (bool isOffline = false);
 
     /** Destructor. Ends the audio callbacks if they are active.*/
     ~AudioComponent();
@@ -69,6 +70,9 @@ public:
     /** Returns true if the audio callbacks are active, false otherwise.*/
     bool callbacksAreActive();
 
+    /** Returns true if the ProcessorGraph is driven by the offline device instead of a sound card.*/
+    bool isOffline() const { return offline; }
+
     /** Checks whether a device is available*/
     bool checkForDevice();
 
@@ -123,6 +127,7 @@ public:
 
 private:
     bool isPlaying;
+    bool offline;
 
     std::unique_ptr<AudioProcessorPlayer> graphPlayer;
 
@@ -0,0 +1,220 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "MonitorOutput.h"
+#include "../Utils/Utils.h"
+
+MonitorOutput::MonitorOutput()
+    : fifo (MONITOR_RING_SAMPLES),
+      ring (2, MONITOR_RING_SAMPLES),
+      sampleRate (44100.0),
+      deviceBufferSize (0),
+      largestWrite (0),
+      underruns (0),
+      playing (false)
+{
+}
+
+MonitorOutput::~MonitorOutput()
+{
+    close();
+}
+
+String MonitorOutput::open (const String& deviceType, const String& deviceName, int bufferSize)
+{
+    close();
+
+    deviceManager = std::make_unique<AudioDeviceManager>();
+
+    String error = deviceManager->initialiseWithDefaultDevices (0, 2);
+
+    if (error.isEmpty() && deviceType.isNotEmpty())
+        deviceManager->setCurrentAudioDeviceType (deviceType, true);
+
+    AudioDeviceManager::AudioDeviceSetup setup = deviceManager->getAudioDeviceSetup();
+
+    if (deviceName.isNotEmpty())
+        setup.outputDeviceName = deviceName;
+
+    setup.bufferSize = bufferSize;
+    setup.useDefaultInputChannels = false;
+    setup.inputChannels = 0;
+    setup.useDefaultOutputChannels = true;
+
+    if (error.isEmpty())
+        error = deviceManager->setAudioDeviceSetup (setup, true);
+
+    if (error.isEmpty() && deviceManager->getCurrentAudioDevice() == nullptr)
+        error = "No monitor output device available";
+
+    if (error.isNotEmpty())
+    {
+        deviceManager.reset();
+        return error;
+    }
+
+    AudioIODevice* device = deviceManager->getCurrentAudioDevice();
+    sampleRate = device->getCurrentSampleRate();
+    deviceBufferSize = device->getCurrentBufferSizeSamples();
+
+    reset();
+    underruns = 0;
+
+    deviceManager->addAudioCallback (this);
+
+    LOGC ("Opened monitor output ", device->getName(), " at ", sampleRate, " Hz with a ", deviceBufferSize.load(), "-sample buffer");
+
+    return String();
+}
+
+void MonitorOutput::close()
+{
+    if (deviceManager == nullptr)
+        return;
+
+    deviceManager->removeAudioCallback (this);
+    deviceManager->closeAudioDevice();
+    deviceManager.reset();
+}
+
+void MonitorOutput::reset()
+{
+    fifo.reset();
+    largestWrite = 0;
+    playing = false;
+}
+
+int MonitorOutput::write (const float* samples, int numSamples, bool toLeft, bool toRight)
+{
+    if (numSamples > largestWrite.load (std::memory_order_relaxed))
+        largestWrite.store (numSamples, std::memory_order_relaxed);
+
+    const auto scope = fifo.write (jmin (numSamples, fifo.getFreeSpace()));
+
+    const int starts[2] = { scope.startIndex1, scope.startIndex2 };
+    const int sizes[2] = { scope.blockSize1, scope.blockSize2 };
+    const int offsets[2] = { 0, scope.blockSize1 };
+
+    for (int block = 0; block < 2; block++)
+    {
+        if (sizes[block] == 0)
+            continue;
+
+        if (toLeft)
+            ring.copyFrom (0, starts[block], samples + offsets[block], sizes[block]);
+        else
+            ring.clear (0, starts[block], sizes[block]);
+
+        if (toRight)
+            ring.copyFrom (1, starts[block], samples + offsets[block], sizes[block]);
+        else
+            ring.clear (1, starts[block], sizes[block]);
+    }
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+void MonitorOutput::read (float* left, float* right, int numSamples)
+{
+    const int target = largestWrite.load (std::memory_order_relaxed) + deviceBufferSize.load (std::memory_order_relaxed);
+    int ready = fifo.getNumReady();
+
+    if (! playing)
+    {
+        if (ready == 0 || ready < target)
+        {
+            FloatVectorOperations::clear (left, numSamples);
+            FloatVectorOperations::clear (right, numSamples);
+            return;
+        }
+
+        playing = true;
+    }
+
+    // the devices' clocks differ: drop the oldest audio rather than let the latency grow
+    if (ready > 2 * target)
+    {
+        fifo.read (ready - target);
+        ready = target;
+    }
+
+    const auto scope = fifo.read (jmin (numSamples, ready));
+
+    if (scope.blockSize1 > 0)
+    {
+        FloatVectorOperations::copy (left, ring.getReadPointer (0, scope.startIndex1), scope.blockSize1);
+        FloatVectorOperations::copy (right, ring.getReadPointer (1, scope.startIndex1), scope.blockSize1);
+    }
+
+    if (scope.blockSize2 > 0)
+    {
+        FloatVectorOperations::copy (left + scope.blockSize1, ring.getReadPointer (0, scope.startIndex2), scope.blockSize2);
+        FloatVectorOperations::copy (right + scope.blockSize1, ring.getReadPointer (1, scope.startIndex2), scope.blockSize2);
+    }
+
+    const int numRead = scope.blockSize1 + scope.blockSize2;
+
+    if (numRead < numSamples)
+    {
+        FloatVectorOperations::clear (left + numRead, numSamples - numRead);
+        FloatVectorOperations::clear (right + numRead, numSamples - numRead);
+
+        playing = false;
+        underruns++;
+    }
+}
+
+double MonitorOutput::getLatencyMs() const
+{
+    return 1000.0 * (largestWrite.load() + deviceBufferSize.load()) / sampleRate;
+}
+
+void MonitorOutput::audioDeviceIOCallbackWithContext (const float* const* inputChannelData,
+                                                      int numInputChannels,
+                                                      float* const* outputChannelData,
+                                                      int numOutputChannels,
+                                                      int numSamples,
+                                                      const AudioIODeviceCallbackContext& context)
+{
+    if (numOutputChannels >= 2)
+    {
+        read (outputChannelData[0], outputChannelData[1], numSamples);
+
+        for (int ch = 2; ch < numOutputChannels; ch++)
+            FloatVectorOperations::clear (outputChannelData[ch], numSamples);
+    }
+    else
+    {
+        for (int ch = 0; ch < numOutputChannels; ch++)
+            FloatVectorOperations::clear (outputChannelData[ch], numSamples);
+    }
+}
+
+void MonitorOutput::audioDeviceAboutToStart (AudioIODevice* device)
+{
+    deviceBufferSize = device->getCurrentBufferSizeSamples();
+}
+
+void MonitorOutput::audioDeviceStopped()
+{
+}
@@ -0,0 +1,121 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __MONITOROUTPUT_H__
+#define __MONITOROUTPUT_H__
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../TestableExport.h"
+
+#include <atomic>
+
+#define MONITOR_RING_SAMPLES 65536
+
+/**
+
+  A second audio output stream for the Audio Monitor, with its own (small)
+  device buffer, so that monitoring latency is not tied to the large blocks
+  that drive acquisition.
+
+  The processing thread appends audio to a lock-free single-producer,
+  single-consumer ring; the monitor device's callback plays it back. Because
+  audio arrives once per acquisition block, the callback keeps a jitter buffer
+  of the largest chunk written so far plus one device buffer: playback starts
+  once that much is queued, restarts the same way after an underrun, and skips
+  ahead if the clocks of the two devices let the queue grow past twice that.
+
+  @see AudioMonitor, AudioComponent
+
+*/
+
+class TESTABLE MonitorOutput : public AudioIODeviceCallback
+{
+public:
+    /** Constructor */
+    MonitorOutput();
+
+    /** Destructor. Closes the device if it is open.*/
+    ~MonitorOutput() override;
+
+    /** Opens a stereo output device of the given type and name with the requested buffer
+        size (in samples) and starts playback. Returns an error message, or an empty string.*/
+    String open (const String& deviceType, const String& deviceName, int bufferSize);
+
+    /** Stops playback and closes the device */
+    void close();
+
+    /** Returns true if the device is open */
+    bool isOpen() const { return deviceManager != nullptr; }
+
+    /** Returns the sample rate of the open device */
+    double getSampleRate() const { return sampleRate; }
+
+    /** Returns the buffer size of the open device, in samples */
+    int getBufferSize() const { return deviceBufferSize.load(); }
+
+    /** Appends audio from the processing thread, to the left and/or right output;
+        never blocks. Returns the number of samples that fit in the ring.*/
+    int write (const float* samples, int numSamples, bool toLeft, bool toRight);
+
+    /** Fills the left and right outputs from the ring (the device callback's side) */
+    void read (float* left, float* right, int numSamples);
+
+    /** Returns the current size of the jitter buffer, in ms */
+    double getLatencyMs() const;
+
+    /** Returns the number of device callbacks that ran out of audio since the device was opened */
+    int getNumUnderruns() const { return underruns.load(); }
+
+    /** Empties the ring and the jitter buffer; only while no audio is being written or played */
+    void reset();
+
+    void audioDeviceIOCallbackWithContext (const float* const* inputChannelData,
+                                           int numInputChannels,
+                                           float* const* outputChannelData,
+                                           int numOutputChannels,
+                                           int numSamples,
+                                           const AudioIODeviceCallbackContext& context) override;
+
+    void audioDeviceAboutToStart (AudioIODevice* device) override;
+
+    void audioDeviceStopped() override;
+
+private:
+    std::unique_ptr<AudioDeviceManager> deviceManager;
+
+    AbstractFifo fifo;
+    AudioBuffer<float> ring;
+
+    double sampleRate;
+
+    std::atomic<int> deviceBufferSize;
+    std::atomic<int> largestWrite;
+    std::atomic<int> underruns;
+
+    /** Only touched by the device callback */
+    bool playing;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MonitorOutput);
+};
+
+#endif
@@ -0,0 +1,198 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "OfflineAudioDevice.h"
+
+#include "../AccessClass.h"
+#include "../CoreServices.h"
+#include "../Processors/ProcessorGraph/ProcessorGraph.h"
+#include "../Processors/RecordNode/RecordNode.h"
+#include "../Utils/Utils.h"
+
+OfflineAudioIODevice::OfflineAudioIODevice() : AudioIODevice (OFFLINE_DEVICE_TYPE_NAME, OFFLINE_DEVICE_TYPE_NAME),
+                                               Thread ("Offline Renderer")
+{
+}
+
+OfflineAudioIODevice::~OfflineAudioIODevice()
+{
+    close();
+}
+
+String OfflineAudioIODevice::open (const BigInteger& inputChannels,
+                                   const BigInteger& outputChannels,
+                                   double sampleRate_,
+                                   int bufferSizeSamples)
+{
+    close();
+
+    sampleRate = sampleRate_ > 0 ? sampleRate_ : 44100.0;
+    bufferSize = bufferSizeSamples > 0 ? bufferSizeSamples : getDefaultBufferSize();
+
+    activeOutputChannels = outputChannels;
+    activeOutputChannels.setRange (2, activeOutputChannels.getHighestBit() + 1, false);
+
+    deviceIsOpen = true;
+
+    return {};
+}
+
+void OfflineAudioIODevice::close()
+{
+    stop();
+    deviceIsOpen = false;
+}
+
+void OfflineAudioIODevice::start (AudioIODeviceCallback* newCallback)
+{
+    if (newCallback == nullptr || newCallback == callback)
+        return;
+
+    stop();
+
+    newCallback->audioDeviceAboutToStart (this);
+
+    {
+        const ScopedLock sl (callbackLock);
+        callback = newCallback;
+    }
+
+    startThread (Thread::Priority::high);
+}
+
+void OfflineAudioIODevice::stop()
+{
+    rendering = false;
+
+    signalThreadShouldExit();
+    notify();
+    stopThread (5000);
+
+    AudioIODeviceCallback* lastCallback;
+
+    {
+        const ScopedLock sl (callbackLock);
+        lastCallback = callback;
+        callback = nullptr;
+    }
+
+    if (lastCallback != nullptr)
+        lastCallback->audioDeviceStopped();
+}
+
+void OfflineAudioIODevice::setRendering (bool shouldRender)
+{
+    if (shouldRender)
+    {
+        /* The graph does not change during acquisition, so Record Nodes are only looked up once */
+        recordNodes = AccessClass::getProcessorGraph()->getRecordNodes();
+        blocksRendered = 0;
+    }
+
+    rendering = shouldRender;
+    notify();
+}
+
+void OfflineAudioIODevice::waitForRecordBuffers()
+{
+    for (auto* recordNode : recordNodes)
+    {
+        // the fill level drops as the Record Thread writes, without any further blocks being processed;
+        // a pre-trigger window is kept full while not recording, so only a recording is waited on
+        while (rendering && ! threadShouldExit() && recordNode->getRecordingStatus()
+               && recordNode->getRecordBufferUsage() > OFFLINE_RECORD_BUFFER_HIGH_WATER)
+            wait (2);
+    }
+}
+
+void OfflineAudioIODevice::run()
+{
+    AudioBuffer<float> outputBuffer (jmax (2, activeOutputChannels.getHighestBit() + 1), bufferSize);
+
+    while (! threadShouldExit())
+    {
+        if (! rendering)
+        {
+            wait (100);
+            continue;
+        }
+
+        waitForRecordBuffers();
+
+        if (! rendering || threadShouldExit())
+            continue;
+
+        outputBuffer.clear();
+
+        {
+            const ScopedLock sl (callbackLock);
+
+            if (callback != nullptr)
+                callback->audioDeviceIOCallbackWithContext (nullptr,
+                                                            0,
+                                                            outputBuffer.getArrayOfWritePointers(),
+                                                            outputBuffer.getNumChannels(),
+                                                            bufferSize,
+                                                            {});
+        }
+
+        blocksRendered++;
+
+        if (AccessClass::getProcessorGraph()->allFileReadersFinished())
+        {
+            rendering = false;
+
+            const double seconds = double (blocksRendered.load()) * bufferSize / sampleRate;
+            LOGC ("Offline processing finished: ", blocksRendered.load(), " blocks (", seconds, " s at the device rate).");
+
+            MessageManager::callAsync ([]
+                                       {
+                                           CoreServices::setAcquisitionStatus (false);
+                                           JUCEApplication::getInstance()->systemRequestedQuit(); });
+        }
+    }
+}
+
+StringArray OfflineAudioIODeviceType::getDeviceNames (bool wantInputNames) const
+{
+    if (wantInputNames)
+        return {};
+
+    return { OFFLINE_DEVICE_TYPE_NAME };
+}
+
+int OfflineAudioIODeviceType::getIndexOfDevice (AudioIODevice* device, bool asInput) const
+{
+    if (asInput || dynamic_cast<OfflineAudioIODevice*> (device) == nullptr)
+        return -1;
+
+    return 0;
+}
+
+AudioIODevice* OfflineAudioIODeviceType::createDevice (const String& outputDeviceName, const String& inputDeviceName)
+{
+    if (outputDeviceName.isNotEmpty() && outputDeviceName != OFFLINE_DEVICE_TYPE_NAME)
+        return nullptr;
+
+    return new OfflineAudioIODevice();
+}
@@ -0,0 +1,142 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __OFFLINEAUDIODEVICE_H__
+#define __OFFLINEAUDIODEVICE_H__
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+
+#define OFFLINE_DEVICE_TYPE_NAME "Offline"
+#define OFFLINE_RECORD_BUFFER_HIGH_WATER 0.5f
+
+class RecordNode;
+
+/**
+
+  A virtual audio device that drives the ProcessorGraph as fast as the CPU allows,
+  instead of at the pace of a sound card.
+
+  Blocks are only rendered while rendering is enabled (i.e. during acquisition).
+  Before each block, the device waits for every Record Node's buffer to drain below
+  OFFLINE_RECORD_BUFFER_HIGH_WATER, so disk writing applies backpressure instead of
+  dropping data. Once every File Reader has reached the end of its playback range,
+  acquisition is stopped and the application quits.
+
+  @see AudioComponent, OfflineAudioIODeviceType
+
+*/
+
+class OfflineAudioIODevice : public AudioIODevice,
+                             private Thread
+{
+public:
+    /** Constructor */
+    OfflineAudioIODevice();
+
+    /** Destructor */
+    ~OfflineAudioIODevice() override;
+
+    StringArray getOutputChannelNames() override { return { "Left", "Right" }; }
+    StringArray getInputChannelNames() override { return {}; }
+
+    Array<double> getAvailableSampleRates() override { return { 44100.0, 48000.0, 96000.0 }; }
+    Array<int> getAvailableBufferSizes() override { return { 256, 512, 1024, 2048, 4096, 8192 }; }
+    int getDefaultBufferSize() override { return 1024; }
+
+    String open (const BigInteger& inputChannels, const BigInteger& outputChannels, double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override { return deviceIsOpen; }
+
+    void start (AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override { return callback != nullptr; }
+
+    String getLastError() override { return {}; }
+
+    int getCurrentBufferSizeSamples() override { return bufferSize; }
+    double getCurrentSampleRate() override { return sampleRate; }
+    int getCurrentBitDepth() override { return 32; }
+
+    BigInteger getActiveOutputChannels() const override { return activeOutputChannels; }
+    BigInteger getActiveInputChannels() const override { return {}; }
+
+    int getOutputLatencyInSamples() override { return 0; }
+    int getInputLatencyInSamples() override { return 0; }
+
+    /** Starts or pauses rendering blocks */
+    void setRendering (bool shouldRender);
+
+    /** Returns the number of blocks rendered since rendering was last enabled */
+    int64 getNumBlocksRendered() const { return blocksRendered.load(); }
+
+private:
+    /** Renders blocks back to back while rendering is enabled */
+    void run() override;
+
+    /** Waits until every Record Node's buffer has room for more data */
+    void waitForRecordBuffers();
+
+    bool deviceIsOpen = false;
+    double sampleRate = 44100.0;
+    int bufferSize = 1024;
+    BigInteger activeOutputChannels;
+
+    CriticalSection callbackLock;
+    AudioIODeviceCallback* callback = nullptr;
+
+    std::atomic<bool> rendering { false };
+    std::atomic<int64> blocksRendered { 0 };
+
+    Array<RecordNode*> recordNodes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineAudioIODevice);
+};
+
+/**
+
+  Device type that exposes a single OfflineAudioIODevice to the AudioDeviceManager.
+
+  When it is the only registered type, no hardware audio devices are opened.
+
+*/
+
+class OfflineAudioIODeviceType : public AudioIODeviceType
+{
+public:
+    /** Constructor */
+    OfflineAudioIODeviceType() : AudioIODeviceType (OFFLINE_DEVICE_TYPE_NAME) {}
+
+    void scanForDevices() override {}
+
+    StringArray getDeviceNames (bool wantInputNames) const override;
+    int getDefaultDeviceIndex (bool forInput) const override { return forInput ? -1 : 0; }
+    int getIndexOfDevice (AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return false; }
+
+    AudioIODevice* createDevice (const String& outputDeviceName, const String& inputDeviceName) override;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineAudioIODeviceType);
+};
+
+#endif // __OFFLINEAUDIODEVICE_H__
@@ -0,0 +1,268 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BatchRunner.h"
+
+#include "Processors/FileReader/BinaryFileSource/BinaryFileSource.h"
+
+#include <iomanip>
+#include <iostream>
+
+BatchRunner::BatchRunner (const File& signalChain_, const File& outputDirectory_, int numJobs_)
+    : signalChain (signalChain_),
+      outputDirectory (outputDirectory_),
+      numJobs (jmax (1, numJobs_))
+{
+}
+
+int BatchRunner::addRecordings (const File& directory)
+{
+    Array<File> recordings;
+
+    if (directory.existsAsFile() && directory.hasFileExtension ("oebin"))
+        recordings.add (directory);
+    else
+        recordings = directory.findChildFiles (File::findFiles, true, "structure.oebin");
+
+    recordings.sort();
+
+    for (auto& recording : recordings)
+    {
+        auto* job = jobs.add (new Job());
+        job->recording = recording;
+
+        BinarySource::BinaryFileSource source;
+
+        if (source.openFile (recording) && source.getNumRecords() > 0)
+        {
+            job->recordedSeconds = double (source.getRecordNumSamples (0)) / source.getRecordSampleRate (0);
+
+            for (auto& dataFile : recording.getParentDirectory().getChildFile ("continuous").findChildFiles (File::findFiles, true, "*.dat"))
+                job->recordedBytes += dataFile.getSize();
+        }
+    }
+
+    return recordings.size();
+}
+
+bool BatchRunner::writeJobConfig (Job& job) const
+{
+    std::unique_ptr<XmlElement> xml = XmlDocument (signalChain).getDocumentElement();
+
+    if (xml == nullptr || ! xml->hasTagName ("SETTINGS"))
+        return false;
+
+    /* session X/Record Node 101/experiment1/recording1 becomes job folder "X_Record Node 101_experiment1_recording1" */
+    File recordingDirectory = job.recording.getParentDirectory();
+    File experimentDirectory = recordingDirectory.getParentDirectory();
+    File nodeDirectory = experimentDirectory.getParentDirectory();
+    String jobName = File::createLegalFileName (nodeDirectory.getParentDirectory().getFileName()
+                                                + "_" + nodeDirectory.getFileName()
+                                                + "_" + experimentDirectory.getFileName()
+                                                + "_" + recordingDirectory.getFileName());
+
+    /* Sessions with the same name in different input directories still get their own folders */
+    String uniqueName = jobName;
+
+    for (int suffix = 2; isJobNameTaken (uniqueName, job); suffix++)
+        uniqueName = jobName + "_" + String (suffix);
+
+    job.outputDirectory = outputDirectory.getChildFile (uniqueName);
+    job.outputDirectory.createDirectory();
+    job.config = job.outputDirectory.getChildFile ("signal_chain.xml");
+    job.logFile = job.outputDirectory.getChildFile ("batch.log");
+
+    for (auto* signalChainXml : xml->getChildWithTagNameIterator ("SIGNALCHAIN"))
+    {
+        for (auto* processor : signalChainXml->getChildWithTagNameIterator ("PROCESSOR"))
+        {
+            XmlElement* parameters = processor->getChildByName ("PROCESSOR_PARAMETERS");
+
+            if (parameters == nullptr)
+                continue;
+
+            const String pluginName = processor->getStringAttribute ("pluginName");
+
+            if (pluginName == "File Reader")
+            {
+                parameters->setAttribute ("selected_file", job.recording.getFullPathName());
+
+                /* The template's playback range belongs to its own recording; without one, each job plays its whole file */
+                parameters->removeAttribute ("start_time");
+                parameters->removeAttribute ("end_time");
+            }
+            else if (pluginName == "Record Node")
+            {
+                parameters->setAttribute ("directory", job.outputDirectory.getFullPathName());
+
+                /* Secondary engines stay on their own drives, in a folder named after the job */
+                if (XmlElement* customParameters = processor->getChildByName ("CUSTOM_PARAMETERS"))
+                {
+                    for (auto* engine : customParameters->getChildWithTagNameIterator ("SECONDARY_ENGINE"))
+                    {
+                        File engineDirectory = File (engine->getStringAttribute ("directory")).getChildFile (uniqueName);
+                        engine->setAttribute ("directory", engineDirectory.getFullPathName());
+                    }
+                }
+            }
+        }
+    }
+
+    if (XmlElement* controlPanel = xml->getChildByName ("CONTROLPANEL"))
+        controlPanel->setAttribute ("recordPath", job.outputDirectory.getFullPathName());
+
+    return xml->writeTo (job.config);
+}
+
+bool BatchRunner::isJobNameTaken (const String& name, const Job& job) const
+{
+    const File directory = outputDirectory.getChildFile (name);
+
+    for (auto* other : jobs)
+    {
+        if (other != &job && other->outputDirectory == directory)
+            return true;
+    }
+
+    return false;
+}
+
+bool BatchRunner::startJob (Job& job)
+{
+    if (! writeJobConfig (job))
+    {
+        std::cout << "Unable to write signal chain for " << job.recording.getFullPathName() << std::endl;
+        job.exitCode = 1;
+        return false;
+    }
+
+    StringArray command;
+    command.add (File::getSpecialLocation (File::currentExecutableFile).getFullPathName());
+    command.add ("--offline");
+    command.add (job.config.getFullPathName());
+
+    job.startTime = Time::getMillisecondCounter();
+
+    if (! job.process.start (command, ChildProcess::wantStdOut | ChildProcess::wantStdErr))
+    {
+        std::cout << "Unable to launch job for " << job.recording.getFullPathName() << std::endl;
+        job.exitCode = 1;
+        return false;
+    }
+
+    std::cout << "Started " << job.recording.getFullPathName() << std::endl;
+
+    job.startThread();
+
+    return true;
+}
+
+void BatchRunner::Job::run()
+{
+    /* Reading blocks until the process writes or exits, so every job drains its own pipe */
+    logFile.deleteFile();
+    FileOutputStream log (logFile);
+
+    char buffer[4096];
+
+    while (const int numRead = process.readProcessOutput (buffer, sizeof (buffer)))
+        log.write (buffer, size_t (numRead));
+
+    exitCode = process.getExitCode();
+    elapsedSeconds = (Time::getMillisecondCounter() - startTime) / 1000.0;
+}
+
+void BatchRunner::reportJob (const Job& job) const
+{
+    const double elapsed = jmax (job.elapsedSeconds, 0.001);
+
+    std::cout << (job.exitCode == 0 ? "Finished " : "FAILED (see " + job.logFile.getFullPathName().toStdString() + ") ")
+              << job.recording.getFullPathName() << ": "
+              << std::fixed << std::setprecision (1)
+              << job.recordedSeconds << " s of data in " << elapsed << " s ("
+              << job.recordedSeconds / elapsed << "x real time, "
+              << job.recordedBytes / elapsed / (1024.0 * 1024.0) << " MB/s)" << std::endl;
+}
+
+int BatchRunner::run()
+{
+    if (jobs.isEmpty())
+    {
+        std::cout << "No recordings found." << std::endl;
+        return 1;
+    }
+
+    if (! outputDirectory.createDirectory())
+    {
+        std::cout << "Unable to create output directory " << outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Processing " << jobs.size() << " recordings, " << numJobs << " at a time." << std::endl;
+
+    const uint32 batchStart = Time::getMillisecondCounter();
+
+    Array<Job*> running;
+    int nextJob = 0;
+    int numFailed = 0;
+    double totalRecordedSeconds = 0;
+
+    while (nextJob < jobs.size() || ! running.isEmpty())
+    {
+        while (running.size() < numJobs && nextJob < jobs.size())
+        {
+            Job* job = jobs[nextJob++];
+
+            if (startJob (*job))
+                running.add (job);
+            else
+                numFailed++;
+        }
+
+        for (int i = running.size(); --i >= 0;)
+        {
+            Job* job = running[i];
+
+            if (! job->isThreadRunning())
+            {
+                reportJob (*job);
+                running.remove (i);
+
+                if (job->exitCode != 0)
+                    numFailed++;
+                else
+                    totalRecordedSeconds += job->recordedSeconds;
+            }
+        }
+
+        Thread::sleep (50);
+    }
+
+    const double elapsed = jmax ((Time::getMillisecondCounter() - batchStart) / 1000.0, 0.001);
+
+    std::cout << std::fixed << std::setprecision (1)
+              << "Batch finished in " << elapsed << " s: " << jobs.size() - numFailed << " succeeded, " << numFailed << " failed ("
+              << totalRecordedSeconds / elapsed << "x real time overall)." << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __BATCHRUNNER_H__
+#define __BATCHRUNNER_H__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+
+  Reprocesses many recordings with one saved signal chain.
+
+  Each recording (any structure.oebin found under the given directories) becomes a
+  job: a copy of the signal chain whose File Readers play the whole recording and
+  whose Record Nodes write to a folder of the output directory. Jobs run as separate
+  "--offline" instances of the GUI, up to numJobs at a time, so each gets its own
+  process, graph and threads. Per-job throughput is reported as each job finishes.
+
+  @see OfflineAudioIODevice
+
+*/
+
+class BatchRunner
+{
+public:
+    /** Constructor */
+    BatchRunner (const File& signalChain, const File& outputDirectory, int numJobs);
+
+    /** Adds every recording found under a directory. Returns the number of recordings added. */
+    int addRecordings (const File& directory);
+
+    /** Runs all jobs and blocks until they finish. Returns 0 if every job succeeded. */
+    int run();
+
+private:
+    /** One recording; its thread copies the process's console output to the log until the process exits */
+    struct Job : public Thread
+    {
+        Job() : Thread ("Batch Job") {}
+
+        void run() override;
+
+        File recording;
+        File config;
+        File outputDirectory;
+        File logFile;
+
+        double recordedSeconds = 0;
+        int64 recordedBytes = 0;
+
+        ChildProcess process;
+        uint32 startTime = 0;
+        double elapsedSeconds = 0;
+        uint32 exitCode = 0;
+    };
+
+    /** Writes the signal chain for one job, pointing File Readers and Record Nodes at its files */
+    bool writeJobConfig (Job& job) const;
+
+    /** Returns true if a job other than this one already writes to a folder of this name */
+    bool isJobNameTaken (const String& name, const Job& job) const;
+
+    /** Launches a job's process and its output thread */
+    bool startJob (Job& job);
+
+    /** Prints the throughput of a finished job */
+    void reportJob (const Job& job) const;
+
+    File signalChain;
+    File outputDirectory;
+    int numJobs;
+
+    OwnedArray<Job> jobs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchRunner);
+};
+
+#endif // __BATCHRUNNER_H__
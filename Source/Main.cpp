@@ -28,7 +28,9 @@
 #define _MAIN
 #endif
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "BatchRunner.h"
 #include "MainWindow.h"
+#include "Processors/RecordNode/BinaryFormat/NpyFile.h"
 
 #include <fstream>
 #include <stdio.h>
@@ -101,10 +103,32 @@ public:
 
         SystemStats::setApplicationCrashHandler (handleCrash);
 
+        // Repair .npy headers left unfinalized by an interrupted recording, then exit
+        int repairIndex = parameters.indexOf ("--repair-npy", true);
+
+        if (repairIndex >= 0)
+        {
+            setApplicationReturnValue (repairRecording (parameters[repairIndex + 1]));
+            quit();
+            return;
+        }
+
+        // Reprocess many recordings with one signal chain, then exit:
+        // --batch <config.xml> <output dir> [--jobs N] <recording dir> [<recording dir> ...]
+        int batchIndex = parameters.indexOf ("--batch", true);
+
+        if (batchIndex >= 0)
+        {
+            setApplicationReturnValue (runBatch (parameters, batchIndex));
+            quit();
+            return;
+        }
+
         // Parse parameters
         if (! parameters.isEmpty())
         {
             bool isConsoleApp = false;
+            bool isOffline = false;
             File fileToLoad;
 
             for (auto param : parameters)
@@ -113,6 +137,12 @@ public:
                 {
                     isConsoleApp = true;
                 }
+                else if (param.equalsIgnoreCase ("--offline"))
+                {
+                    // Headless, driven as fast as possible, and quits at the end of the file
+                    isConsoleApp = true;
+                    isOffline = true;
+                }
                 else if (fileToLoad.getFullPathName().isEmpty())
                 {
                     File localPath (File::getCurrentWorkingDirectory().getChildFile (param));
@@ -130,7 +160,15 @@ public:
                 }
             }
 
-            mainWindow = std::make_unique<MainWindow> (fileToLoad, isConsoleApp);
+            if (isOffline && ! fileToLoad.existsAsFile())
+            {
+                std::cout << "Offline mode requires a signal chain file: --offline <config.xml>" << std::endl;
+                setApplicationReturnValue (1);
+                quit();
+                return;
+            }
+
+            mainWindow = std::make_unique<MainWindow> (fileToLoad, isConsoleApp, isOffline);
         }
         else
         {
@@ -140,6 +178,79 @@ public:
 
     void shutdown() {}
 
+    /** Runs the --batch command line. Returns 0 if every recording was processed successfully. */
+    static int runBatch (const StringArray& parameters, int batchIndex)
+    {
+        const File cwd = File::getCurrentWorkingDirectory();
+        const File signalChain = cwd.getChildFile (parameters[batchIndex + 1]);
+
+        if (! signalChain.existsAsFile() || parameters[batchIndex + 2].isEmpty())
+        {
+            std::cout << "Usage: --batch <config.xml> <output dir> [--jobs N] <recording dir> [<recording dir> ...]" << std::endl;
+            return 1;
+        }
+
+        int numJobs = SystemStats::getNumPhysicalCpus();
+        Array<File> recordingDirectories;
+
+        for (int i = batchIndex + 3; i < parameters.size(); i++)
+        {
+            if (parameters[i].equalsIgnoreCase ("--jobs"))
+                numJobs = parameters[++i].getIntValue();
+            else
+                recordingDirectories.add (cwd.getChildFile (parameters[i]));
+        }
+
+        BatchRunner runner (signalChain, cwd.getChildFile (parameters[batchIndex + 2]), numJobs);
+
+        for (auto& directory : recordingDirectories)
+        {
+            if (runner.addRecordings (directory) == 0)
+                std::cout << "No recordings found in " << directory.getFullPathName() << std::endl;
+        }
+
+        return runner.run();
+    }
+
+    /** Repairs the header of every .npy file in a recording directory. Returns 0 if all files were valid. */
+    static int repairRecording (const String& path)
+    {
+        // never default to the working directory: every .npy below it would be rewritten
+        if (path.isEmpty() || path.startsWith ("-"))
+        {
+            std::cout << "Usage: --repair-npy <recording dir>" << std::endl;
+            return 1;
+        }
+
+        const File directory = File::getCurrentWorkingDirectory().getChildFile (path);
+
+        if (! directory.isDirectory())
+        {
+            std::cout << "Not a directory: " << directory.getFullPathName() << std::endl;
+            std::cout << "Usage: --repair-npy <recording dir>" << std::endl;
+            return 1;
+        }
+
+        int numFailed = 0;
+
+        for (auto file : directory.findChildFiles (File::findFiles, true, "*.npy"))
+        {
+            int64 numRecords = NpyFile::repairHeader (file);
+
+            if (numRecords < 0)
+            {
+                std::cout << "Unable to repair " << file.getFullPathName() << std::endl;
+                numFailed++;
+            }
+            else
+            {
+                std::cout << file.getFullPathName() << ": " << numRecords << " records" << std::endl;
+            }
+        }
+
+        return numFailed > 0 ? 1 : 0;
+    }
+
     static void handleCrash (void* input)
     {
         MainWindow::handleCrash (input);
@@ -46,7 +46,8 @@ MainDocumentWindow::MainDocumentWindow()
     setAccessible (false);
 }
 
-MainWindow::MainWindow (const File& fileToLoad, bool isConsoleApp_) : isConsoleApp (isConsoleApp_)
+MainWindow::MainWindow (const File& fileToLoad, bool isConsoleApp_, bool isOffline_) : isConsoleApp (isConsoleApp_ || isOffline_),
+                                                                                       isOffline (isOffline_)
 {
     customLookAndFeel = std::make_unique<CustomLookAndFeel>();
     LookAndFeel::setDefaultLookAndFeel (customLookAndFeel.get());
@@ -103,8 +104,17 @@ MainWindow::MainWindow (const File& fileToLoad, bool isConsoleApp_) : isConsoleA
     // Create ProcessorGraph and AudioComponent, and connect them.
     // Callbacks will be set by the play button in the control panel
 
+    // Offline instances only process the signal chain they were given, so they leave saved state
+    // untouched, and several of them can run side by side
+    if (isOffline)
+    {
+        shouldReloadOnStartup = false;
+        shouldEnableHttpServer = false;
+        automaticVersionChecking = false;
+    }
+
     LOGD ("Creating audio component...");
-    audioComponent = std::make_unique<AudioComponent>();
+    audioComponent = std::make_unique<AudioComponent> (isOffline);
 
     LOGD ("Creating processor graph...");
     processorGraph = std::make_unique<ProcessorGraph> (isConsoleApp);
@@ -245,6 +255,39 @@ MainWindow::MainWindow (const File& fileToLoad, bool isConsoleApp_) : isConsoleA
 #endif
 
     Process::setPriority (Process::HighPriority);
+
+    if (isOffline)
+    {
+        // Start once the message loop is running; the offline device stops acquisition and quits at the end of the file.
+        // Anything that keeps it from starting exits with an error, since nothing else would ever quit
+        MessageManager::callAsync ([this]
+                                   {
+                                       auto quitWithError = []
+                                       {
+                                           JUCEApplication::getInstance()->setApplicationReturnValue (1);
+                                           JUCEApplication::getInstance()->systemRequestedQuit();
+                                       };
+
+                                       if (! processorGraph->allFileReadersLoaded())
+                                       {
+                                           LOGE ("Offline processing needs a File Reader with a file it can open.");
+                                           quitWithError();
+                                           return;
+                                       }
+
+                                       LOGC ("Starting offline processing.");
+
+                                       if (processorGraph->hasRecordNode())
+                                           controlPanel->setRecordingState (true, true);
+                                       else
+                                           controlPanel->setAcquisitionState (true);
+
+                                       if (! CoreServices::getAcquisitionStatus())
+                                       {
+                                           LOGE ("Offline processing could not start acquisition.");
+                                           quitWithError();
+                                       } });
+    }
 }
 
 MainWindow::~MainWindow()
@@ -275,10 +318,13 @@ MainWindow::~MainWindow()
 #endif
     }
 
-    File lastConfig = configsDir.getChildFile ("lastConfig.xml");
-    File recoveryConfig = configsDir.getChildFile ("recoveryConfig.xml");
-    saveProcessorGraph (lastConfig);
-    saveProcessorGraph (recoveryConfig);
+    if (! isOffline)
+    {
+        File lastConfig = configsDir.getChildFile ("lastConfig.xml");
+        File recoveryConfig = configsDir.getChildFile ("recoveryConfig.xml");
+        saveProcessorGraph (lastConfig);
+        saveProcessorGraph (recoveryConfig);
+    }
 
     if (http_server_thread)
     {
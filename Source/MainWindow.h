@@ -72,8 +72,10 @@ class MainWindow
 {
 public:
     /** Initializes the MainWindow, creates the AudioComponent, ProcessorGraph,
-        and UIComponent, and sets the window boundaries. */
-    MainWindow (const File& fileToLoad = File(), bool isConsoleApp = false);
+        and UIComponent, and sets the window boundaries. In offline mode, the
+        signal chain in fileToLoad is processed once, as fast as possible, and
+        the application quits when every File Reader reaches the end of its file. */
+    MainWindow (const File& fileToLoad = File(), bool isConsoleApp = false, bool isOffline = false);
 
     /** Destroys the AudioComponent, ProcessorGraph, and UIComponent, and saves the window boundaries. */
     ~MainWindow();
@@ -160,6 +162,9 @@ private:
     /** Set to true if the application is running in console mode */
     bool isConsoleApp;
 
+    /** Set to true if the signal chain is driven by the offline device instead of a sound card */
+    bool isOffline;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
 };
 
@@ -23,13 +23,16 @@
 
 #include "AudioMonitor.h"
 #include "AudioMonitorEditor.h"
+#include "../../AccessClass.h"
+#include "../../Audio/AudioComponent.h"
 #include <stdio.h>
 
 AudioMonitorSettings::AudioMonitorSettings()
     : numChannels (0),
       sampleRate (0),
       destBufferSampleRate (44100.0f),
-      estimatedSamples (1024)
+      estimatedSamples (1024),
+      isMonitored (false)
 {
 }
 
@@ -38,75 +41,44 @@ void AudioMonitorSettings::createFilters (int nChans, float sampleRate_)
     numChannels = nChans;
     sampleRate = sampleRate_;
 
-    bandpassfilters.clear();
-    antialiasingfilters.clear();
-
     Dsp::Params bandpassParams;
     bandpassParams[0] = sampleRate; // sample rate
     bandpassParams[1] = 2; // order
     bandpassParams[2] = (7000 + 100) / 2; // center frequency
     bandpassParams[3] = 7000 - 100; // bandwidth
 
-    for (int n = 0; n < numChannels; ++n)
-    {
-        bandpassfilters.add (new Dsp::SmoothedFilterDesign<Dsp::Butterworth::Design::BandPass // design type
-                                                           <2>, // order
-                                                           1, // number of channels (must be const)
-                                                           Dsp::DirectFormII> (1)); // realization
-
-        bandpassfilters.getLast()->setParams (bandpassParams);
-
-        antialiasingfilters.add (new Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 1> (1024));
-    }
-
-    updateAntiAliasingFilterParameters();
-}
+    // the filter is linear, so filtering the mix is the same as mixing the filtered channels
+    bandpassFilter = std::make_unique<Dsp::SmoothedFilterDesign<Dsp::Butterworth::Design::BandPass // design type
+                                                                <2>, // order
+                                                                1, // number of channels (must be const)
+                                                                Dsp::DirectFormII>> (1); // realization
 
-void AudioMonitorSettings::updateAntiAliasingFilterParameters()
-{
-    Dsp::Params antialiasingParams;
-    antialiasingParams[0] = destBufferSampleRate; // sample rate
-    antialiasingParams[1] = destBufferSampleRate / 2; // cutoff frequency
-    antialiasingParams[2] = 1.25; //Q //
+    bandpassFilter->setParams (bandpassParams);
 
-    for (int i = 0; i < numChannels; ++i)
-    {
-        antialiasingfilters[i]->setParams (antialiasingParams);
-    }
+    prepareResampler();
 }
 
-void AudioMonitorSettings::setOutputSampleRate (double outputSampleRate, double estimatedSamplesPerBlock)
+void AudioMonitorSettings::setOutputSampleRate (double outputSampleRate, int estimatedSamplesPerBlock)
 {
     destBufferSampleRate = outputSampleRate;
     estimatedSamples = estimatedSamplesPerBlock;
 
-    numSamplesExpected = (sampleRate / destBufferSampleRate) * estimatedSamples;
-    ratio = sampleRate / destBufferSampleRate;
-
-    samplesInBackupBuffer.clear();
-    samplesInOverflowBuffer.clear();
-
-    bufferA.clear();
-    bufferB.clear();
-    bufferSwap.clear();
+    prepareResampler();
+}
 
-    for (int i = 0; i < numChannels; i++)
-    {
-        samplesInBackupBuffer.emplace (i, 0.0f);
-        samplesInOverflowBuffer.emplace (i, 0.0f);
+void AudioMonitorSettings::prepareResampler()
+{
+    if (sampleRate <= 0)
+        return;
 
-        bufferA.emplace (i, std::make_unique<AudioBuffer<float>> (1, (int) destBufferSampleRate));
-        bufferB.emplace (i, std::make_unique<AudioBuffer<float>> (1, (int) destBufferSampleRate));
-        bufferSwap.emplace (i, false);
-    }
+    const int maxInputSamples = 2 * jmax (estimatedSamples, (int) std::ceil (estimatedSamples * sampleRate / destBufferSampleRate));
 
-    updateAntiAliasingFilterParameters();
+    resampler.prepare (sampleRate, destBufferSampleRate, maxInputSamples, estimatedSamples);
 }
 
 AudioMonitor::AudioMonitor()
     : GenericProcessor ("Audio Monitor")
 {
-    tempBuffer = std::make_unique<AudioSampleBuffer> (1, 4096);
 }
 
 void AudioMonitor::registerParameters()
@@ -126,6 +98,24 @@ void AudioMonitor::registerParameters()
         { "LEFT", "BOTH", "RIGHT" },
         1);
 
+    addBooleanParameter (
+        Parameter::PROCESSOR_SCOPE,
+        "low_latency",
+        "Low latency",
+        "Play audio through a separate output stream with a small buffer, independent of the acquisition buffer size",
+        false,
+        true);
+
+    addIntParameter (
+        Parameter::PROCESSOR_SCOPE,
+        "monitor_buffer_size",
+        "Monitor buffer size",
+        "Buffer size (in samples) of the low-latency output stream",
+        64,
+        16,
+        1024,
+        true);
+
     addSelectedChannelsParameter (
         Parameter::STREAM_SCOPE,
         "channels",
@@ -187,10 +177,48 @@ void AudioMonitor::updatePlaybackBuffer()
 
 void AudioMonitor::prepareToPlay (double sampleRate_, int estimatedSamplesPerBlock)
 {
+    // in low-latency mode, audio is resampled to the monitor device's rate instead
+    const double outputSampleRate = monitorOutput.isOpen() ? monitorOutput.getSampleRate() : sampleRate_;
+
+    int maxOutputSamples = 0;
+
     for (auto stream : dataStreams)
     {
-        settings[stream->getStreamId()]->setOutputSampleRate (sampleRate_, estimatedSamplesPerBlock);
+        settings[stream->getStreamId()]->setOutputSampleRate (outputSampleRate, estimatedSamplesPerBlock);
+
+        maxOutputSamples = jmax (maxOutputSamples, settings[stream->getStreamId()]->resampler.getMaxOutputSamples());
     }
+
+    monitorBuffer.setSize (1, jmax (1, maxOutputSamples));
+}
+
+bool AudioMonitor::startAcquisition()
+{
+    AudioComponent* audio = AccessClass::getAudioComponent();
+
+    if (! getParameter ("low_latency")->getValue() || audio == nullptr || audio->isOffline())
+        return true;
+
+    String error = monitorOutput.open (audio->getDeviceType(),
+                                       audio->getDeviceName(),
+                                       (int) getParameter ("monitor_buffer_size")->getValue());
+
+    if (error.isNotEmpty())
+        LOGE ("Could not open low-latency monitor output (", error, "); monitoring through the main audio device");
+
+    return true;
+}
+
+bool AudioMonitor::stopAcquisition()
+{
+    if (monitorOutput.isOpen())
+    {
+        LOGC ("Monitor output underruns: ", monitorOutput.getNumUnderruns(), ", latency: ", monitorOutput.getLatencyMs(), " ms");
+
+        monitorOutput.close();
+    }
+
+    return true;
 }
 
 void AudioMonitor::parameterValueChanged (Parameter* param)
@@ -300,253 +328,84 @@ void AudioMonitor::process (AudioBuffer<float>& buffer)
     buffer.clear (totalBufferChannels - 2, 0, buffer.getNumSamples());
     buffer.clear (totalBufferChannels - 1, 0, buffer.getNumSamples());
 
-    if (! getParameter ("mute_audio")->getValue())
-    {
-        for (auto stream : dataStreams)
-        {
-            if (stream->getStreamId() == selectedStream)
-            {
-                auto streamSettings = settings[selectedStream];
-                AudioSampleBuffer* overflowBuffer;
-                AudioSampleBuffer* backupBuffer;
-
-                Array<var>* activeChannels = stream->getParameter ("channels")->getValue().getArray();
-
-                for (int i = 0; i < activeChannels->size(); i++)
-                {
-                    int localIndex = (int) activeChannels->getReference (i);
-
-                    int globalIndex = getDataStream (selectedStream)->getContinuousChannels()[localIndex]->getGlobalIndex();
-
-                    tempBuffer->clear();
-
-                    if (! streamSettings->bufferSwap[localIndex])
-                    {
-                        overflowBuffer = streamSettings->bufferA[localIndex].get();
-                        backupBuffer = streamSettings->bufferB[localIndex].get();
-
-                        streamSettings->bufferSwap[localIndex] = true;
-                    }
-                    else
-                    {
-                        overflowBuffer = streamSettings->bufferB[localIndex].get();
-                        backupBuffer = streamSettings->bufferA[localIndex].get();
-
-                        streamSettings->bufferSwap[localIndex] = false;
-                    }
-
-                    backupBuffer->clear();
-
-                    streamSettings->samplesInOverflowBuffer[localIndex] = streamSettings->samplesInBackupBuffer[localIndex]; // size of buffer after last round
-                    streamSettings->samplesInBackupBuffer[localIndex] = 0;
-
-                    double orphanedSamples = 0;
-
-                    // 1. copy overflow buffer
-
-                    double samplesToCopyFromOverflowBuffer =
-                        ((streamSettings->samplesInOverflowBuffer[localIndex] <= streamSettings->numSamplesExpected)
-                             ? streamSettings->samplesInOverflowBuffer[localIndex]
-                             : streamSettings->numSamplesExpected);
-
-                    // LOGD("Number of samples to copy: ", samplesToCopyFromOverflowBuffer);
+    const bool muted = getParameter ("mute_audio")->getValue();
 
-                    //std::cout << "Copying from overflow buffer: " << samplesToCopyFromOverflowBuffer << std::endl;
-
-                    if (samplesToCopyFromOverflowBuffer > 0) // need to re-add samples from backup buffer
-                    {
-                        tempBuffer->addFrom (0, // destination channel
-                                             0, // destination start sample
-                                             *overflowBuffer, // source
-                                             0, // source channel
-                                             0, // source start sample
-                                             (int) samplesToCopyFromOverflowBuffer, // number of samples
-                                             1.0f // gain to apply
-                        );
-
-                        double leftoverSamples = streamSettings->samplesInOverflowBuffer[localIndex] - samplesToCopyFromOverflowBuffer;
-
-                        //std::cout << "Copying to backup buffer: " << leftoverSamples << std::endl;
-
-                        if (leftoverSamples > 0) // move remaining samples to the backup buffer
-                        {
-                            backupBuffer->addFrom (0, // destination channel
-                                                   0, // destination start sample
-                                                   *overflowBuffer, // source
-                                                   0, // source channel
-                                                   (int) samplesToCopyFromOverflowBuffer, // source start sample
-                                                   (int) leftoverSamples, // number of samples
-                                                   1.0f // gain to apply
-                            );
-                        }
-
-                        streamSettings->samplesInBackupBuffer[localIndex] = leftoverSamples;
-                    }
-
-                    double remainingSamples = double (streamSettings->numSamplesExpected) - samplesToCopyFromOverflowBuffer;
-
-                    double samplesAvailable = double (getNumSamplesInBlock (selectedStream));
-
-                    //std::cout << "Remaining samples: " << remainingSamples << std::endl;
-                    //std::cout << "Samples available: " << samplesAvailable << std::endl;
-
-                    double samplesToCopyFromIncomingBuffer =
-                        ((remainingSamples <= samplesAvailable) ? remainingSamples : samplesAvailable);
-
-                    //std::cout << "Copying from incoming buffer: " << samplesToCopyFromIncomingBuffer << std::endl;
-
-                    if (samplesToCopyFromIncomingBuffer > 0)
-                    {
-                        tempBuffer->addFrom (0, // destination channel
-                                             (int) samplesToCopyFromOverflowBuffer, // destination start sample
-                                             buffer, // source
-                                             globalIndex, // source channel
-                                             0, // source start sample
-                                             (int) samplesToCopyFromIncomingBuffer, //  number of samples
-                                             1.0f // gain to apply
-                        );
-                    }
-
-                    orphanedSamples = samplesAvailable - samplesToCopyFromIncomingBuffer;
-
-                    //std::cout << "Orphaned samples: " << orphanedSamples << std::endl;
+    for (auto stream : dataStreams)
+    {
+        auto streamSettings = settings[stream->getStreamId()];
 
-                    if (orphanedSamples > 0
-                        && (streamSettings->samplesInBackupBuffer[localIndex] + orphanedSamples < backupBuffer->getNumSamples()))
-                    {
-                        backupBuffer->addFrom (0, // destination channel
-                                               streamSettings->samplesInBackupBuffer[localIndex], // destination start sample
-                                               buffer, // source
-                                               globalIndex, // source channel
-                                               (int) remainingSamples, // source start sample
-                                               (int) orphanedSamples, //  number of samples
-                                               1.0f // gain to apply
-                        );
-
-                        streamSettings->samplesInBackupBuffer[localIndex] += orphanedSamples;
-                    }
+        if (muted || stream->getStreamId() != selectedStream)
+        {
+            streamSettings->isMonitored = false;
+            continue;
+        }
 
-                    //std::cout << "Total copied: " << samplesToCopyFromOverflowBuffer + samplesToCopyFromIncomingBuffer << std::endl;
+        // don't play input left over from the last time this stream was monitored
+        if (! streamSettings->isMonitored)
+        {
+            streamSettings->resampler.reset();
+            streamSettings->isMonitored = true;
+        }
 
-                    // now that our tempBuffer is ready, we can filter it and copy it into the
-                    // original buffer
-                    float* ptr = tempBuffer->getWritePointer (0);
+        int targetChannel;
 
-                    int totalCopied = int (samplesToCopyFromOverflowBuffer + samplesToCopyFromIncomingBuffer);
+        if (int (getParameter ("audio_output")->getValue()) == 0 || int (getParameter ("audio_output")->getValue()) == 1)
+            targetChannel = totalBufferChannels - 2;
+        else
+            targetChannel = totalBufferChannels - 1;
 
-                    if (totalCopied == 0)
-                        continue;
+        const int numSamples = jmin ((int) getNumSamplesInBlock (selectedStream), buffer.getNumSamples());
 
-                    streamSettings->bandpassfilters[localIndex]->process (totalCopied, &ptr);
+        // 1. mix the selected channels directly into the resampler's input
+        float* mix = streamSettings->resampler.getInputWritePointer (numSamples);
 
-                    /*if (i == 0)
-                    {
-                        std::cout << "np.array([";
-                        for (int j = 0; j < totalCopied; j++)
-                        {
-                            std::cout << *(tempBuffer->getReadPointer(0, j)) << ", ";
-                        }
-                        
-                        std::cout << "])";
-                        std::cout << std::endl;
-                        std::cout << "------------- " << std::endl;
-                    }*/
-
-                    // initialize variables
-                    int sourceBufferPos = 0;
-                    int sourceBufferSize = totalCopied;
-                    double subSampleOffset = 0.0;
-                    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-                    double destBufferPos;
-                    int targetChannel;
-
-                    //std::cout << "Ratio: " << ratio[globalIndex] << std::endl;
-
-                    if (int (getParameter ("audio_output")->getValue()) == 0 || int (getParameter ("audio_output")->getValue()) == 1)
-                        targetChannel = totalBufferChannels - 2;
-                    else
-                        targetChannel = totalBufferChannels - 1;
-
-                    // code modified from "juce_ResamplingAudioSource.cpp":
-                    for (destBufferPos = 0; destBufferPos < valuesNeeded; destBufferPos++)
-                    {
-                        float alpha = (float) subSampleOffset;
-                        float invAlpha = 1.0f - alpha;
-
-                        buffer.addFrom (targetChannel, // destChannel
-                                        destBufferPos, // destSampleOffset
-                                        *tempBuffer, // source
-                                        0, // sourceChannel
-                                        sourceBufferPos, // sourceSampleOffset
-                                        1, // number of samples
-                                        invAlpha); // gain to apply to source
-
-                        buffer.addFrom (targetChannel, // destChannel
-                                        destBufferPos, // destSampleOffset
-                                        *tempBuffer, // source
-                                        0, // sourceChannel
-                                        nextPos, // sourceSampleOffset
-                                        1, // number of samples
-                                        alpha); // gain to apply to source
-
-                        subSampleOffset += streamSettings->ratio;
-
-                        while (subSampleOffset >= 1.0)
-                        {
-                            //if (++sourceBufferPos >= sourceBufferSize)
-                            //    sourceBufferPos = 0;
+        Array<var>* activeChannels = stream->getParameter ("channels")->getValue().getArray();
 
-                            ++sourceBufferPos;
-                            nextPos = (sourceBufferPos + 1); //% sourceBufferSize;
+        for (int i = 0; i < activeChannels->size(); i++)
+        {
+            int localIndex = (int) activeChannels->getReference (i);
 
-                            if (nextPos >= sourceBufferSize)
-                                nextPos = sourceBufferPos;
+            int globalIndex = stream->getContinuousChannels()[localIndex]->getGlobalIndex();
 
-                            subSampleOffset -= 1.0;
-                        }
-                    }
+            FloatVectorOperations::add (mix, buffer.getReadPointer (globalIndex), numSamples);
+        }
 
-                    //std::cout << "Source buffer pos: " << sourceBufferPos << std::endl;
+        // 2. filter the mix once
+        if (numSamples > 0)
+            streamSettings->bandpassFilter->process (numSamples, &mix);
 
-                    //std::cout << "After upsampling: " << valuesNeeded << std::endl;
+        streamSettings->resampler.finishedInput (numSamples);
 
-                    //std::cout << std::endl;
+        const int audioOutput = int (getParameter ("audio_output")->getValue());
 
-                    //ptr = buffer.getWritePointer(targetChannel);
-                    //antialiasingfilters[i]->process(destBufferPos, &ptr);
+        // 3. resample to the output rate, with built-in anti-aliasing
+        if (monitorOutput.isOpen())
+        {
+            // low-latency mode: hand everything available to the monitor output's jitter buffer
+            monitorBuffer.clear();
 
-                    /*if (i == 0)
-                    {
-                        std::cout << "np.array([";
-                        for (int j = 0; j < valuesNeeded; j++)
-                        {
-                            std::cout << *(buffer.getReadPointer(targetChannel, j)) << ", ";
-                        }
-                        
-                        std::cout << "])";
-                        std::cout << std::endl;
-                        std::cout << "------------- " << std::endl;
-                    }*/
+            const int numResampled = streamSettings->resampler.addAvailableOutput (monitorBuffer.getWritePointer (0),
+                                                                                   monitorBuffer.getNumSamples());
 
-                } // end cycling through channels
+            monitorOutput.write (monitorBuffer.getReadPointer (0), numResampled, audioOutput != 2, audioOutput != 0);
 
-                if (int (getParameter ("audio_output")->getValue()) == 1)
-                {
-                    // copy the signal into the right channel
-                    buffer.addFrom (totalBufferChannels - 1, // destChannel
-                                    0, // destSampleOffset
-                                    buffer, // source
-                                    totalBufferChannels - 2, // sourceChannel
-                                    0, // sourceSampleOffset
-                                    valuesNeeded, // number of samples
-                                    1.0); // gain to apply to source
-                }
+            continue;
+        }
 
-            } // stream is selected
+        streamSettings->resampler.addOutput (buffer.getWritePointer (targetChannel), valuesNeeded);
 
-        } // loop through streams
+        if (audioOutput == 1)
+        {
+            // copy the signal into the right channel
+            buffer.addFrom (totalBufferChannels - 1, // destChannel
+                            0, // destSampleOffset
+                            buffer, // source
+                            totalBufferChannels - 2, // sourceChannel
+                            0, // sourceSampleOffset
+                            valuesNeeded, // number of samples
+                            1.0); // gain to apply to source
+        }
 
-    } // not muted
+    } // loop through streams
 
 } // process
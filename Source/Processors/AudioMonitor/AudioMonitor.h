@@ -28,9 +28,11 @@
 
 #include "../Dsp/Dsp.h"
 #include "../GenericProcessor/GenericProcessor.h"
+#include "../../Audio/MonitorOutput.h"
+#include "PolyphaseResampler.h"
 
 /**
-  Creates and holds the filter settings for one input stream in the AudioMonitor.
+  Creates and holds the filter and resampler for one input stream in the AudioMonitor.
 */
 class AudioMonitorSettings
 {
@@ -40,31 +42,26 @@ public:
     int numChannels;
     float sampleRate;
     double destBufferSampleRate;
-    double estimatedSamples;
+    int estimatedSamples;
 
-    /** Bandpass filters (1 per channel)*/
-    OwnedArray<Dsp::Filter> bandpassfilters;
+    /** Bandpass filter, applied to the mix of the selected channels */
+    std::unique_ptr<Dsp::Filter> bandpassFilter;
 
-    /** Antialiasing filters (1 per channel)*/
-    OwnedArray<Dsp::Filter> antialiasingfilters;
-    std::map<int, std::unique_ptr<AudioBuffer<float>>> bufferA;
-    std::map<int, std::unique_ptr<AudioBuffer<float>>> bufferB;
+    /** Converts the filtered mix to the output sample rate */
+    PolyphaseResampler resampler;
 
-    /** Per-channel buffer state information*/
-    std::map<int, double> samplesInBackupBuffer;
-    std::map<int, double> samplesInOverflowBuffer;
-    std::map<int, bool> bufferSwap;
-    double numSamplesExpected;
-    double ratio;
+    /** True if this stream was monitored in the previous block */
+    bool isMonitored;
 
-    /** Creates new filters when input settings change*/
+    /** Creates a new filter and resampler when input settings change*/
     void createFilters (int numChannels, float sampleRate);
 
-    /** Updates filters when parameters change*/
-    void updateAntiAliasingFilterParameters();
+    /** Re-sets the resampler prior to starting acquisition*/
+    void setOutputSampleRate (double outputSampleRate, int estimatedSamplesPerBlock);
 
-    /** Re-sets the copy buffers prior to starting acquisition*/
-    void setOutputSampleRate (double outputSampleRate, double estimatedSamplesPerBlock);
+private:
+    /** Designs the resampler for the current input and output sample rates */
+    void prepareResampler();
 };
 
 /**
@@ -84,7 +81,7 @@ public:
     /** Add and register parameters*/
     void registerParameters() override;
 
-    /** Re-samples, filters, and copies selected channels*/
+    /** Mixes, filters, and re-samples the selected channels*/
     void process (AudioBuffer<float>& buffer) override;
 
     /** Creates the custom UI for the AudioMonitor*/
@@ -96,9 +93,15 @@ public:
     /** Updates the audio buffer size*/
     void updatePlaybackBuffer();
 
-    /** Updates the resampling ratio for each channel*/
+    /** Updates the resampling ratio for each stream*/
     void prepareToPlay (double sampleRate_, int estimatedSamplesPerBlock) override;
 
+    /** Opens the low-latency monitor output, if it is enabled*/
+    bool startAcquisition() override;
+
+    /** Closes the low-latency monitor output*/
+    bool stopAcquisition() override;
+
     /** Called whenever a parameter's value is changed (called by GenericProcessor::setParameter())*/
     void parameterValueChanged (Parameter* param) override;
 
@@ -115,12 +118,15 @@ private:
     /** AudioMonitor settings for each input stream*/
     StreamSettings<AudioMonitorSettings> settings;
 
-    /** Holds the data for one channel, before it's copied to the output*/
-    std::unique_ptr<AudioBuffer<float>> tempBuffer;
-
     /** Only one stream can be monitored at a time*/
     uint16 selectedStream;
 
+    /** Small-buffer output stream used in low-latency mode*/
+    MonitorOutput monitorOutput;
+
+    /** Holds resampled audio on its way to the monitor output*/
+    AudioBuffer<float> monitorBuffer;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioMonitor);
 };
 
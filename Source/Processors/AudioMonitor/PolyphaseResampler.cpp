@@ -0,0 +1,258 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PolyphaseResampler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RESAMPLER_USE_SSE2 1
+#else
+#define RESAMPLER_USE_SSE2 0
+#endif
+
+/** Zeroth-order modified Bessel function of the first kind, for the Kaiser window */
+static double besselI0 (double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 32; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+
+        if (term < sum * 1e-12)
+            break;
+    }
+
+    return sum;
+}
+
+/** Computes the dot products of x with two adjacent branches at once, sharing the loads of x;
+    n must be a multiple of 4 */
+static void dotProducts (const float* x, const float* h0, const float* h1, int n, float& out0, float& out1)
+{
+#if RESAMPLER_USE_SSE2
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+
+    for (int i = 0; i < n; i += 4)
+    {
+        const __m128 samples = _mm_loadu_ps (x + i);
+        sum0 = _mm_add_ps (sum0, _mm_mul_ps (samples, _mm_loadu_ps (h0 + i)));
+        sum1 = _mm_add_ps (sum1, _mm_mul_ps (samples, _mm_loadu_ps (h1 + i)));
+    }
+
+    float lanes0[4], lanes1[4];
+    _mm_storeu_ps (lanes0, sum0);
+    _mm_storeu_ps (lanes1, sum1);
+
+    out0 = (lanes0[0] + lanes0[1]) + (lanes0[2] + lanes0[3]);
+    out1 = (lanes1[0] + lanes1[1]) + (lanes1[2] + lanes1[3]);
+#else
+    float sum0 = 0.0f;
+    float sum1 = 0.0f;
+
+    for (int i = 0; i < n; i++)
+    {
+        sum0 += x[i] * h0[i];
+        sum1 += x[i] * h1[i];
+    }
+
+    out0 = sum0;
+    out1 = sum1;
+#endif
+}
+
+PolyphaseResampler::PolyphaseResampler()
+    : step (1.0),
+      numTaps (RESAMPLER_MIN_TAPS),
+      readIndex (0),
+      readFraction (0.0),
+      writeIndex (0),
+      primeSamples (0),
+      maxBufferedSamples (0),
+      maxInputSamples (0),
+      primed (false)
+{
+}
+
+void PolyphaseResampler::prepare (double inputSampleRate, double outputSampleRate, int maxInputSamples_, int outputBlockSize)
+{
+    step = inputSampleRate / outputSampleRate;
+
+    // when decimating, the cutoff falls below the input Nyquist frequency and the kernel widens to match
+    const double cutoffScale = jmin (1.0, outputSampleRate / inputSampleRate);
+    const double cutoff = 0.45 * cutoffScale; // cycles per input sample
+
+    numTaps = jlimit (RESAMPLER_MIN_TAPS, RESAMPLER_MAX_TAPS, (int) std::ceil (RESAMPLER_MIN_TAPS / cutoffScale));
+    numTaps = (numTaps + 3) & ~3;
+
+    const int halfTaps = numTaps / 2;
+    const double beta = 6.0; // ~60 dB stopband
+    const double windowNorm = besselI0 (beta);
+
+    coefficients.assign ((RESAMPLER_NUM_PHASES + 1) * numTaps, 0.0f);
+
+    for (int phase = 0; phase <= RESAMPLER_NUM_PHASES; phase++)
+    {
+        const double fraction = double (phase) / RESAMPLER_NUM_PHASES;
+        float* branch = coefficients.data() + phase * numTaps;
+        double sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; tap++)
+        {
+            const double t = double (tap - halfTaps + 1) - fraction; // in input samples
+            const double x = t / halfTaps;
+            const double window = besselI0 (beta * std::sqrt (jmax (0.0, 1.0 - x * x))) / windowNorm;
+            const double arg = 2.0 * cutoff * t;
+            const double sinc = (std::abs (arg) < 1e-9) ? 1.0 : std::sin (MathConstants<double>::pi * arg) / (MathConstants<double>::pi * arg);
+            const double h = 2.0 * cutoff * sinc * window;
+
+            branch[tap] = (float) h;
+            sum += h;
+        }
+
+        // unity gain at DC for every branch, so a constant input stays constant
+        for (int tap = 0; tap < numTaps; tap++)
+            branch[tap] = (float) (branch[tap] / sum);
+    }
+
+    const int inputPerBlock = (int) std::ceil (outputBlockSize * step);
+
+    maxInputSamples = maxInputSamples_;
+    primeSamples = inputPerBlock + halfTaps;
+    maxBufferedSamples = 4 * inputPerBlock + numTaps;
+
+    fifo.assign (numTaps + maxBufferedSamples + maxInputSamples, 0.0f);
+
+    reset();
+}
+
+void PolyphaseResampler::reset()
+{
+    std::fill (fifo.begin(), fifo.end(), 0.0f);
+
+    // zero history before the first sample, so the first output is aligned with it
+    readIndex = numTaps / 2 - 1;
+    writeIndex = readIndex;
+    readFraction = 0.0;
+    primed = false;
+}
+
+void PolyphaseResampler::compact()
+{
+    const int keepFrom = readIndex - (numTaps / 2 - 1);
+
+    if (keepFrom <= 0)
+        return;
+
+    std::memmove (fifo.data(), fifo.data() + keepFrom, sizeof (float) * (writeIndex - keepFrom));
+
+    readIndex -= keepFrom;
+    writeIndex -= keepFrom;
+}
+
+float* PolyphaseResampler::getInputWritePointer (int numSamples)
+{
+    jassert (numSamples <= maxInputSamples);
+
+    if (writeIndex + numSamples > (int) fifo.size())
+        compact();
+
+    FloatVectorOperations::clear (fifo.data() + writeIndex, numSamples);
+
+    return fifo.data() + writeIndex;
+}
+
+void PolyphaseResampler::finishedInput (int numSamples)
+{
+    writeIndex += numSamples;
+
+    // skip the oldest input, rather than let the latency grow
+    if (writeIndex - readIndex > maxBufferedSamples)
+        readIndex = writeIndex - primeSamples;
+}
+
+int PolyphaseResampler::addOutput (float* dest, int numSamples)
+{
+    if (! primed)
+    {
+        if (writeIndex - readIndex < primeSamples)
+            return 0;
+
+        primed = true;
+    }
+
+    const int numProduced = render (dest, numSamples);
+
+    if (numProduced < numSamples)
+        primed = false;
+
+    return numProduced;
+}
+
+int PolyphaseResampler::addAvailableOutput (float* dest, int maxSamples)
+{
+    return render (dest, maxSamples);
+}
+
+int PolyphaseResampler::render (float* dest, int numSamples)
+{
+    const int halfTaps = numTaps / 2;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        if (readIndex + halfTaps >= writeIndex)
+            return i;
+
+        const double position = readFraction * RESAMPLER_NUM_PHASES;
+        const int phase = (int) position;
+        const float blend = (float) (position - phase);
+
+        const float* branch = coefficients.data() + phase * numTaps;
+        float out0, out1;
+
+        dotProducts (fifo.data() + readIndex - halfTaps + 1, branch, branch + numTaps, numTaps, out0, out1);
+
+        dest[i] += out0 + blend * (out1 - out0);
+
+        readFraction += step;
+
+        const int whole = (int) readFraction;
+        readIndex += whole;
+        readFraction -= whole;
+    }
+
+    return numSamples;
+}
+
+int PolyphaseResampler::getMaxOutputSamples() const
+{
+    return (int) std::ceil (fifo.size() / step) + 1;
+}
+
+int PolyphaseResampler::getNumBufferedSamples() const
+{
+    return writeIndex - readIndex;
+}
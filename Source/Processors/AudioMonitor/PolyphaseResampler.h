@@ -0,0 +1,128 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __POLYPHASERESAMPLER_H__
+#define __POLYPHASERESAMPLER_H__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+#include "../../TestableExport.h"
+
+#include <vector>
+
+#define RESAMPLER_NUM_PHASES 128
+#define RESAMPLER_MIN_TAPS 32
+#define RESAMPLER_MAX_TAPS 256
+
+/**
+    Converts one mono signal from a data stream's sample rate to the
+    sound card's sample rate, for the Audio Monitor.
+
+    The anti-aliasing filter is built into the resampler: a windowed-sinc
+    lowpass, cut off below the lower of the two Nyquist frequencies, is
+    split into RESAMPLER_NUM_PHASES polyphase branches, and each output
+    sample blends the two branches nearest to its fractional input position.
+
+    Input is appended to a FIFO of fixed size, allocated in prepare(), so
+    the processing thread never allocates. If the input runs ahead of the
+    output (e.g., because the acquisition and sound card clocks differ),
+    the oldest input is skipped to bound the latency; if it runs behind,
+    the remainder of the output block is silent until the FIFO refills.
+
+    @see AudioMonitor
+*/
+class TESTABLE PolyphaseResampler
+{
+public:
+    /** Constructor */
+    PolyphaseResampler();
+
+    /** Designs the filter bank and allocates the FIFO; not real-time safe */
+    void prepare (double inputSampleRate, double outputSampleRate, int maxInputSamples, int outputBlockSize);
+
+    /** Discards all buffered input */
+    void reset();
+
+    /** Returns space for numSamples new input samples, cleared to zero, so callers
+        can mix channels directly into the FIFO; follow with finishedInput() */
+    float* getInputWritePointer (int numSamples);
+
+    /** Appends the numSamples input samples written since getInputWritePointer() */
+    void finishedInput (int numSamples);
+
+    /** Adds numSamples resampled output samples to dest; returns the number
+        produced before the FIFO ran out of input */
+    int addOutput (float* dest, int numSamples);
+
+    /** Adds as many resampled output samples as the buffered input allows (up to
+        maxSamples) to dest, without waiting for the FIFO to fill; returns the number
+        produced. Used when a downstream jitter buffer takes care of timing. */
+    int addAvailableOutput (float* dest, int maxSamples);
+
+    /** Returns the most output samples the FIFO's contents can produce at once */
+    int getMaxOutputSamples() const;
+
+    /** Returns the number of input samples waiting to be resampled */
+    int getNumBufferedSamples() const;
+
+    /** Returns the number of taps in each polyphase branch */
+    int getNumTaps() const { return numTaps; }
+
+private:
+    /** Moves the live part of the FIFO to its start */
+    void compact();
+
+    /** Adds output samples until numSamples or the buffered input runs out */
+    int render (float* dest, int numSamples);
+
+    /** Input samples per output sample */
+    double step;
+
+    /** Taps per branch (a multiple of 4) */
+    int numTaps;
+
+    /** (RESAMPLER_NUM_PHASES + 1) branches of numTaps coefficients */
+    std::vector<float> coefficients;
+
+    /** Input FIFO; the current output sample lies between input
+        samples readIndex and readIndex + 1 */
+    std::vector<float> fifo;
+    int readIndex;
+    double readFraction;
+    int writeIndex;
+
+    /** Input buffered before output starts (or restarts after running dry) */
+    int primeSamples;
+
+    /** Most input allowed to wait in the FIFO before it is skipped */
+    int maxBufferedSamples;
+
+    /** Largest block that can be appended at once */
+    int maxInputSamples;
+
+    bool primed;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler);
+};
+
+#endif // __POLYPHASERESAMPLER_H__
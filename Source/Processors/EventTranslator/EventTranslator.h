@@ -43,6 +43,9 @@ public:
     TTLEventPtr createEvent (int64 sample_number, double timestamp, int line, bool state);
 
     EventChannel* eventChannel;
+
+    /** The stream's handle in the synchronizer */
+    int syncHandle;
 };
 
 /**
@@ -78,6 +78,56 @@ const float* Spike::getDataPointer (int channel) const
     return (m_data.getData() + (channel * spikeChannel->getTotalSamples()));
 }
 
+int Spike::computeFeatures (const SpikeChannel* channelInfo, const float* data, float* peakAmplitudes)
+{
+    const int numChannels = channelInfo->getNumChannels();
+    const int numSamples = channelInfo->getTotalSamples();
+
+    int widestChannel = 0;
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const float* channelData = data + ch * numSamples;
+        float peak = 0.0f;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            if (std::abs (channelData[i]) > std::abs (peak))
+                peak = channelData[i];
+        }
+
+        peakAmplitudes[ch] = peak;
+
+        if (std::abs (peak) > std::abs (peakAmplitudes[widestChannel]))
+            widestChannel = ch;
+    }
+
+    const float* channelData = data + widestChannel * numSamples;
+
+    int trough = 0;
+
+    for (int i = 1; i < numSamples; i++)
+    {
+        if (channelData[i] < channelData[trough])
+            trough = i;
+    }
+
+    int peak = trough;
+
+    for (int i = trough + 1; i < numSamples; i++)
+    {
+        if (channelData[i] > channelData[peak])
+            peak = i;
+    }
+
+    return peak - trough;
+}
+
+int Spike::computeFeatures (float* peakAmplitudes) const
+{
+    return computeFeatures (spikeChannel, m_data.getData(), peakAmplitudes);
+}
+
 float Spike::getThreshold (int chan) const
 {
     return m_thresholds[chan];
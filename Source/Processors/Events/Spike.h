@@ -143,6 +143,14 @@ public:
     /* Get the sorted ID for this spike*/
     uint16 getSortedId() const;
 
+    /* Compute compact features of a spike waveform (e.g. from a Spike::Buffer at detection time).
+       Writes the largest-magnitude sample of each channel to peakAmplitudes and returns the number of
+       samples from the trough to the following peak on the channel with the largest amplitude. */
+    static int computeFeatures (const SpikeChannel* channelInfo, const float* data, float* peakAmplitudes);
+
+    /* Compute the features of this spike's waveform*/
+    int computeFeatures (float* peakAmplitudes) const;
+
     /* Create a Spike object*/
     static SpikePtr createSpike (const SpikeChannel* channelInfo,
                                  int64 sampleNumber,
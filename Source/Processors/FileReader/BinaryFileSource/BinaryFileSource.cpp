@@ -21,8 +21,26 @@
 
 */
 
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "BinaryFileSource.h"
 
+#include <numeric>
+
+#include "../../RecordNode/CompressedFormat/DeltaCodec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BINARY_SOURCE_USE_SSE2 1
+#else
+#define BINARY_SOURCE_USE_SSE2 0
+#endif
+
 using namespace BinarySource;
 
 BinaryFileSource::BinaryFileSource()
@@ -123,19 +141,63 @@ void BinaryFileSource::fillRecordInfo()
         String streamName = record[idFolder];
         streamName = streamName.trimCharactersAtEnd ("/");
 
-        File dataFile = m_rootPath.getChildFile ("continuous").getChildFile (streamName).getChildFile ("continuous.dat");
+        File streamFolder = m_rootPath.getChildFile ("continuous").getChildFile (streamName);
+        var compression = record["compression"];
+        var layout = record["layout"];
+        std::vector<CompressedChunk> chunks;
+        int64 channelMajorChunkSamples = 0;
+
+        String dataFileName = "continuous.dat";
+
+        if (compression.isObject())
+            dataFileName = compression["data_file"].toString();
+        else if (layout.isObject())
+            dataFileName = layout["data_file"].toString();
+
+        File dataFile = streamFolder.getChildFile (dataFileName);
         if (! dataFile.existsAsFile())
             continue;
 
         int numChannels = record[idNumChannels];
         int64 numSamples = (dataFile.getSize() / numChannels) / sizeof (int16);
 
+        if (compression.isObject())
+        {
+            if (compression["codec"].toString() != "delta_bitpack"
+                || ! loadNpyRecords (streamFolder.getChildFile (compression["index_file"].toString()), chunks))
+            {
+                LOGE ("Unable to read compressed stream ", streamName);
+                continue;
+            }
+
+            numSamples = chunks.empty() ? 0 : chunks.back().sampleOffset + chunks.back().numSamples;
+        }
+        else if (layout.isObject())
+        {
+            channelMajorChunkSamples = int64 (layout["samples_per_chunk"]);
+
+            if (layout["order"].toString() != "channel_major" || channelMajorChunkSamples <= 0)
+            {
+                LOGE ("Unable to read the layout of stream ", streamName);
+                continue;
+            }
+        }
+
         info.name = streamName;
         info.sampleRate = record[idSampleRate];
         info.numSamples = numSamples;
 
         File tsFile = m_rootPath.getChildFile ("continuous").getChildFile (streamName).getChildFile (sampleNumbersFilename);
-        if (tsFile.exists())
+        File segmentsFile = m_rootPath.getChildFile ("continuous").getChildFile (streamName).getChildFile ("timestamp_segments.npy");
+
+        std::vector<TimestampSegment> segments;
+
+        if (record["timestamp_format"].toString() == "segments" && loadNpyRecords (segmentsFile, segments))
+        {
+            info.startSampleNumber = segments.size() > 0 ? segments.front().sampleNumber : 0;
+            startSampleNumbers[streamName] = info.startSampleNumber;
+        }
+        else if (tsFile.exists())
         {
             std::unique_ptr<FileInputStream> tsDataStream = tsFile.createInputStream();
             MemoryBlock tsData;
@@ -165,6 +227,10 @@ void BinaryFileSource::fillRecordInfo()
         infoArray.add (info);
         numRecords++;
 
+        m_timestampSegments.push_back (std::move (segments));
+        m_chunkIndexes.push_back (std::move (chunks));
+        m_channelMajorChunkSamples.push_back (channelMajorChunkSamples);
+
         m_dataFileArray.add (dataFile);
     }
 
@@ -226,7 +292,8 @@ void BinaryFileSource::fillRecordInfo()
                     eventInfo.sampleNumbers.push_back (*snData - startSampleNumbers[streamName]);
                     eventInfo.text.push_back ("");
                 }
-                eventInfoMap[streamName] = eventInfo;
+                sortEvents (eventInfo);
+                eventInfoMap[streamName] = std::move (eventInfo);
             }
             else if (streamName.equalsIgnoreCase ("MessageCenter"))
             {
@@ -264,44 +331,143 @@ void BinaryFileSource::fillRecordInfo()
                     eventInfo.sampleNumbers.push_back (*snData - startSampleNumber);
                     eventInfo.text.push_back (outString);
                 }
-                eventInfoMap[streamName] = eventInfo;
+                sortEvents (eventInfo);
+                eventInfoMap[streamName] = std::move (eventInfo);
             }
         }
     }
 }
 
-void BinaryFileSource::processEventData (EventInfo& eventInfo, int64 start, int64 stop)
+template <typename RecordType>
+bool BinaryFileSource::loadNpyRecords (File file, std::vector<RecordType>& records)
+{
+    FileInputStream stream (file);
+
+    if (! stream.openedOk())
+        return false;
+
+    // \x93NUMPY + version (2 bytes) + header length (2 bytes, little endian)
+    stream.skipNextBytes (8);
+    int headerLength = stream.readShort();
+    stream.skipNextBytes (headerLength);
+
+    int64 numRecords = stream.getNumBytesRemaining() / sizeof (RecordType);
+
+    records.resize (numRecords);
+    stream.read (records.data(), int (numRecords * sizeof (RecordType)));
+
+    return true;
+}
+
+bool BinaryFileSource::reconstructTimestamps (int64 startSample, int nSamples, int64* sampleNumbers, double* timestamps) const
 {
-    int64 local_start = start % getActiveNumSamples();
-    int64 local_stop = stop % getActiveNumSamples();
+    int record = activeRecord.get();
 
-    std::vector<String> includeStreams = { currentStream, "MessageCenter" };
+    if (record < 0 || record >= int (m_timestampSegments.size()) || m_timestampSegments[record].empty())
+        return false;
 
-    for (int s = 0; s < includeStreams.size(); s++)
-    {
-        EventInfo info = eventInfoMap[includeStreams[s]];
+    const std::vector<TimestampSegment>& segments = m_timestampSegments[record];
 
-        int i = 0;
+    // segments are stored in recording order, so the file position of a segment is the sum of all previous lengths
+    int64 segmentStart = 0;
+    size_t segmentIndex = 0;
 
-        while (i < info.sampleNumbers.size())
+    for (int i = 0; i < nSamples; i++)
+    {
+        int64 position = startSample + i;
+
+        while (segmentIndex < segments.size() - 1 && position >= segmentStart + segments[segmentIndex].numSamples)
         {
-            if (info.sampleNumbers[i] >= local_start && info.sampleNumbers[i] < local_stop)
-            {
-                eventInfo.channels.push_back (info.channels[i] - 1);
-                eventInfo.channelStates.push_back ((info.channelStates[i]));
-                eventInfo.sampleNumbers.push_back (info.sampleNumbers[i]);
-                eventInfo.text.push_back (info.text[i]);
-            }
-            i++;
+            segmentStart += segments[segmentIndex].numSamples;
+            segmentIndex++;
         }
+
+        const TimestampSegment& segment = segments[segmentIndex];
+        int64 offset = position - segmentStart;
+
+        sampleNumbers[i] = segment.sampleNumber + offset;
+
+        if (segment.sampleRate > 0)
+            timestamps[i] = segment.timestamp + double (offset) / segment.sampleRate;
+        else
+            timestamps[i] = segment.timestamp;
+    }
+
+    return true;
+}
+
+void BinaryFileSource::processEventData (EventInfo& eventInfo, int64 start, int64 stop)
+{
+    const int64 numSamples = getActiveNumSamples();
+
+    if (numSamples <= 0 || stop <= start)
+        return;
+
+    int64 local_start = start % numSamples;
+    int64 local_stop = local_start + jmin (stop - start, numSamples);
+
+    for (const String& stream : { currentStream, String ("MessageCenter") })
+    {
+        auto it = eventInfoMap.find (stream);
+
+        if (it == eventInfoMap.end())
+            continue;
+
+        /* A range that runs past the end of the recording wraps around to its start */
+        appendEventsInRange (it->second, eventInfo, local_start, jmin (local_stop, numSamples));
+
+        if (local_stop > numSamples)
+            appendEventsInRange (it->second, eventInfo, 0, local_stop - numSamples);
     }
 }
 
+void BinaryFileSource::appendEventsInRange (const EventInfo& info, EventInfo& eventInfo, int64 start, int64 stop)
+{
+    const auto first = std::lower_bound (info.sampleNumbers.begin(), info.sampleNumbers.end(), start);
+    const auto last = std::lower_bound (first, info.sampleNumbers.end(), stop);
+
+    for (size_t i = size_t (first - info.sampleNumbers.begin()); i < size_t (last - info.sampleNumbers.begin()); i++)
+    {
+        eventInfo.channels.push_back (info.channels[i] - 1);
+        eventInfo.channelStates.push_back (info.channelStates[i]);
+        eventInfo.sampleNumbers.push_back (info.sampleNumbers[i]);
+        eventInfo.text.push_back (info.text[i]);
+    }
+}
+
+void BinaryFileSource::sortEvents (EventInfo& info)
+{
+    if (std::is_sorted (info.sampleNumbers.begin(), info.sampleNumbers.end()))
+        return;
+
+    std::vector<size_t> order (info.sampleNumbers.size());
+    std::iota (order.begin(), order.end(), 0);
+    std::stable_sort (order.begin(), order.end(), [&info] (size_t a, size_t b)
+                      { return info.sampleNumbers[a] < info.sampleNumbers[b]; });
+
+    EventInfo sorted;
+    sorted.channels.reserve (order.size());
+    sorted.channelStates.reserve (order.size());
+    sorted.sampleNumbers.reserve (order.size());
+    sorted.text.reserve (order.size());
+
+    for (size_t i : order)
+    {
+        sorted.channels.push_back (info.channels[i]);
+        sorted.channelStates.push_back (info.channelStates[i]);
+        sorted.sampleNumbers.push_back (info.sampleNumbers[i]);
+        sorted.text.push_back (info.text[i]);
+    }
+
+    info = std::move (sorted);
+}
+
 void BinaryFileSource::updateActiveRecord (int index)
 {
     m_dataFile.reset();
     m_dataFile = std::make_unique<MemoryMappedFile> (m_dataFileArray[index], MemoryMappedFile::readOnly);
     m_samplePos = 0;
+    m_cachedChunk = -1;
     numActiveChannels = getActiveNumChannels();
 
     bitVolts.clear();
@@ -330,17 +496,391 @@ int BinaryFileSource::readData (float* buffer, int nSamples)
         samplesToRead = nSamples;
     }
 
-    int16* data = static_cast<int16*> (m_dataFile->getData()) + (m_samplePos * numActiveChannels);
+    const float* scales = bitVolts.getRawDataPointer();
+
+    if (! m_chunkIndexes[activeRecord.get()].empty())
+    {
+        int64 samplesRead = 0;
+
+        while (samplesRead < samplesToRead)
+        {
+            const CompressedChunk& chunk = loadChunkForSample (m_samplePos);
+
+            int64 offset = m_samplePos - chunk.sampleOffset;
+            int64 count = jmin (samplesToRead - samplesRead, chunk.numSamples - offset);
+
+            const int16* data = m_chunkData + offset * numActiveChannels;
+            float* dest = buffer + samplesRead * numActiveChannels;
+
+            for (int64 i = 0; i < count; i++)
+            {
+                for (int ch = 0; ch < numActiveChannels; ch++)
+                    dest[ch] = data[ch] * scales[ch];
+
+                data += numActiveChannels;
+                dest += numActiveChannels;
+            }
+
+            samplesRead += count;
+            m_samplePos += count;
+        }
+
+        return int (samplesToRead);
+    }
+
+    if (m_channelMajorChunkSamples[activeRecord.get()] > 0)
+    {
+        const int64 chunkSamples = m_channelMajorChunkSamples[activeRecord.get()];
+        int64 samplesRead = 0;
+
+        while (samplesRead < samplesToRead)
+        {
+            int64 chunkLength;
+            const int16* chunk = getChannelMajorChunk (m_samplePos / chunkSamples, chunkLength);
+
+            int64 offset = m_samplePos % chunkSamples;
+            int64 count = jmin (samplesToRead - samplesRead, chunkLength - offset);
 
-    for (int i = 0; i < samplesToRead * numActiveChannels; i++)
+            float* dest = buffer + samplesRead * numActiveChannels;
+
+            for (int ch = 0; ch < numActiveChannels; ch++)
+            {
+                const int16* data = chunk + ch * chunkLength + offset;
+
+                for (int i = 0; i < count; i++)
+                    *(dest + i * numActiveChannels + ch) = *(data + i) * bitVolts[ch];
+            }
+
+            samplesRead += count;
+            m_samplePos += count;
+        }
+
+        return int (samplesToRead);
+    }
+
+    const int16* data = static_cast<const int16*> (m_dataFile->getData()) + (m_samplePos * numActiveChannels);
+
+    for (int64 i = 0; i < samplesToRead; i++)
     {
-        *(buffer + i) = *(data + i) * bitVolts[i % numActiveChannels];
+        for (int ch = 0; ch < numActiveChannels; ch++)
+            buffer[ch] = data[ch] * scales[ch];
+
+        data += numActiveChannels;
+        buffer += numActiveChannels;
     }
 
     m_samplePos += samplesToRead;
     return int(samplesToRead);
 }
 
+int BinaryFileSource::readPlanarData (float* const* channelBuffers, int nSamples)
+{
+    const int64 samplesToRead = jmin (int64 (nSamples), getActiveNumSamples() - m_samplePos);
+    const float* scales = bitVolts.getRawDataPointer();
+    const int64 chunkSamples = m_channelMajorChunkSamples[activeRecord.get()];
+
+    int64 samplesRead = 0;
+
+    while (samplesRead < samplesToRead)
+    {
+        int64 count = samplesToRead - samplesRead;
+
+        if (! m_chunkIndexes[activeRecord.get()].empty())
+        {
+            const CompressedChunk& chunk = loadChunkForSample (m_samplePos);
+            const int64 offset = m_samplePos - chunk.sampleOffset;
+            count = jmin (count, chunk.numSamples - offset);
+
+            decodeInterleaved (m_chunkData + offset * numActiveChannels, numActiveChannels, int (count), scales, channelBuffers, samplesRead);
+        }
+        else if (chunkSamples > 0)
+        {
+            /* Already channel-major: each channel is a contiguous run within the chunk */
+            int64 chunkLength;
+            const int16* chunk = getChannelMajorChunk (m_samplePos / chunkSamples, chunkLength);
+            const int64 offset = m_samplePos % chunkSamples;
+            count = jmin (count, chunkLength - offset);
+
+            for (int ch = 0; ch < numActiveChannels; ch++)
+            {
+                const int16* data = chunk + ch * chunkLength + offset;
+                float* dest = channelBuffers[ch] + samplesRead;
+                const float scale = scales[ch];
+
+                for (int64 i = 0; i < count; i++)
+                    dest[i] = data[i] * scale;
+            }
+        }
+        else
+        {
+            const int16* data = static_cast<const int16*> (m_dataFile->getData()) + m_samplePos * numActiveChannels;
+
+            decodeInterleaved (data, numActiveChannels, int (count), scales, channelBuffers, samplesRead);
+        }
+
+        samplesRead += count;
+        m_samplePos += count;
+    }
+
+    return int (samplesToRead);
+}
+
+void BinaryFileSource::decodeInterleaved (const int16* source, int numChannels, int numSamples, const float* scales, float* const* dest, int64 destOffset)
+{
+    /* Samples per block: keeps the rows being transposed resident in L1/L2 cache, even at several hundred channels */
+    const int blockSamples = 64;
+
+    for (int blockStart = 0; blockStart < numSamples; blockStart += blockSamples)
+    {
+        const int blockLength = jmin (blockSamples, numSamples - blockStart);
+        const int16* block = source + int64 (blockStart) * numChannels;
+        const int64 destStart = destOffset + blockStart;
+
+        int ch = 0;
+
+#if BINARY_SOURCE_USE_SSE2
+        const int vectorSamples = blockLength & ~7;
+
+        for (; ch + 8 <= numChannels; ch += 8)
+        {
+            for (int i = 0; i < vectorSamples; i += 8)
+            {
+                const int16* rows = block + int64 (i) * numChannels + ch;
+
+                /* 8 samples x 8 channels, one sample per register */
+                __m128i r[8];
+                for (int s = 0; s < 8; s++)
+                    r[s] = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (rows + s * numChannels));
+
+                /* Transpose to one channel per register */
+                const __m128i a0 = _mm_unpacklo_epi16 (r[0], r[1]);
+                const __m128i a1 = _mm_unpackhi_epi16 (r[0], r[1]);
+                const __m128i a2 = _mm_unpacklo_epi16 (r[2], r[3]);
+                const __m128i a3 = _mm_unpackhi_epi16 (r[2], r[3]);
+                const __m128i a4 = _mm_unpacklo_epi16 (r[4], r[5]);
+                const __m128i a5 = _mm_unpackhi_epi16 (r[4], r[5]);
+                const __m128i a6 = _mm_unpacklo_epi16 (r[6], r[7]);
+                const __m128i a7 = _mm_unpackhi_epi16 (r[6], r[7]);
+
+                const __m128i b0 = _mm_unpacklo_epi32 (a0, a2);
+                const __m128i b1 = _mm_unpackhi_epi32 (a0, a2);
+                const __m128i b2 = _mm_unpacklo_epi32 (a1, a3);
+                const __m128i b3 = _mm_unpackhi_epi32 (a1, a3);
+                const __m128i b4 = _mm_unpacklo_epi32 (a4, a6);
+                const __m128i b5 = _mm_unpackhi_epi32 (a4, a6);
+                const __m128i b6 = _mm_unpacklo_epi32 (a5, a7);
+                const __m128i b7 = _mm_unpackhi_epi32 (a5, a7);
+
+                const __m128i c[8] = {
+                    _mm_unpacklo_epi64 (b0, b4),
+                    _mm_unpackhi_epi64 (b0, b4),
+                    _mm_unpacklo_epi64 (b1, b5),
+                    _mm_unpackhi_epi64 (b1, b5),
+                    _mm_unpacklo_epi64 (b2, b6),
+                    _mm_unpackhi_epi64 (b2, b6),
+                    _mm_unpacklo_epi64 (b3, b7),
+                    _mm_unpackhi_epi64 (b3, b7)
+                };
+
+                /* Sign-extend to int32, convert and scale */
+                for (int k = 0; k < 8; k++)
+                {
+                    const __m128 scale = _mm_set1_ps (scales[ch + k]);
+                    const __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (c[k], c[k]), 16);
+                    const __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (c[k], c[k]), 16);
+
+                    float* out = dest[ch + k] + destStart + i;
+                    _mm_storeu_ps (out, _mm_mul_ps (_mm_cvtepi32_ps (lo), scale));
+                    _mm_storeu_ps (out + 4, _mm_mul_ps (_mm_cvtepi32_ps (hi), scale));
+                }
+            }
+
+            /* Remaining samples of the block */
+            for (int k = 0; k < 8; k++)
+            {
+                float* out = dest[ch + k] + destStart;
+                const float scale = scales[ch + k];
+
+                for (int i = vectorSamples; i < blockLength; i++)
+                    out[i] = block[int64 (i) * numChannels + ch + k] * scale;
+            }
+        }
+#endif
+
+        /* Remaining channels (or all channels, without SSE2) */
+        for (; ch < numChannels; ch++)
+        {
+            float* out = dest[ch] + destStart;
+            const float scale = scales[ch];
+
+            for (int i = 0; i < blockLength; i++)
+                out[i] = block[int64 (i) * numChannels + ch] * scale;
+        }
+    }
+}
+
+int BinaryFileSource::readChannel (int channel, int64 startSample, int nSamples, float* buffer)
+{
+    if (channel < 0 || channel >= numActiveChannels || startSample < 0 || startSample >= getActiveNumSamples())
+        return 0;
+
+    const int64 samplesToRead = jmin (int64 (nSamples), getActiveNumSamples() - startSample);
+    const float scale = bitVolts[channel];
+    const int64 chunkSamples = m_channelMajorChunkSamples[activeRecord.get()];
+
+    int64 samplesRead = 0;
+
+    while (samplesRead < samplesToRead)
+    {
+        const int64 position = startSample + samplesRead;
+        const int16* data;
+        int64 count;
+        int stride = numActiveChannels;
+
+        if (! m_chunkIndexes[activeRecord.get()].empty())
+        {
+            const CompressedChunk& chunk = loadChunkForSample (position);
+            count = chunk.numSamples - (position - chunk.sampleOffset);
+            data = m_chunkData + (position - chunk.sampleOffset) * numActiveChannels + channel;
+        }
+        else if (chunkSamples > 0)
+        {
+            int64 chunkLength;
+            const int16* chunk = getChannelMajorChunk (position / chunkSamples, chunkLength);
+            count = chunkLength - position % chunkSamples;
+            data = chunk + channel * chunkLength + position % chunkSamples;
+            stride = 1;
+        }
+        else
+        {
+            count = samplesToRead - samplesRead;
+            data = static_cast<const int16*> (m_dataFile->getData()) + position * numActiveChannels + channel;
+        }
+
+        count = jmin (count, samplesToRead - samplesRead);
+
+        for (int64 i = 0; i < count; i++)
+            buffer[samplesRead + i] = data[i * stride] * scale;
+
+        samplesRead += count;
+    }
+
+    return int (samplesToRead);
+}
+
+void BinaryFileSource::prefetch (int64 startSample, int64 nSamples)
+{
+    if (m_dataFile == nullptr || m_dataFile->getData() == nullptr)
+        return;
+
+    startSample = jmax (int64 (0), startSample);
+    const int64 endSample = jmin (getActiveNumSamples(), startSample + nSamples);
+
+    if (endSample <= startSample)
+        return;
+
+    /* Byte range of the data file holding [startSample, endSample) */
+    const int64 bytesPerSample = int64 (numActiveChannels) * sizeof (int16);
+    const int64 chunkSamples = m_channelMajorChunkSamples[activeRecord.get()];
+    const std::vector<CompressedChunk>& chunks = m_chunkIndexes[activeRecord.get()];
+    int64 beginByte, endByte;
+
+    if (! chunks.empty())
+    {
+        auto chunkAt = [&chunks] (int64 sample)
+        {
+            auto it = std::upper_bound (chunks.begin(), chunks.end(), sample, [] (int64 s, const CompressedChunk& chunk)
+                                        { return s < chunk.sampleOffset; });
+            return chunks[size_t (jmax (0, int (it - chunks.begin()) - 1))];
+        };
+
+        const CompressedChunk& first = chunkAt (startSample);
+        const CompressedChunk& last = chunkAt (endSample - 1);
+
+        beginByte = first.byteOffset;
+        endByte = last.byteOffset + last.numBytes;
+    }
+    else if (chunkSamples > 0)
+    {
+        beginByte = (startSample / chunkSamples) * chunkSamples * bytesPerSample;
+        endByte = ((endSample - 1) / chunkSamples + 1) * chunkSamples * bytesPerSample;
+    }
+    else
+    {
+        beginByte = startSample * bytesPerSample;
+        endByte = endSample * bytesPerSample;
+    }
+
+    endByte = jmin (endByte, int64 (m_dataFile->getSize()));
+
+    if (endByte <= beginByte)
+        return;
+
+    char* data = static_cast<char*> (m_dataFile->getData());
+
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range { data + beginByte, size_t (endByte - beginByte) };
+    PrefetchVirtualMemory (GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    /* madvise needs a page-aligned start; WILLNEED queues the reads and returns at once */
+    const int64 pageSize = int64 (sysconf (_SC_PAGESIZE));
+    const int64 alignedBegin = beginByte - ((reinterpret_cast<uintptr_t> (data) + beginByte) % pageSize);
+
+    posix_madvise (data + alignedBegin, size_t (endByte - alignedBegin), POSIX_MADV_WILLNEED);
+#endif
+}
+
+const int16* BinaryFileSource::getChannelMajorChunk (int64 chunkIndex, int64& chunkLength) const
+{
+    const int64 chunkSamples = m_channelMajorChunkSamples[activeRecord.get()];
+    const int64 chunkStart = chunkIndex * chunkSamples;
+
+    /* Every chunk is full except the last one */
+    chunkLength = jmin (chunkSamples, getActiveNumSamples() - chunkStart);
+
+    return static_cast<const int16*> (m_dataFile->getData()) + chunkStart * numActiveChannels;
+}
+
+const BinaryFileSource::CompressedChunk& BinaryFileSource::loadChunkForSample (int64 sample)
+{
+    const std::vector<CompressedChunk>& chunks = m_chunkIndexes[activeRecord.get()];
+
+    if (m_cachedChunk >= 0
+        && sample >= chunks[m_cachedChunk].sampleOffset
+        && sample < chunks[m_cachedChunk].sampleOffset + chunks[m_cachedChunk].numSamples)
+        return chunks[m_cachedChunk];
+
+    /* Find the last chunk starting at or before the sample */
+    auto it = std::upper_bound (chunks.begin(), chunks.end(), sample, [] (int64 s, const CompressedChunk& chunk)
+                                { return s < chunk.sampleOffset; });
+
+    m_cachedChunk = jmax (0, int (it - chunks.begin()) - 1);
+
+    const CompressedChunk& chunk = chunks[m_cachedChunk];
+
+    if (m_chunkDataSize < size_t (chunk.numSamples * numActiveChannels))
+    {
+        m_chunkDataSize = size_t (chunk.numSamples * numActiveChannels);
+        m_chunkData.malloc (m_chunkDataSize);
+    }
+
+    /* Chunk layout: encoded size of each channel, followed by each channel's payload */
+    const uint8* chunkStart = static_cast<const uint8*> (m_dataFile->getData()) + chunk.byteOffset;
+    const uint32* encodedSizes = reinterpret_cast<const uint32*> (chunkStart);
+    const uint8* payload = chunkStart + numActiveChannels * sizeof (uint32);
+
+    /* Decode straight into interleaved order, as stored in continuous.dat */
+    for (int ch = 0; ch < numActiveChannels; ch++)
+    {
+        DeltaCodec::decodeChannel (payload, int (chunk.numSamples), m_chunkData + ch, numActiveChannels);
+        payload += encodedSizes[ch];
+    }
+
+    return chunk;
+}
+
 /* void BinaryFileSource::processChannelData (int16* inBuffer, float* outBuffer, int channel, int64 numSamples)
 {
     if (! inBuffer)
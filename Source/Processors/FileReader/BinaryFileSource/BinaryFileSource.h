@@ -65,7 +65,71 @@ public:
     /** Add info about events occurring within a sample range */
     void processEventData (EventInfo& info, int64 fromSampleNumber, int64 toSampleNumber) override;
 
+    /** Decodes nSamples of continuous data straight into one buffer per channel */
+    int readPlanarData (float* const* channelBuffers, int nSamples) override;
+
+    /** Asks the OS to start reading the part of the data file that holds a range of samples */
+    void prefetch (int64 startSample, int64 nSamples) override;
+
+    /** Reads nSamples of one channel of the active recording into a buffer, starting at a sample index
+        within the file. Only the channel's own samples are read from channel-major files.
+        Returns the number of samples read. */
+    int readChannel (int channel, int64 startSample, int nSamples, float* buffer);
+
+    /** Reconstructs sample numbers and timestamps for nSamples of the active recording, starting at
+        a sample index within the file. Returns false if the stream was not recorded with compact timestamps. */
+    bool reconstructTimestamps (int64 startSample, int nSamples, int64* sampleNumbers, double* timestamps) const;
+
 private:
+    /** One record of a timestamp_segments.npy file (see BinaryRecording) */
+    struct TimestampSegment
+    {
+        int64 sampleNumber;
+        double timestamp;
+        double sampleRate;
+        int64 numSamples;
+    };
+
+    /** One record of a chunk_index.npy file (see CompressedBlockFile) */
+    struct CompressedChunk
+    {
+        int64 byteOffset;
+        int64 numBytes;
+        int64 sampleOffset;
+        int64 numSamples;
+    };
+
+    /** Sorts an event stream by sample number, keeping every column in step */
+    static void sortEvents (EventInfo& info);
+
+    /** Appends the events of a sorted stream within [start, stop), found by binary search */
+    static void appendEventsInRange (const EventInfo& info, EventInfo& eventInfo, int64 start, int64 stop);
+
+    /** Loads all records of a structured .npy file (timestamp segments or chunk index) */
+    template <typename RecordType>
+    static bool loadNpyRecords (File file, std::vector<RecordType>& records);
+
+    /** Transposes and scales interleaved int16 samples into channel-major float buffers,
+        writing each channel from destOffset onwards. Works through cache-sized blocks of
+        samples, using an 8x8 SSE2 transpose where available. */
+    static void decodeInterleaved (const int16* source, int numChannels, int numSamples, const float* scales, float* const* dest, int64 destOffset);
+
+    /** Decodes the compressed chunk of the active recording that holds a sample */
+    const CompressedChunk& loadChunkForSample (int64 sample);
+
+    std::vector<std::vector<TimestampSegment>> m_timestampSegments;
+    std::vector<std::vector<CompressedChunk>> m_chunkIndexes;
+
+    /** Returns a pointer to the first sample of a channel-major chunk, and the chunk's length */
+    const int16* getChannelMajorChunk (int64 chunkIndex, int64& chunkLength) const;
+
+    /** Samples per chunk of each recording written in channel-major chunks (0 if interleaved) */
+    std::vector<int64> m_channelMajorChunkSamples;
+
+    HeapBlock<int16> m_chunkData;
+    size_t m_chunkDataSize { 0 };
+    int m_cachedChunk { -1 };
+
     int numActiveChannels;
     Array<float> bitVolts;
 
@@ -24,6 +24,7 @@
 #include "FileReader.h"
 #include "FileReaderEditor.h"
 #include "FileReaderActions.h"
+#include "OverviewPyramid.h"
 
 #include "../../AccessClass.h"
 #include "../../Audio/AudioComponent.h"
@@ -47,13 +48,19 @@ FileReader::FileReader() : GenericProcessor ("File Reader"),
                            stopSample (0),
                            bufferCacheWindow (0),
                            m_shouldFillBackBuffer (false),
+                           m_backBufferFilled (false),
                            m_bufferSize (1024),
+                           m_cacheSamplesPerChannel (0),
                            m_sysSampleRate (44100),
                            playbackActive (true),
                            gotNewFile (true),
                            loopPlayback (true),
                            sampleRateWarningShown (false),
-                           firstProcess (false)
+                           playAllStreams (false),
+                           readAheadSeconds (2.0f),
+                           readAheadFrom (0),
+                           readAheadTo (0),
+                           waitForReader (false)
 {
     /* Define a default file location based on OS */
 #ifdef __APPLE__
@@ -88,6 +95,8 @@ void FileReader::registerParameters()
     addSelectedStreamParameter (Parameter::PROCESSOR_SCOPE, "active_stream", "Active Stream", "Currently active stream", {"example_data"}, 0);
     addTimeParameter (Parameter::PROCESSOR_SCOPE, "start_time", "Start Time", "Time to start playback", "00:00:00.000");
     addTimeParameter (Parameter::PROCESSOR_SCOPE, "end_time", "Stop Time", "Time to end playback", "00:00:04.999");
+    addBooleanParameter (Parameter::PROCESSOR_SCOPE, "all_streams", "Play All Streams", "Play back every stream in the file alongside the active stream", false, true);
+    addIntParameter (Parameter::PROCESSOR_SCOPE, "read_ahead", "Read Ahead", "Seconds of data to fetch from storage ahead of playback", 2, 0, 30, true);
 
     /* Link parameters */
     PathParameter* fileParam = static_cast<PathParameter*>(getParameter("selected_file"));
@@ -137,6 +146,17 @@ void FileReader::parameterValueChanged (Parameter* p)
         
         setPlaybackStop(stopSample);
     }
+    else if (p->getName() == "all_streams")
+    {
+        playAllStreams = ((BooleanParameter*) p)->getBoolValue();
+
+        updateSettings();
+        CoreServices::updateSignalChain (this);
+    }
+    else if (p->getName() == "read_ahead")
+    {
+        readAheadSeconds = float ((int) p->getValue());
+    }
 
     currentNumTotalSamples = stopSample - startSample;
 
@@ -236,17 +256,8 @@ bool FileReader::setFile (String fullpath, bool shouldUpdateSignalChain)
 
     if (isExtensionSupported)
     {
-        const int numPluginFileSources = AccessClass::getPluginManager()->getNumFileSources();
+        input.reset (createFileSource (index));
 
-        if (index > 1)
-        {
-            Plugin::FileSourceInfo sourceInfo = AccessClass::getPluginManager()->getFileSourceInfo (index - 2);
-            input.reset (sourceInfo.creator());
-        }
-        else
-        {
-            input.reset (createBuiltInFileSource (0));
-        }
         if (! input)
         {
             LOGE ("Error creating file source for extension ", ext);
@@ -301,8 +312,6 @@ bool FileReader::setFile (String fullpath, bool shouldUpdateSignalChain)
     //Set initial values on time parameters
     endTime->setNextValue (TimeParameter::TimeValue (1000 * stopSample / input->getActiveSampleRate()).toString(), false);
 
-    firstProcess = false;
-
     return true;
 }
 
@@ -356,6 +365,8 @@ void FileReader::setActiveStream (int index, bool reset)
 
     input->seekTo (startSample);
 
+    createOverview();
+
     updateSettings();
     CoreServices::updateSignalChain (this);
 }
@@ -395,6 +406,15 @@ bool FileReader::startAcquisition()
 
     checkAudioDevice();
 
+    /* Offline processing plays the file once, then lets the offline device stop acquisition */
+    waitForReader = AccessClass::getAudioComponent()->isOffline();
+
+    if (waitForReader)
+        loopPlayback = false;
+
+    playbackFinished = false;
+    bufferUnderruns = 0;
+
     /* Start asynchronous file reading thread */
     startThread();
 
@@ -405,6 +425,9 @@ bool FileReader::stopAcquisition()
 {
     stopThread (500);
 
+    if (bufferUnderruns > 0)
+        LOGC ("File Reader: playback caught up with file reading ", bufferUnderruns.load(), " times; increase Read Ahead or use faster storage");
+
     return true;
 }
 
@@ -439,6 +462,10 @@ void FileReader::setCurrentSample(int64 sampleNumber)
 
     // Fill only the back buffer first
     readAndFillBufferCache(*backBuffer);
+    m_backBufferFilled.set(true);
+
+    // Keep the other streams aligned with the new position
+    resetSecondaryStreams(sampleNumber);
 
     // Signal that we want to switch buffers on next process() call
     bufferCacheWindow.set(BUFFER_WINDOW_CACHE_SIZE - 1); // Force buffer switch on next process
@@ -452,15 +479,23 @@ void FileReader::setCurrentSample(int64 sampleNumber)
     startThread();
 }
 
+void FileReader::prefetchWindow (int64 sampleNumber)
+{
+    if (overview)
+        overview->prefetch (sampleNumber, m_samplesPerBuffer.get() * BUFFER_WINDOW_CACHE_SIZE);
+}
+
 void FileReader::setPlaybackStart (int64 startSample)
 {
     this->startSample = startSample;
+    updateSecondaryStreamRanges();
     setCurrentSample (startSample);
 }
 
 void FileReader::setPlaybackStop (int64 stopSample)
 {
     this->stopSample = stopSample;
+    updateSecondaryStreamRanges();
 }
 
 int64 FileReader::getPlayheadPosition()
@@ -495,17 +530,9 @@ void FileReader::updateSettings()
         continuousChannels.clear();
         eventChannels.clear();
 
-        String streamName = input->getRecordName (input->getActiveRecord());
-
-        /* Only use the original stream name (FileReader-100.example_data -> example_data) */
-        StringArray tokens;
-        tokens.addTokens (input->getRecordName (input->getActiveRecord()), ".");
-        if (tokens.size())
-            streamName = tokens[tokens.size() - 1];
-
         DataStream::Settings streamSettings {
 
-            streamName,
+            getStreamName (input->getActiveRecord()),
             "A description of the File Reader Stream",
             "identifier",
             getDefaultSampleRate()
@@ -550,6 +577,42 @@ void FileReader::updateSettings()
         events->addProcessor (this);
         eventChannels.add (events);
 
+        /* Each secondary stream gets its own data stream, after the active one */
+        createSecondaryStreams();
+
+        for (auto* stream : secondaryStreams)
+        {
+            const int recordIndex = stream->source->getActiveRecord();
+
+            DataStream::Settings secondarySettings {
+                getStreamName (recordIndex),
+                "A description of the File Reader Stream",
+                "identifier",
+                stream->sampleRate
+            };
+
+            dataStreams.add (new DataStream (secondarySettings));
+            dataStreams.getLast()->addProcessor (this);
+
+            for (int i = 0; i < stream->numChannels; i++)
+            {
+                RecordedChannelInfo info = stream->source->getChannelInfo (recordIndex, i);
+
+                ContinuousChannel::Settings channelSettings {
+                    static_cast<ContinuousChannel::Type> (info.type),
+                    info.name,
+                    "description",
+                    "filereader.stream",
+                    info.bitVolts,
+
+                    dataStreams.getLast()
+                };
+
+                continuousChannels.add (new ContinuousChannel (channelSettings));
+                continuousChannels.getLast()->addProcessor (this);
+            }
+        }
+
         gotNewFile = false;
     }
     else
@@ -593,8 +656,7 @@ void FileReader::updateSettings()
 
     m_samplesPerBuffer.set (m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate));
 
-    bufferA.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
-    bufferB.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
+    allocateBufferCache();
 
     /* Reset stream to start of playback */
     input->seekTo (startSample);
@@ -602,12 +664,15 @@ void FileReader::updateSettings()
 
     /* Pre-fills the front buffer with a blocking read */
     readAndFillBufferCache (bufferA);
+    m_backBufferFilled.set (true);
+
+    updateSecondaryStreamRanges();
+    resetSecondaryStreams (startSample);
 
+    /* The next block switches to the pre-filled buffer */
     readBuffer = &bufferB;
     bufferCacheWindow = 0;
     m_shouldFillBackBuffer.set (false);
-    if (firstProcess)
-        switchBuffer();
 
     LOGD ("File Reader finished updating custom settings.");
 }
@@ -627,8 +692,7 @@ void FileReader::checkAudioDevice()
             m_bufferSize = 1024;
         m_samplesPerBuffer.set (m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate));
 
-        bufferA.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
-        bufferB.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
+        allocateBufferCache();
 
         /* Reset stream to start of playback */
         input->seekTo (startSample);
@@ -636,6 +700,9 @@ void FileReader::checkAudioDevice()
 
         /* Pre-fills the front buffer with a blocking read */
         readAndFillBufferCache (bufferA);
+        m_backBufferFilled.set (true);
+
+        resetSecondaryStreams (startSample);
 
         readBuffer = &bufferB;
         bufferCacheWindow = 0;
@@ -689,34 +756,37 @@ void FileReader::process (AudioBuffer<float>& buffer)
 {
     const ScopedLock sl(bufferLock);
 
-    if (needsBufferReset.compareAndSetBool(false, true))
+    // Offline playback has reached the end of the file: send no more samples
+    if (playbackFinished)
     {
-        // Switch to the newly prepared back buffer
-        switchBuffer();
-        bufferCacheWindow.set(0);
+        for (auto* stream : dataStreams)
+            setTimestampAndSamples(playbackSamplePos.get(), -1.0, 0, stream->getStreamId());
+
+        return;
     }
 
     int samplesNeededPerBuffer = int(float(buffer.getNumSamples()) * (getDefaultSampleRate() / m_sysSampleRate));
     m_samplesPerBuffer.set(samplesNeededPerBuffer);
 
-    // Handle buffer switching
-    if (firstProcess && bufferCacheWindow.get() == 0)
+    if (needsBufferReset.compareAndSetBool(false, true))
     {
+        // Switch to the newly prepared back buffer (only once, or the buffer still being refilled would be played)
+        switchBuffer();
+        bufferCacheWindow.set(0);
+    }
+    else if (bufferCacheWindow.get() == 0)
+    {
+        // Handle buffer switching
         switchBuffer();
     }
 
-    // Get current buffer position
-    const float* tempReadBuffer = readBuffer->getData() + 
-        (samplesNeededPerBuffer * currentNumChannels * bufferCacheWindow.get());
+    // Get current buffer position (the cache is channel-major)
+    const float* tempReadBuffer = readBuffer->getData() + (samplesNeededPerBuffer * bufferCacheWindow.get());
 
     // Copy data to output buffer
     for (int ch = 0; ch < currentNumChannels; ++ch)
     {
-        float* writeBuffer = buffer.getWritePointer(ch);
-        for (int sample = 0; sample < samplesNeededPerBuffer; sample++)
-        {
-            *(writeBuffer + sample) = *(tempReadBuffer + (currentNumChannels * sample) + ch);
-        }
+        FloatVectorOperations::copy(buffer.getWritePointer(ch), tempReadBuffer + ch * m_cacheSamplesPerChannel, samplesNeededPerBuffer);
     }
 
     // Update timestamps and sample positions atomically
@@ -724,6 +794,14 @@ void FileReader::process (AudioBuffer<float>& buffer)
     playbackSamplePos.set(start + samplesNeededPerBuffer);
     int64 stop = playbackSamplePos.get();
 
+    // Without looping, the last block ends at the stop sample
+    if (! loopPlayback && stop >= stopSample)
+    {
+        samplesNeededPerBuffer -= int(stop - stopSample);
+        stop = stopSample;
+        playbackFinished = true;
+    }
+
     setTimestampAndSamples(start, -1.0, samplesNeededPerBuffer, dataStreams[0]->getStreamId());
 
     // Handle looping
@@ -735,12 +813,18 @@ void FileReader::process (AudioBuffer<float>& buffer)
     // Process events for this buffer
     addEventsInRange(start, stop);
 
+    // Secondary streams follow the active stream's channels, each with its own sample numbers
+    int channelOffset = currentNumChannels;
+
+    for (int i = 0; i < secondaryStreams.size(); ++i)
+    {
+        processSecondaryStream(*secondaryStreams[i], buffer, channelOffset, dataStreams[i + 1]->getStreamId());
+        channelOffset += secondaryStreams[i]->numChannels;
+    }
+
     // Update buffer window counter
     int newWindow = (bufferCacheWindow.get() + 1) % BUFFER_WINDOW_CACHE_SIZE;
     bufferCacheWindow.set(newWindow);
-
-    if (!firstProcess)
-        firstProcess = true;
 }
 
 void FileReader::addEventsInRange (int64 start, int64 stop)
@@ -781,11 +865,23 @@ void FileReader::switchBuffer()
 {
     const ScopedLock sl(bufferLock);
 
+    /* The reader thread has not finished refilling the buffer we are about to play */
+    if (waitForReader)
+    {
+        while (! m_backBufferFilled.get() && isThreadRunning())
+            backBufferReady.wait (10);
+    }
+    else if (! m_backBufferFilled.get())
+    {
+        bufferUnderruns++;
+    }
+
     if (readBuffer == &bufferA)
         readBuffer = &bufferB;
     else
         readBuffer = &bufferA;
 
+    m_backBufferFilled.set(false);
     m_shouldFillBackBuffer.set(true);
     notify();
 }
@@ -810,12 +906,36 @@ void FileReader::run()
         if (m_shouldFillBackBuffer.compareAndSetBool (false, true))
         {
             readAndFillBufferCache (*getBackBuffer());
+            m_backBufferFilled.set (true);
+            backBufferReady.signal();
         }
 
+        requestReadAhead();
+
+        fillSecondaryStreams();
+        secondaryStreamsReady.signal();
+
         wait (30);
     }
 }
 
+void FileReader::allocateBufferCache()
+{
+    m_cacheSamplesPerChannel = int (m_bufferSize) * BUFFER_WINDOW_CACHE_SIZE;
+
+    bufferA.malloc (currentNumChannels * m_cacheSamplesPerChannel);
+    bufferB.malloc (currentNumChannels * m_cacheSamplesPerChannel);
+    m_cacheChannelPointers.malloc (currentNumChannels);
+}
+
+void FileReader::readIntoBufferCache (HeapBlock<float>& cacheBuffer, int offset, int numSamples)
+{
+    for (int ch = 0; ch < currentNumChannels; ++ch)
+        m_cacheChannelPointers[ch] = cacheBuffer + ch * m_cacheSamplesPerChannel + offset;
+
+    input->readPlanarData (m_cacheChannelPointers, numSamples);
+}
+
 void FileReader::readAndFillBufferCache (HeapBlock<float>& cacheBuffer)
 {
     const int samplesNeededPerBuffer = m_samplesPerBuffer.get();
@@ -833,7 +953,7 @@ void FileReader::readAndFillBufferCache (HeapBlock<float>& cacheBuffer)
         {
             samplesToRead = int (stopSample - currentSample);
             if (samplesToRead > 0)
-                input->readData (cacheBuffer + samplesRead * currentNumChannels, samplesToRead);
+                readIntoBufferCache (cacheBuffer, samplesRead, samplesToRead);
 
             // reset stream to beginning
             input->seekTo (startSample);
@@ -841,7 +961,7 @@ void FileReader::readAndFillBufferCache (HeapBlock<float>& cacheBuffer)
         }
         else // else read the block needed
         {
-            input->readData (cacheBuffer + samplesRead * currentNumChannels, samplesToRead);
+            readIntoBufferCache (cacheBuffer, samplesRead, samplesToRead);
 
             currentSample += samplesToRead;
         }
@@ -855,6 +975,291 @@ void FileReader::readAndFillBufferCache (HeapBlock<float>& cacheBuffer)
     }
 }
 
+void FileReader::requestReadAhead()
+{
+    const int64 readAheadSamples = int64 (readAheadSeconds * currentSampleRate);
+
+    if (readAheadSamples <= 0 || ! input)
+        return;
+
+    /* Renew the request once the reader is halfway through it, or has jumped out of it */
+    if (currentSample >= readAheadFrom && currentSample + readAheadSamples / 2 < readAheadTo)
+        return;
+
+    readAheadFrom = currentSample;
+    readAheadTo = currentSample + readAheadSamples;
+
+    input->prefetch (currentSample, jmin (readAheadTo, stopSample) - currentSample);
+
+    /* When looping, the read-ahead continues from the start of the playback range */
+    if (loopPlayback && readAheadTo > stopSample)
+        input->prefetch (startSample, readAheadTo - stopSample);
+}
+
+void FileReader::createSecondaryStreams()
+{
+    secondaryStreams.clear();
+
+    if (! playAllStreams || ! input)
+        return;
+
+    const File file (input->getFileName());
+    const int extensionIndex = supportedExtensions[file.getFileExtension().toLowerCase().substring (1)];
+
+    for (int record = 0; record < input->getNumRecords(); ++record)
+    {
+        if (record == input->getActiveRecord()
+            || input->getRecordNumChannels (record) <= 0
+            || input->getRecordNumSamples (record) <= 0)
+            continue;
+
+        std::unique_ptr<FileSource> source (createFileSource (extensionIndex));
+
+        if (source == nullptr || ! source->openFile (file))
+        {
+            LOGE ("File Reader: unable to open stream ", input->getRecordName (record), " for simultaneous playback");
+            continue;
+        }
+
+        source->setActiveRecord (record);
+
+        auto* stream = secondaryStreams.add (new SecondaryStream());
+        stream->numChannels = source->getActiveNumChannels();
+        stream->sampleRate = source->getActiveSampleRate();
+        stream->numSamples = source->getActiveNumSamples();
+        stream->source = std::move (source);
+
+        LOGD ("File Reader playing stream ", getStreamName (record), " alongside the active stream.");
+    }
+
+    updateSecondaryStreamRanges();
+}
+
+int64 FileReader::toSecondarySample (int64 activeSampleNumber, const SecondaryStream& stream) const
+{
+    if (currentSampleRate <= 0)
+        return 0;
+
+    const int64 sampleNumber = int64 (double (activeSampleNumber) * stream.sampleRate / currentSampleRate + 0.5);
+
+    return jlimit (int64 (0), stream.numSamples, sampleNumber);
+}
+
+void FileReader::updateSecondaryStreamRanges()
+{
+    for (auto* stream : secondaryStreams)
+    {
+        stream->startSample = toSecondarySample (startSample, *stream);
+        stream->stopSample = toSecondarySample (stopSample, *stream);
+
+        if (stream->stopSample <= stream->startSample)
+        {
+            stream->startSample = 0;
+            stream->stopSample = stream->numSamples;
+        }
+    }
+}
+
+void FileReader::resetSecondaryStreams (int64 activeSampleNumber)
+{
+    const int minimumCapacity = 4 * int (m_bufferSize);
+
+    for (auto* stream : secondaryStreams)
+    {
+        const int capacity = jmax (minimumCapacity, int (stream->sampleRate * SECONDARY_STREAM_BUFFER_SECONDS));
+
+        if (stream->fifo.getTotalSize() != capacity)
+        {
+            stream->fifo.setTotalSize (capacity);
+            stream->buffer.malloc (capacity * stream->numChannels);
+            stream->channelPointers.malloc (stream->numChannels);
+        }
+
+        stream->fifo.reset();
+
+        int64 position = toSecondarySample (activeSampleNumber, *stream);
+        if (position < stream->startSample || position >= stream->stopSample)
+            position = stream->startSample;
+
+        stream->readPosition = position;
+        stream->playbackSamplePos = position;
+        stream->fractionalSamples = 0;
+        stream->samplesToSkip = 0;
+        stream->finished = false;
+        stream->source->seekTo (position);
+    }
+
+    /* Pre-fills the read-ahead buffers with a blocking read */
+    fillSecondaryStreams();
+}
+
+void FileReader::fillSecondaryStreams()
+{
+    for (auto* stream : secondaryStreams)
+    {
+        /* Drop whatever the process thread could not wait for, so the stream stays aligned */
+        const int64 skipped = stream->samplesToSkip.exchange (0);
+
+        if (skipped > 0)
+        {
+            const int64 length = stream->stopSample - stream->startSample;
+
+            if (loopPlayback)
+                stream->readPosition = stream->startSample + (stream->readPosition - stream->startSample + skipped) % length;
+            else
+                stream->readPosition = jmin (stream->stopSample, stream->readPosition + skipped);
+
+            stream->source->seekTo (stream->readPosition);
+        }
+
+        int start1, size1, start2, size2;
+        stream->fifo.prepareToWrite (stream->fifo.getFreeSpace(), start1, size1, start2, size2);
+
+        int samplesRead = 0;
+
+        if (size1 > 0)
+            samplesRead += readSecondaryStream (*stream, start1, size1);
+        if (size2 > 0 && samplesRead == size1)
+            samplesRead += readSecondaryStream (*stream, start2, size2);
+
+        stream->fifo.finishedWrite (samplesRead);
+    }
+}
+
+int FileReader::readSecondaryStream (SecondaryStream& stream, int ringPosition, int numSamples)
+{
+    const int capacity = stream.fifo.getTotalSize();
+    int samplesRead = 0;
+
+    while (samplesRead < numSamples)
+    {
+        const int samplesToRead = int (jmin (int64 (numSamples - samplesRead), stream.stopSample - stream.readPosition));
+
+        if (samplesToRead > 0)
+        {
+            for (int ch = 0; ch < stream.numChannels; ++ch)
+                stream.channelPointers[ch] = stream.buffer + ch * capacity + ringPosition + samplesRead;
+
+            stream.source->readPlanarData (stream.channelPointers, samplesToRead);
+            stream.readPosition += samplesToRead;
+            samplesRead += samplesToRead;
+        }
+
+        if (stream.readPosition >= stream.stopSample)
+        {
+            // like the active stream, stop at the end of the playback range unless looping
+            if (! loopPlayback)
+                break;
+
+            stream.source->seekTo (stream.startSample);
+            stream.readPosition = stream.startSample;
+        }
+    }
+
+    return samplesRead;
+}
+
+void FileReader::processSecondaryStream (SecondaryStream& stream, AudioBuffer<float>& buffer, int channelOffset, uint16 streamId)
+{
+    const double exactSamples = double (buffer.getNumSamples()) * stream.sampleRate / m_sysSampleRate + stream.fractionalSamples;
+    int numSamples = jmin (int (exactSamples), buffer.getNumSamples());
+    stream.fractionalSamples = exactSamples - numSamples;
+
+    /* Without looping, the stream stops at the end of its own playback range */
+    if (! loopPlayback)
+        numSamples = stream.finished ? 0 : int (jmin (int64 (numSamples), stream.stopSample - stream.playbackSamplePos));
+
+    /* Offline processing waits for the reader thread instead of padding with zeros */
+    if (waitForReader)
+    {
+        while (stream.fifo.getNumReady() < numSamples && isThreadRunning())
+        {
+            notify();
+            secondaryStreamsReady.wait (10);
+        }
+    }
+
+    int start1, size1, start2, size2;
+    stream.fifo.prepareToRead (numSamples, start1, size1, start2, size2);
+
+    const int samplesAvailable = size1 + size2;
+
+    const int capacity = stream.fifo.getTotalSize();
+
+    for (int ch = 0; ch < stream.numChannels; ++ch)
+    {
+        float* writeBuffer = buffer.getWritePointer (channelOffset + ch);
+        const float* ringBuffer = stream.buffer + ch * capacity;
+
+        FloatVectorOperations::copy (writeBuffer, ringBuffer + start1, size1);
+        FloatVectorOperations::copy (writeBuffer + size1, ringBuffer + start2, size2);
+
+        /* Outside offline processing, pad with zeros if the reader thread fell behind, rather than blocking */
+        if (samplesAvailable < numSamples)
+            FloatVectorOperations::clear (writeBuffer + samplesAvailable, numSamples - samplesAvailable);
+    }
+
+    stream.fifo.finishedRead (samplesAvailable);
+
+    if (samplesAvailable < numSamples)
+    {
+        stream.samplesToSkip += numSamples - samplesAvailable;
+        notify();
+    }
+
+    setTimestampAndSamples (stream.playbackSamplePos, -1.0, numSamples, streamId);
+
+    stream.playbackSamplePos += numSamples;
+
+    if (stream.playbackSamplePos >= stream.stopSample)
+    {
+        if (! loopPlayback)
+            stream.finished = true;
+        else
+            stream.playbackSamplePos = stream.startSample + (stream.playbackSamplePos - stream.stopSample);
+    }
+}
+
+void FileReader::createOverview()
+{
+    overview.reset();
+
+    /* Nobody looks at the scrubber when processing offline */
+    if (AudioComponent* audio = AccessClass::getAudioComponent())
+    {
+        if (audio->isOffline())
+            return;
+    }
+
+    const File file (input->getFileName());
+    const int index = supportedExtensions[file.getFileExtension().toLowerCase().substring (1)];
+
+    std::unique_ptr<FileSource> source (createFileSource (index));
+
+    if (source == nullptr || ! source->openFile (file))
+        return;
+
+    source->setActiveRecord (input->getActiveRecord());
+
+    const File cacheFile = file.getSiblingFile (File::createLegalFileName (input->getRecordName (input->getActiveRecord())) + ".overview");
+
+    overview = std::make_unique<OverviewPyramid> (source.release(), cacheFile);
+    overview->startThread (Thread::Priority::low);
+}
+
+String FileReader::getStreamName (int recordIndex) const
+{
+    String streamName = input->getRecordName (recordIndex);
+
+    /* Only use the original stream name (FileReader-100.example_data -> example_data) */
+    StringArray tokens;
+    tokens.addTokens (streamName, ".");
+    if (tokens.size())
+        streamName = tokens[tokens.size() - 1];
+
+    return streamName;
+}
+
 StringArray FileReader::getSupportedExtensions()
 {
     if (supportedExtensions.size() == 0)
@@ -915,6 +1320,17 @@ FileSource* FileReader::createBuiltInFileSource (int index) const
     }
 }
 
+FileSource* FileReader::createFileSource (int extensionIndex) const
+{
+    if (extensionIndex > 1)
+    {
+        Plugin::FileSourceInfo sourceInfo = AccessClass::getPluginManager()->getFileSourceInfo (extensionIndex - 2);
+        return sourceInfo.creator();
+    }
+
+    return createBuiltInFileSource (0);
+}
+
 ScrubberInterface* FileReader::getScrubberInterface()
 {
     return ((FileReaderEditor*) getEditor())->getScrubberInterface();
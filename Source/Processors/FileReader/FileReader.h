@@ -32,8 +32,10 @@
 #include "../../Utils/Utils.h"
 
 #define BUFFER_WINDOW_CACHE_SIZE 10
+#define SECONDARY_STREAM_BUFFER_SECONDS 2
 
 class ScrubberInterface;
+class OverviewPyramid;
 
 /** Assigns a unique colour to each event channel */
 //TODO: This should ultimately be added to PLUGIN_API / customizable via themes
@@ -126,6 +128,9 @@ public:
     /** Returns the current stream index */
     int getActiveStream() const;
 
+    /** Returns true if every stream in the file is played back, not just the active one */
+    bool isPlayingAllStreams() const { return playAllStreams; }
+
     FileSource* getInputFile() { return input.get(); }
 
     /** Returns the total number of samples per channel */
@@ -167,6 +172,12 @@ public:
     /** Flag whether to loop or stop at the end of playback */
     bool loopPlayback;
 
+    /** Returns the number of times playback caught up with the reader thread since acquisition started */
+    int getNumBufferUnderruns() const { return bufferUnderruns.load(); }
+
+    /** Returns true once playback has reached the stop sample without looping */
+    bool hasFinishedPlayback() const { return playbackFinished.load(); }
+
     /** Converts samples to milliseconds using current stream's sample rate */
     unsigned int samplesToMilliseconds (int64 samples) const;
 
@@ -176,6 +187,12 @@ public:
     /** Swaps the backbuffer to the front and flags the background readerthread to update the new backbuffer */
     void switchBuffer();
 
+    /** Returns the min/max overview of the active stream, or nullptr if there is none */
+    OverviewPyramid* getOverview() { return overview.get(); }
+
+    /** Reads the playback window at a sample number in the background, ahead of a seek there */
+    void prefetchWindow (int64 sampleNumber);
+
     /** Returns a pointer to the ScrubberInterface */
     ScrubberInterface* getScrubberInterface();
 
@@ -192,6 +209,70 @@ private:
     /** Generates any events found within the current continuous buffer interval */
     void addEventsInRange (int64 start, int64 stop);
 
+    /** A stream played back alongside the active stream, with its own file source and read-ahead buffer */
+    struct SecondaryStream
+    {
+        std::unique_ptr<FileSource> source;
+        int numChannels = 0;
+        float sampleRate = 0;
+        int64 numSamples = 0;
+
+        /* Playback range, in this stream's sample numbers */
+        int64 startSample = 0;
+        int64 stopSample = 0;
+
+        /* Next sample to read from file (reader thread) */
+        int64 readPosition = 0;
+
+        /* Next sample number to send downstream (process thread) */
+        int64 playbackSamplePos = 0;
+
+        /* Fraction of a sample carried between blocks */
+        double fractionalSamples = 0;
+
+        /* Set once the end of the playback range is reached without looping */
+        bool finished = false;
+
+        /* Samples the process thread padded with zeros, which the reader thread must skip (never set offline) */
+        std::atomic<int64> samplesToSkip { 0 };
+
+        /* Channel-major ring buffer of read-ahead samples, one fifo-sized run per channel */
+        AbstractFifo fifo { 1 };
+        HeapBlock<float> buffer;
+        HeapBlock<float*> channelPointers;
+    };
+
+    /** Opens one secondary stream per record other than the active one */
+    void createSecondaryStreams();
+
+    /** Recomputes each secondary stream's playback range from the active stream's range */
+    void updateSecondaryStreamRanges();
+
+    /** Moves every secondary stream to the time of an active stream sample and refills its buffer */
+    void resetSecondaryStreams (int64 activeSampleNumber);
+
+    /** Tops up the read-ahead buffer of every secondary stream (reader thread) */
+    void fillSecondaryStreams();
+
+    /** Reads samples from a secondary stream, looping at the end of its playback range if playback loops.
+        Returns the number of samples read. */
+    int readSecondaryStream (SecondaryStream& stream, int ringPosition, int numSamples);
+
+    /** Copies one block of a secondary stream into the output buffer */
+    void processSecondaryStream (SecondaryStream& stream, AudioBuffer<float>& buffer, int channelOffset, uint16 streamId);
+
+    /** Converts an active stream sample number to a secondary stream sample number */
+    int64 toSecondarySample (int64 activeSampleNumber, const SecondaryStream& stream) const;
+
+    /** Starts building the overview of the active stream through a second source on the same file */
+    void createOverview();
+
+    /** Returns the original stream name of a record (FileReader-100.example_data -> example_data) */
+    String getStreamName (int recordIndex) const;
+
+    OwnedArray<SecondaryStream> secondaryStreams;
+    bool playAllStreams;
+
     /** Flag if a new file has been loaded */
     bool gotNewFile;
 
@@ -211,6 +292,8 @@ private:
 
     std::unique_ptr<FileSource> input;
 
+    std::unique_ptr<OverviewPyramid> overview;
+
     /* Pointer to current front buffer */
     HeapBlock<float>* readBuffer;
     HeapBlock<float> bufferA;
@@ -219,11 +302,22 @@ private:
     HashMap<String, int> supportedExtensions;
 
     Atomic<bool> m_shouldFillBackBuffer;
+    Atomic<bool> m_backBufferFilled;
+
+    /* Signalled by the reader thread each time it has refilled the back buffer */
+    WaitableEvent backBufferReady;
+
+    /* Signalled by the reader thread each time it has topped up the secondary streams */
+    WaitableEvent secondaryStreamsReady;
     Atomic<int> m_samplesPerBuffer;
 
     unsigned int m_bufferSize;
     float m_sysSampleRate;
 
+    /* Buffer caches are channel-major, with this many samples per channel */
+    int m_cacheSamplesPerChannel;
+    HeapBlock<float*> m_cacheChannelPointers;
+
     HeapBlock<float>* getFrontBuffer();
     HeapBlock<float>* getBackBuffer();
 
@@ -233,6 +327,15 @@ private:
     /** Reads a chunk of the file that fills an entire buffer cache. */
     void readAndFillBufferCache (HeapBlock<float>& cacheBuffer);
 
+    /** Allocates both buffer caches for the current channel count and audio buffer size */
+    void allocateBufferCache();
+
+    /** Decodes samples from the file straight into a buffer cache, starting at a sample offset */
+    void readIntoBufferCache (HeapBlock<float>& cacheBuffer, int offset, int numSamples);
+
+    /** Asks the source to fetch the read-ahead interval past the reader position (reader thread) */
+    void requestReadAhead();
+
     /** Returns the number of included file sources */
     int getNumBuiltInFileSources() const { return 1; }
 
@@ -242,6 +345,9 @@ private:
     /** Returns a new FileSource object for a given file source */
     FileSource* createBuiltInFileSource (int index) const;
 
+    /** Returns a new FileSource object for a supported extension index */
+    FileSource* createFileSource (int extensionIndex) const;
+
     /** Holds a path to the default file */
     File defaultFile;
 
@@ -250,7 +356,17 @@ private:
     Atomic<int> bufferCacheWindow;
     Atomic<bool> needsBufferReset;
 
-    bool firstProcess;
+    std::atomic<bool> playbackFinished { false };
+
+    /* Read-ahead requested from the source, and the interval last requested */
+    float readAheadSeconds;
+    int64 readAheadFrom;
+    int64 readAheadTo;
+
+    std::atomic<int> bufferUnderruns { 0 };
+
+    /* Offline processing waits for the reader thread instead of underrunning */
+    bool waitForReader;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileReader);
 };
@@ -124,3 +124,30 @@ bool FileSource::isReady()
 {
     return true;
 }
+
+void FileSource::prefetch (int64 startSample, int64 nSamples)
+{
+}
+
+int FileSource::readPlanarData (float* const* channelBuffers, int nSamples)
+{
+    const int numChannels = getActiveNumChannels();
+
+    if (interleavedScratchSize < size_t (nSamples * numChannels))
+    {
+        interleavedScratchSize = size_t (nSamples * numChannels);
+        interleavedScratch.malloc (interleavedScratchSize);
+    }
+
+    const int samplesRead = readData (interleavedScratch, nSamples);
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const float* source = interleavedScratch + ch;
+
+        for (int i = 0; i < samplesRead; i++)
+            channelBuffers[ch][i] = source[i * numChannels];
+    }
+
+    return samplesRead;
+}
@@ -96,6 +96,20 @@ public:
     /** Return false if file is not able to be opened */
     virtual bool isReady();
 
+    /** Read in nSamples of float data straight into one buffer per channel;
+    return the number of samples actually read
+
+    channelBuffers holds one pointer per channel of the active recording. The default
+    implementation reads interleaved data with readData() and transposes it; sources
+    that can decode directly into channel-major buffers should override this.
+
+    */
+    virtual int readPlanarData (float* const* channelBuffers, int nSamples);
+
+    /** Hints that a range of samples of the active recording will be read soon, so that
+    the source can start fetching it from storage without blocking. The default does nothing. */
+    virtual void prefetch (int64 startSample, int64 nSamples);
+
     // ------------------------------------------------------------
     //                    OTHER METHODS
     //                (used by File Reader)
@@ -164,6 +178,10 @@ protected:
     /** Holds information about event channels in a recording */
     std::map<String, EventInfo> eventInfoMap;
 
+    /** Interleaved buffer used by the default readPlanarData() */
+    HeapBlock<float> interleavedScratch;
+    size_t interleavedScratchSize = 0;
+
     bool fileOpened = false;
     int numRecords = 0;
     Atomic<int> activeRecord = -1; // atomic to protect against threaded data race in FileReader
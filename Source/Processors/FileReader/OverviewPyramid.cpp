@@ -0,0 +1,296 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "OverviewPyramid.h"
+
+#include "../../Utils/Utils.h"
+
+#include <cmath>
+
+/* Cache file header: magic, version, then the stream shape it was built from */
+static const int OVERVIEW_CACHE_MAGIC = 0x5652564f; // "OVRV"
+static const int OVERVIEW_CACHE_VERSION = 1;
+
+OverviewPyramid::OverviewPyramid (FileSource* source_, const File& cacheFile_)
+    : Thread ("Overview Builder"),
+      source (source_),
+      cacheFile (cacheFile_),
+      numChannels (source_->getActiveNumChannels()),
+      numSamples (numChannels > 0 ? source_->getActiveNumSamples() : 0),
+      readSamples (jmax (1, numChannels))
+{
+    if (numSamples <= 0)
+        return;
+
+    readSamples = jmax (1, OVERVIEW_READ_FLOATS / numChannels / OVERVIEW_BIN_SAMPLES) * OVERVIEW_BIN_SAMPLES;
+
+    baseLevel.resize (size_t ((numSamples + OVERVIEW_BIN_SAMPLES - 1) / OVERVIEW_BIN_SAMPLES));
+
+    readBuffer.malloc (size_t (numChannels) * readSamples);
+    channelPointers.malloc (numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channelPointers[ch] = readBuffer + size_t (ch) * readSamples;
+}
+
+OverviewPyramid::~OverviewPyramid()
+{
+    stopThread (1000);
+}
+
+void OverviewPyramid::run()
+{
+    if (baseLevel.empty())
+        return;
+
+    if (! loadCache())
+    {
+        for (int64 sample = 0; sample < numSamples; sample += readSamples)
+        {
+            if (threadShouldExit())
+                return;
+
+            /* A pending seek takes priority over the overview */
+            servePrefetch();
+
+            source->seekTo (sample);
+            summarize (sample / OVERVIEW_BIN_SAMPLES, int (jmin<int64> (readSamples, numSamples - sample)));
+        }
+
+        if (baseLevel.size() >= OVERVIEW_CACHE_MIN_BINS)
+            saveCache();
+    }
+
+    buildCoarserLevels();
+    complete.store (true, std::memory_order_release);
+
+    while (! threadShouldExit())
+    {
+        servePrefetch();
+        wait (-1);
+    }
+}
+
+void OverviewPyramid::summarize (int64 firstBin, int numSamplesToRead)
+{
+    const int numRead = source->readPlanarData (channelPointers, numSamplesToRead);
+
+    for (int offset = 0; offset < numRead; offset += OVERVIEW_BIN_SAMPLES)
+    {
+        const int binLength = jmin (OVERVIEW_BIN_SAMPLES, numRead - offset);
+
+        Bin bin { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0f };
+        double sumSquares = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* data = channelPointers[ch] + offset;
+            const Range<float> range = FloatVectorOperations::findMinAndMax (data, binLength);
+
+            bin.min = jmin (bin.min, range.getStart());
+            bin.max = jmax (bin.max, range.getEnd());
+
+            float channelSquares = 0;
+
+            for (int i = 0; i < binLength; ++i)
+                channelSquares += data[i] * data[i];
+
+            sumSquares += channelSquares;
+        }
+
+        bin.rms = float (std::sqrt (sumSquares / (double (binLength) * numChannels)));
+        baseLevel[size_t (firstBin + offset / OVERVIEW_BIN_SAMPLES)] = bin;
+    }
+
+    binsReady.store (firstBin + (numRead + OVERVIEW_BIN_SAMPLES - 1) / OVERVIEW_BIN_SAMPLES, std::memory_order_release);
+}
+
+void OverviewPyramid::prefetch (int64 sampleNumber, int numSamplesToPrefetch)
+{
+    if (numSamples <= 0)
+        return;
+
+    prefetchSamples.store (numSamplesToPrefetch);
+    prefetchSample.store (jlimit<int64> (0, numSamples - 1, sampleNumber));
+    notify();
+}
+
+void OverviewPyramid::servePrefetch()
+{
+    const int64 sample = prefetchSample.exchange (-1);
+
+    if (sample < 0)
+        return;
+
+    /* Reading through our own mapping of the file faults its pages into the OS cache,
+       which the File Reader's mapping then shares */
+    int remaining = prefetchSamples.load();
+
+    source->seekTo (sample);
+
+    while (remaining > 0 && ! threadShouldExit())
+    {
+        const int numRead = source->readPlanarData (channelPointers, jmin (remaining, readSamples));
+
+        if (numRead <= 0)
+            break;
+
+        remaining -= numRead;
+    }
+}
+
+void OverviewPyramid::buildCoarserLevels()
+{
+    const std::vector<Bin>* finer = &baseLevel;
+
+    while (finer->size() > 1)
+    {
+        std::vector<Bin> level ((finer->size() + 1) / 2);
+
+        for (size_t i = 0; i < level.size(); ++i)
+        {
+            const Bin& a = (*finer)[2 * i];
+
+            if (2 * i + 1 < finer->size())
+            {
+                const Bin& b = (*finer)[2 * i + 1];
+                level[i] = { jmin (a.min, b.min), jmax (a.max, b.max), std::sqrt (0.5f * (a.rms * a.rms + b.rms * b.rms)) };
+            }
+            else
+            {
+                level[i] = a;
+            }
+        }
+
+        coarserLevels.push_back (std::move (level));
+        finer = &coarserLevels.back();
+    }
+}
+
+int OverviewPyramid::getOverview (int64 startSample, int64 stopSample, int numPixels, std::vector<Bin>& pixels) const
+{
+    pixels.resize (size_t (jmax (0, numPixels)));
+
+    startSample = jmax<int64> (0, startSample);
+
+    if (numPixels <= 0 || stopSample <= startSample || baseLevel.empty())
+        return 0;
+
+    const bool allLevels = complete.load (std::memory_order_acquire);
+    const double samplesPerPixel = double (stopSample - startSample) / numPixels;
+
+    /* Coarser levels only exist once the finest one is complete */
+    size_t level = 0;
+
+    if (allLevels)
+    {
+        while (level < coarserLevels.size() && double (int64 (OVERVIEW_BIN_SAMPLES) << (level + 1)) <= samplesPerPixel)
+            level++;
+    }
+
+    const std::vector<Bin>& bins = level == 0 ? baseLevel : coarserLevels[level - 1];
+    const int64 binSamples = int64 (OVERVIEW_BIN_SAMPLES) << level;
+    const int64 availableBins = level == 0 && ! allLevels ? binsReady.load (std::memory_order_acquire) : int64 (bins.size());
+
+    for (int px = 0; px < numPixels; ++px)
+    {
+        const int64 first = (startSample + int64 (px * samplesPerPixel)) / binSamples;
+        int64 last = (startSample + int64 ((px + 1) * samplesPerPixel) + binSamples - 1) / binSamples;
+        last = jmin (jmax (first + 1, last), availableBins);
+
+        if (first >= last)
+            return px;
+
+        Bin pixel = bins[size_t (first)];
+        double sumSquares = double (pixel.rms) * pixel.rms;
+
+        for (int64 b = first + 1; b < last; ++b)
+        {
+            const Bin& bin = bins[size_t (b)];
+            pixel.min = jmin (pixel.min, bin.min);
+            pixel.max = jmax (pixel.max, bin.max);
+            sumSquares += double (bin.rms) * bin.rms;
+        }
+
+        pixel.rms = float (std::sqrt (sumSquares / double (last - first)));
+        pixels[size_t (px)] = pixel;
+    }
+
+    return numPixels;
+}
+
+float OverviewPyramid::getProgress() const
+{
+    if (baseLevel.empty() || complete.load())
+        return 1.0f;
+
+    return float (binsReady.load()) / float (baseLevel.size());
+}
+
+bool OverviewPyramid::loadCache()
+{
+    if (! cacheFile.existsAsFile()
+        || cacheFile.getLastModificationTime() < File (source->getFileName()).getLastModificationTime())
+        return false;
+
+    FileInputStream input (cacheFile);
+
+    if (! input.openedOk()
+        || input.readInt() != OVERVIEW_CACHE_MAGIC
+        || input.readInt() != OVERVIEW_CACHE_VERSION
+        || input.readInt64() != numSamples
+        || input.readInt() != numChannels
+        || input.readInt() != OVERVIEW_BIN_SAMPLES
+        || input.readInt64() != int64 (baseLevel.size()))
+        return false;
+
+    const int numBytes = int (baseLevel.size() * sizeof (Bin));
+
+    if (input.read (baseLevel.data(), numBytes) != numBytes)
+        return false;
+
+    binsReady.store (int64 (baseLevel.size()), std::memory_order_release);
+
+    return true;
+}
+
+void OverviewPyramid::saveCache() const
+{
+    cacheFile.deleteFile();
+
+    FileOutputStream output (cacheFile);
+
+    if (! output.openedOk())
+    {
+        LOGD ("Unable to cache File Reader overview at ", cacheFile.getFullPathName());
+        return;
+    }
+
+    output.writeInt (OVERVIEW_CACHE_MAGIC);
+    output.writeInt (OVERVIEW_CACHE_VERSION);
+    output.writeInt64 (numSamples);
+    output.writeInt (numChannels);
+    output.writeInt (OVERVIEW_BIN_SAMPLES);
+    output.writeInt64 (int64 (baseLevel.size()));
+    output.write (baseLevel.data(), baseLevel.size() * sizeof (Bin));
+}
@@ -0,0 +1,124 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __OVERVIEWPYRAMID_H__
+#define __OVERVIEWPYRAMID_H__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+#include "../../TestableExport.h"
+#include "FileSource.h"
+
+#include <atomic>
+#include <vector>
+
+#define OVERVIEW_BIN_SAMPLES 1024
+#define OVERVIEW_READ_FLOATS (1 << 22)
+#define OVERVIEW_CACHE_MIN_BINS 4096
+
+/**
+    A multi-resolution min/max/RMS summary of one recorded stream, used by
+    the File Reader's scrubber to draw a whole session at once.
+
+    The finest level holds one bin per OVERVIEW_BIN_SAMPLES samples, taken
+    across all channels; each coarser level merges pairs of bins. The levels
+    are built on a background thread through the pyramid's own FileSource,
+    so playback is never blocked, and the finest level is cached in a file
+    beside the recording so that reopening a long recording is instant.
+
+    The same thread prefetches the playback window around a pending seek,
+    so the File Reader's synchronous seek finds the data in the page cache.
+
+    @see ScrubberInterface
+*/
+class TESTABLE OverviewPyramid : public Thread
+{
+public:
+    struct Bin
+    {
+        float min;
+        float max;
+        float rms;
+    };
+
+    /** Takes ownership of a source opened on the stream to summarize */
+    OverviewPyramid (FileSource* source, const File& cacheFile);
+
+    /** Destructor */
+    ~OverviewPyramid() override;
+
+    /** Summarizes [startSample, stopSample) of the stream into numPixels bins, using the
+        coarsest level that still resolves each pixel. Returns the number of leading
+        pixels for which data is available yet. */
+    int getOverview (int64 startSample, int64 stopSample, int numPixels, std::vector<Bin>& pixels) const;
+
+    /** Returns the fraction of the stream summarized so far */
+    float getProgress() const;
+
+    /** Asks the background thread to read a window of samples ahead of a seek */
+    void prefetch (int64 sampleNumber, int numSamples);
+
+private:
+    /** Builds (or loads) the levels, then serves prefetch requests */
+    void run() override;
+
+    /** Summarizes one read of the stream into the finest level, starting at a bin index */
+    void summarize (int64 firstBin, int numSamples);
+
+    /** Serves a pending prefetch request, if any */
+    void servePrefetch();
+
+    /** Builds the coarser levels from the finest one */
+    void buildCoarserLevels();
+
+    /** Loads the finest level from the cache file; returns false if it is missing or stale */
+    bool loadCache();
+
+    /** Saves the finest level to the cache file */
+    void saveCache() const;
+
+    std::unique_ptr<FileSource> source;
+    File cacheFile;
+
+    int numChannels;
+    int64 numSamples;
+    int readSamples;
+
+    /* Finest level, allocated up front; bins below binsReady are final */
+    std::vector<Bin> baseLevel;
+    std::atomic<int64> binsReady { 0 };
+
+    /* Coarser levels, readable once complete is set */
+    std::vector<std::vector<Bin>> coarserLevels;
+    std::atomic<bool> complete { false };
+
+    std::atomic<int64> prefetchSample { -1 };
+    std::atomic<int> prefetchSamples { 0 };
+
+    HeapBlock<float> readBuffer;
+    HeapBlock<float*> channelPointers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OverviewPyramid);
+};
+
+#endif // __OVERVIEWPYRAMID_H__
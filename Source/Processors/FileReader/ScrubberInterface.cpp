@@ -23,6 +23,41 @@
 
 #include "ScrubberInterface.h"
 
+void Timeline::drawOverview (Graphics& g, int64 startSample, int64 stopSample, Rectangle<int> area)
+{
+    OverviewPyramid* overview = fileReader->getOverview();
+
+    if (overview == nullptr || area.isEmpty())
+        return;
+
+    const int numPixels = overview->getOverview (startSample, stopSample, area.getWidth(), overviewPixels);
+
+    /* Scale to the largest excursion in view */
+    float peak = 0;
+
+    for (int i = 0; i < numPixels; i++)
+        peak = jmax (peak, std::abs (overviewPixels[i].min), std::abs (overviewPixels[i].max));
+
+    if (peak <= 0)
+        return;
+
+    const float centre = area.getCentreY();
+    const float scale = 0.5f * area.getHeight() / peak;
+
+    g.setColour (findColour (ThemeColours::defaultText).withAlpha (0.25f));
+
+    for (int i = 0; i < numPixels; i++)
+        g.drawVerticalLine (area.getX() + i, centre - overviewPixels[i].max * scale, centre - overviewPixels[i].min * scale + 1);
+
+    g.setColour (findColour (ThemeColours::defaultText).withAlpha (0.4f));
+
+    for (int i = 0; i < numPixels; i++)
+    {
+        const float rms = jmin (overviewPixels[i].rms * scale, 0.5f * area.getHeight());
+        g.drawVerticalLine (area.getX() + i, centre - rms, centre + rms + 1);
+    }
+}
+
 void FullTimeline::paint (Graphics& g)
 {
     /* Draw timeline background */
@@ -46,14 +81,17 @@ void FullTimeline::paint (Graphics& g)
     g.setColour (findColour (ThemeColours::widgetBackground));
     g.fillRect (borderThickness, borderThickness, this->getWidth() - 2 * borderThickness, this->getHeight() - 2 * borderThickness - tickHeight);
 
-    /* Draw a coloured vertical bar for each event */
-
     float sampleRate = fileReader->getCurrentSampleRate();
     int64 totalSamples = (stopMs - startMs) / 1000.0f * sampleRate;
 
     int64 startSample = startMs / 1000.0f * sampleRate;
     int64 stopSample = stopMs / 1000.0f * sampleRate;
 
+    /* Draw the signal envelope of the whole playback range */
+    drawOverview (g, startSample, stopSample, Rectangle<int> (borderThickness, borderThickness, getWidth() - 2 * borderThickness, getHeight() - 2 * borderThickness - tickHeight));
+
+    /* Draw a coloured vertical bar for each event */
+
     std::map<int, bool> eventMap; //keeps track of events that would get rendered at the same timeline position
 
     for (auto info : fileReader->getActiveEventInfo())
@@ -148,6 +186,9 @@ void FullTimeline::mouseDrag (const MouseEvent& event)
     {
         if (event.x >= intervalWidth / 2 && event.x < getWidth() - intervalWidth / 2)
             intervalStartPosition = event.x - intervalWidth / 2;
+
+        // Start reading the data under the interval before the seek on mouse up needs it
+        fileReader->prefetchWindow (float (getStartInterval()) / float (getWidth()) * fileReader->getCurrentNumTotalSamples() + fileReader->getPlaybackStart());
     }
 
     repaint();
@@ -200,6 +241,9 @@ void ZoomTimeline::paint (Graphics& g)
     int64 startSampleNumber = float (startMs) / 1000.0f * sampleRate + offset;
     int64 stopSampleNumber = startSampleNumber + intervalSamples;
 
+    /* Draw the signal envelope of the zoomed interval */
+    drawOverview (g, startSampleNumber, stopSampleNumber, Rectangle<int> (borderThickness, tickHeight + borderThickness, getWidth() - 2 * borderThickness, getHeight() - 2 * borderThickness - tickHeight));
+
     for (auto info : fileReader->getActiveEventInfo())
     {
         for (int i = 0; i < info.sampleNumbers.size(); i++)
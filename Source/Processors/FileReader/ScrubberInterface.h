@@ -29,6 +29,7 @@
 
 #include "FileReader.h"
 #include "FileReaderEditor.h"
+#include "OverviewPyramid.h"
 
 #define MAX_ZOOM_DURATION_IN_SECONDS 30.0f
 
@@ -56,6 +57,11 @@ protected:
     int startMs = 0;
     int stopMs = 0;
 
+    /** Draws the min/max and RMS envelope of a range of samples, as far as the overview is built */
+    void drawOverview (Graphics& g, int64 startSample, int64 stopSample, Rectangle<int> area);
+
+    std::vector<OverviewPyramid::Bin> overviewPixels;
+
     void paint (Graphics& g) override = 0;
     void mouseDown (const MouseEvent& event) override = 0;
     void mouseDrag (const MouseEvent& event) override = 0;
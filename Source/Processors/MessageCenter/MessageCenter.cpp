@@ -29,12 +29,18 @@
 
 #include "../Events/Event.h"
 
-#define MAX_MSG_LENGTH 512
 //---------------------------------------------------------------------
 
 MessageCenter::MessageCenter() : GenericProcessor ("Message Center"),
-                                 newEventAvailable (false)
+                                 enqueuePosition (0),
+                                 dequeuePosition (0),
+                                 numDroppedMessages (0)
 {
+    for (uint32 i = 0; i < MESSAGE_QUEUE_SIZE; i++)
+        messageSlots[i].sequence.store (i, std::memory_order_relaxed);
+
+    heldMessages.reserve (MESSAGE_QUEUE_SIZE);
+
     setPlayConfigDetails (0, // number of inputs
                           0, // number of outputs
                           44100.0, // sampleRate
@@ -83,6 +89,8 @@ AudioProcessorEditor* MessageCenter::createEditor()
 
 bool MessageCenter::startAcquisition()
 {
+    numDroppedMessages.store (0);
+
     if (messageCenterEditor != nullptr)
         messageCenterEditor->startAcquisition();
 
@@ -91,6 +99,11 @@ bool MessageCenter::startAcquisition()
 
 bool MessageCenter::stopAcquisition()
 {
+    const int numDropped = numDroppedMessages.load();
+
+    if (numDropped > 0)
+        LOGE ("Message Center dropped ", numDropped, " messages because its queue or held list was full");
+
     if (messageCenterEditor != nullptr)
         messageCenterEditor->stopAcquisition();
 
@@ -113,14 +126,6 @@ DataStream* MessageCenter::getMessageStream()
     return nullptr;
 }
 
-void MessageCenter::setParameter (int parameterIndex, float newValue)
-{
-    if (parameterIndex == 1)
-    {
-        newEventAvailable = true;
-    }
-}
-
 void MessageCenter::actionListenerCallback (const String& message)
 {
     if (messageCenterEditor != nullptr)
@@ -136,10 +141,87 @@ void MessageCenter::broadcastMessage (const String& msg)
 
 void MessageCenter::broadcastMessage (const String& msg, const int64 systemTimeMilliseconds)
 {
-    Message newMessage { msg, systemTimeMilliseconds };
-    messageQueue.push (newMessage);
+    broadcastMessage (msg, systemTimeMilliseconds, -1);
+}
+
+bool MessageCenter::broadcastMessage (const String& msg, const int64 systemTimeMilliseconds, const int64 targetSampleNumber)
+{
+    // callers may be on the audio thread, so a full queue drops the message instead of waiting for the next block
+    if (! pushMessage (msg, systemTimeMilliseconds, targetSampleNumber))
+    {
+        numDroppedMessages.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
 
-    setParameter (1, 1);
+    return true;
+}
+
+bool MessageCenter::pushMessage (const String& msg, int64 systemTimeMilliseconds, int64 targetSampleNumber)
+{
+    uint32 position = enqueuePosition.load (std::memory_order_relaxed);
+    MessageSlot* slot;
+
+    for (;;)
+    {
+        slot = &messageSlots[position % MESSAGE_QUEUE_SIZE];
+
+        const int32 difference = int32 (slot->sequence.load (std::memory_order_acquire) - position);
+
+        if (difference == 0)
+        {
+            // the slot is free: claim it
+            if (enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            return false; // the consumer has not freed this slot yet
+        }
+        else
+        {
+            position = enqueuePosition.load (std::memory_order_relaxed); // another producer claimed it
+        }
+    }
+
+    msg.substring (0, MAX_MSG_LENGTH).copyToUTF8 (slot->text, sizeof (slot->text));
+    slot->systemTimeMilliseconds = systemTimeMilliseconds;
+    slot->targetSampleNumber = targetSampleNumber;
+
+    slot->sequence.store (position + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool MessageCenter::popMessage (Message& message)
+{
+    const uint32 position = dequeuePosition.load (std::memory_order_relaxed);
+    MessageSlot& slot = messageSlots[position % MESSAGE_QUEUE_SIZE];
+
+    if (slot.sequence.load (std::memory_order_acquire) != position + 1)
+        return false;
+
+    message.message = String::fromUTF8 (slot.text);
+    message.systemTimeMilliseconds = slot.systemTimeMilliseconds;
+    message.targetSampleNumber = slot.targetSampleNumber;
+
+    // hand the slot back to the producers, one lap later
+    slot.sequence.store (position + MESSAGE_QUEUE_SIZE, std::memory_order_release);
+    dequeuePosition.store (position + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+int MessageCenter::getNumQueuedMessages() const
+{
+    // read the consumer's position first, so the difference is never negative
+    const uint32 dequeued = dequeuePosition.load (std::memory_order_relaxed);
+
+    return int (enqueuePosition.load (std::memory_order_relaxed) - dequeued);
+}
+
+int MessageCenter::getNumDroppedMessages() const
+{
+    return numDroppedMessages.load (std::memory_order_relaxed);
 }
 
 void MessageCenter::addOutgoingMessage (const String& msg, const int64 systemTimeMilliseconds)
@@ -198,29 +280,51 @@ void MessageCenter::loadStateFromXml (XmlElement* parent)
     }
 }
 
-void MessageCenter::process (AudioBuffer<float>& buffer)
+void MessageCenter::sendMessage (const Message& message)
 {
-    if (newEventAvailable)
-    {
-        while (! messageQueue.empty())
-        {
-            Message message = messageQueue.front();
+    const int64 sampleNumber = message.targetSampleNumber >= 0 ? message.targetSampleNumber
+                                                                : message.systemTimeMilliseconds;
 
-            String eventString = message.message;
+    TextEventPtr event = TextEvent::createTextEvent (eventChannels[0],
+                                                     sampleNumber,
+                                                     message.message);
 
-            eventString.dropLastCharacters (eventString.length() - MAX_MSG_LENGTH);
+    addEvent (event, 0);
 
-            TextEventPtr event = TextEvent::createTextEvent (eventChannels[0],
-                                                             message.systemTimeMilliseconds,
-                                                             eventString);
-
-            addEvent (event, 0);
+    LOGD ("Message Center sending message: ", message.message);
+}
 
-            messageQueue.pop();
+void MessageCenter::process (AudioBuffer<float>& buffer)
+{
+    // the message stream counts samples in ms of system time
+    const int64 currentSampleNumber = CoreServices::getSystemTime();
 
-            LOGD ("Message Center sending message: ", eventString);
+    // first, messages that were held for this block or an earlier one
+    if (heldMessages.size() > 0)
+    {
+        auto firstHeld = heldMessages.begin();
 
-            newEventAvailable = false;
+        for (auto& message : heldMessages)
+        {
+            if (message.targetSampleNumber <= currentSampleNumber)
+                sendMessage (message);
+            else
+                *firstHeld++ = message;
         }
+
+        heldMessages.erase (firstHeld, heldMessages.end());
+    }
+
+    // then everything that has been queued since the last block
+    Message message;
+
+    while (popMessage (message))
+    {
+        if (message.targetSampleNumber <= currentSampleNumber)
+            sendMessage (message);
+        else if (heldMessages.size() < heldMessages.capacity())
+            heldMessages.push_back (message);
+        else
+            numDroppedMessages.fetch_add (1, std::memory_order_relaxed);
     }
 }
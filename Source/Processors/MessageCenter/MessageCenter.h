@@ -26,17 +26,24 @@
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../../TestableExport.h"
-#include <queue>
+#include <atomic>
 #include <stdio.h>
+#include <vector>
 
 #include "../GenericProcessor/GenericProcessor.h"
 #include "MessageCenterEditor.h"
 
+#define MAX_MSG_LENGTH 512
+#define MESSAGE_QUEUE_SIZE 256 // must be a power of 2
+
 /**
 
   Allows the application to display messages to the user.
 
   Also distributes broadcast messages to all plugins in the signal chain.
+  Messages can be broadcast from any thread: they pass through a bounded,
+  lock-free multi-producer queue with preallocated slots, and every pending
+  message is sent in the next processing block.
 
   The MessageCenter is located along the bottom left of the application window.
 
@@ -58,9 +65,6 @@ public:
     /** Handle incoming data and decide which files and events to write to disk. */
     void process (AudioBuffer<float>& buffer) override;
 
-    /** Called when new events arrive. */
-    void setParameter (int parameterIndex, float newValue) override;
-
     /** Creates the MessageCenterEditor (located in the UI component). */
     AudioProcessorEditor* createEditor() override;
 
@@ -88,6 +92,17 @@ public:
     /** Sends a broadcast message to all processors for a specified system time */
     void broadcastMessage (const String& msg, const int64 systemTimeMilliseconds);
 
+    /** Sends a broadcast message stamped with a target sample number of the message stream
+        (i.e., system time in ms); it is held until the first block that reaches that sample.
+        Never waits: if the queue is full, the message is dropped and counted, and false is returned. */
+    bool broadcastMessage (const String& msg, const int64 systemTimeMilliseconds, const int64 targetSampleNumber);
+
+    /** Returns the number of messages waiting in the queue */
+    int getNumQueuedMessages() const;
+
+    /** Returns the number of messages dropped since acquisition started because the queue or the held list was full */
+    int getNumDroppedMessages() const;
+
     /** Sends a broadcast message and adds it to the editor */
     void addOutgoingMessage (const String& msg, const int64 systemTimeMilliseconds);
 
@@ -111,17 +126,45 @@ private:
     ScopedPointer<MessageCenterEditor> messageCenterEditor;
 
     /** Holds a message string, plus the system time at
-    which the message was created */
+    which the message was created and an optional sample
+    number (-1 if none) at which it should be sent */
     struct Message
     {
         String message;
         int64 systemTimeMilliseconds;
+        int64 targetSampleNumber;
+    };
+
+    /** One preallocated slot of the message queue; its sequence number
+    tells producers and the consumer whose turn it is */
+    struct MessageSlot
+    {
+        std::atomic<uint32> sequence;
+        char text[MAX_MSG_LENGTH * 4 + 1]; // UTF-8
+        int64 systemTimeMilliseconds;
+        int64 targetSampleNumber;
     };
 
+    /** Claims a slot and copies a message into it; returns false if the queue is full */
+    bool pushMessage (const String& msg, int64 systemTimeMilliseconds, int64 targetSampleNumber);
+
+    /** Takes the oldest message from the queue (processing thread only) */
+    bool popMessage (Message& message);
+
+    /** Sends a message as a text event */
+    void sendMessage (const Message& message);
+
     /** Holds incoming messages */
-    std::queue<Message> messageQueue;
+    MessageSlot messageSlots[MESSAGE_QUEUE_SIZE];
+
+    std::atomic<uint32> enqueuePosition;
+    std::atomic<uint32> dequeuePosition;
+
+    /** Counted rather than logged, since messages may be dropped on the audio thread */
+    std::atomic<int> numDroppedMessages;
 
-    bool newEventAvailable;
+    /** Messages whose target sample has not been reached yet; once MESSAGE_QUEUE_SIZE are held, further ones are dropped */
+    std::vector<Message> heldMessages;
 
     ScopedPointer<EventChannel> eventChannel;
 
@@ -1849,6 +1849,43 @@ Array<RecordNode*> ProcessorGraph::getRecordNodes()
     return recordNodes;
 }
 
+bool ProcessorGraph::allFileReadersLoaded()
+{
+    int numFileReaders = 0;
+
+    for (auto* processor : rootNodes)
+    {
+        if (processor->getName() != "File Reader")
+            continue;
+
+        numFileReaders++;
+
+        // a file that fails to open leaves the File Reader without input, and disabled
+        if (! processor->isEnabled || static_cast<FileReader*> (processor)->getFile().isEmpty())
+            return false;
+    }
+
+    return numFileReaders > 0;
+}
+
+bool ProcessorGraph::allFileReadersFinished()
+{
+    int numFileReaders = 0;
+
+    for (auto* processor : rootNodes)
+    {
+        if (processor->getName() != "File Reader")
+            continue;
+
+        numFileReaders++;
+
+        if (! static_cast<FileReader*> (processor)->hasFinishedPlayback())
+            return false;
+    }
+
+    return numFileReaders > 0;
+}
+
 MessageCenter* ProcessorGraph::getMessageCenter()
 {
     Node* node = getNodeForId (NodeID (MESSAGE_CENTER_ID));
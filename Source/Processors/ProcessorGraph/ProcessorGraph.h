@@ -145,6 +145,12 @@ public:
     /* Returns a list of all RecordNodes in the signal chain*/
     Array<RecordNode*> getRecordNodes();
 
+    /* Returns true if the signal chain has at least one File Reader, and all of them have a file they can play*/
+    bool allFileReadersLoaded();
+
+    /* Returns true if the signal chain has at least one File Reader, and all of them have reached the end of playback*/
+    bool allFileReadersFinished();
+
     /* Returns a pointer to the AudioNode processor*/
     AudioNode* getAudioNode();
 
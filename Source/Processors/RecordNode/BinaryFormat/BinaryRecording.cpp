@@ -32,12 +32,20 @@
 
 #define MAX_BUFFER_SIZE 40960
 
+/* Order and relative cutoff (fraction of the decimated Nyquist frequency) of the LFP anti-aliasing filter */
+#define LFP_FILTER_ORDER 8
+#define LFP_CUTOFF_FRACTION 0.8
+
+/* Longest channel-major chunk; the writer buffers two chunks of every channel */
+#define MAX_CHANNEL_MAJOR_CHUNK_MS 5000
+
 BinaryRecording::BinaryRecording()
 {
     m_bufferSize = MAX_BUFFER_SIZE;
     m_scaledBuffer.malloc (MAX_BUFFER_SIZE);
     m_intBuffer.malloc (MAX_BUFFER_SIZE);
     m_sampleNumberBuffer.malloc (MAX_BUFFER_SIZE);
+    m_lfpTimestampBuffer.malloc (MAX_BUFFER_SIZE);
 }
 
 BinaryRecording::~BinaryRecording() {}
@@ -138,16 +146,32 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
         streamIndex++;
 
         String datPath = getProcessorString (ch);
-        String filename = contPath + datPath + "continuous.dat";
 
-        LOGD ("Creating file: ", contPath, datPath, "sample_numbers.npy");
-        ScopedPointer<NpyFile> tFile = new NpyFile (contPath + datPath + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
-        m_dataTimestampFiles.add (tFile.release());
+        DynamicObject::Ptr fileJSON = new DynamicObject();
+
+        if (m_compactTimestamps)
+        {
+            LOGD ("Creating file: ", contPath, datPath, "timestamp_segments.npy");
+            Array<NpyType> segmentTypes;
+            segmentTypes.add (NpyType ("sample_number", BaseType::INT64, 1));
+            segmentTypes.add (NpyType ("timestamp", BaseType::DOUBLE, 1));
+            segmentTypes.add (NpyType ("sample_rate", BaseType::DOUBLE, 1));
+            segmentTypes.add (NpyType ("num_samples", BaseType::INT64, 1));
+            m_timestampSegmentFiles.add (createNpyFile (contPath + datPath + "timestamp_segments.npy", segmentTypes));
+            m_timestampSegments.add ({ 0, 0.0, 0.0, 0 });
+
+            fileJSON->setProperty ("timestamp_format", "segments");
+        }
+        else
+        {
+            LOGD ("Creating file: ", contPath, datPath, "sample_numbers.npy");
+            ScopedPointer<NpyFile> tFile = createNpyFile (contPath + datPath + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
+            m_dataTimestampFiles.add (tFile.release());
 
-        ScopedPointer<NpyFile> syncTimestampFile = new NpyFile (contPath + datPath + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
-        m_dataSyncTimestampFiles.add (syncTimestampFile.release());
+            ScopedPointer<NpyFile> syncTimestampFile = createNpyFile (contPath + datPath + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
+            m_dataSyncTimestampFiles.add (syncTimestampFile.release());
+        }
 
-        DynamicObject::Ptr fileJSON = new DynamicObject();
         fileJSON->setProperty ("folder_name", datPath.replace (File::getSeparatorString(), "/")); //to make it more system agnostic, replace separator with only one slash
         fileJSON->setProperty ("sample_rate", ch->getSampleRate());
         fileJSON->setProperty ("source_processor_name", ch->getSourceNodeName());
@@ -157,16 +181,21 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
         fileJSON->setProperty ("recorded_processor_id", ch->getNodeId());
         fileJSON->setProperty ("num_channels", channelCounts[streamIndex]);
 
-        ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile (channelCounts[streamIndex], samplesPerBlock);
-
-        if (bFile->openFile (filename))
-            m_continuousFiles.add (bFile.release());
-        else
-            m_continuousFiles.add (nullptr);
+        m_continuousFiles.add (createContinuousFile (contPath + datPath, channelCounts[streamIndex], fileJSON));
 
         fileJSON->setProperty ("channels", multiStreamJSON.getReference (streamIndex));
 
         continuousChannelJSON.add (var (fileJSON));
+
+        if (isLfpStream (ch))
+        {
+            m_lfpIndexes.add (m_lfpFiles.size());
+            createLfpStream (contPath, ch, channelCounts[streamIndex], multiStreamJSON.getReference (streamIndex), continuousChannelJSON);
+        }
+        else
+        {
+            m_lfpIndexes.add (-1);
+        }
     }
 
     //Event data files
@@ -209,12 +238,12 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
         ScopedPointer<EventRecording> rec = new EventRecording();
 
-        rec->data = std::make_unique<NpyFile> (eventPath + eventName + dataFileName + ".npy", type);
-        rec->samples = std::make_unique<NpyFile> (eventPath + eventName + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
-        rec->timestamps = std::make_unique<NpyFile> (eventPath + eventName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
+        rec->data = std::unique_ptr<NpyFile> (createNpyFile (eventPath + eventName + dataFileName + ".npy", type));
+        rec->samples = std::unique_ptr<NpyFile> (createNpyFile (eventPath + eventName + "sample_numbers.npy", NpyType (BaseType::INT64, 1)));
+        rec->timestamps = std::unique_ptr<NpyFile> (createNpyFile (eventPath + eventName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1)));
         if (chan->getType() == EventChannel::TTL && m_saveTTLWords)
         {
-            rec->extraFile = std::make_unique<NpyFile> (eventPath + eventName + "full_words.npy", NpyType (BaseType::UINT64, 1));
+            rec->extraFile = std::unique_ptr<NpyFile> (createNpyFile (eventPath + eventName + "full_words.npy", NpyType (BaseType::UINT64, 1)));
         }
 
         DynamicObject::Ptr jsonChannel = new DynamicObject();
@@ -296,11 +325,22 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
         String directoryName = getProcessorString (ch) + ch->getName() + File::getSeparatorString();
 
-        rec->data = std::make_unique<NpyFile> (spikePath + directoryName + "waveforms.npy", NpyType (BaseType::INT16, ch->getTotalSamples()), ch->getNumChannels());
-        rec->samples = std::make_unique<NpyFile> (spikePath + directoryName + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
-        rec->timestamps = std::make_unique<NpyFile> (spikePath + directoryName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
-        rec->channels = std::make_unique<NpyFile> (spikePath + directoryName + "electrode_indices.npy", NpyType (BaseType::UINT16, 1));
-        rec->extraFile = std::make_unique<NpyFile> (spikePath + directoryName + "clusters.npy", NpyType (BaseType::UINT16, 1));
+        if (m_saveSpikeWaveforms)
+            rec->data = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "waveforms.npy", NpyType (BaseType::INT16, ch->getTotalSamples()), ch->getNumChannels()));
+
+        if (m_saveSpikeFeatures)
+        {
+            rec->peakAmplitudes = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "peak_amplitudes.npy", NpyType (BaseType::FLOAT, ch->getNumChannels())));
+            rec->troughToPeak = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "trough_to_peak.npy", NpyType (BaseType::UINT16, 1)));
+            rec->thresholds = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "thresholds.npy", NpyType (BaseType::FLOAT, ch->getNumChannels())));
+        }
+
+        electrodeJSON->setProperty ("waveforms", m_saveSpikeWaveforms);
+        electrodeJSON->setProperty ("features", m_saveSpikeFeatures);
+        rec->samples = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "sample_numbers.npy", NpyType (BaseType::INT64, 1)));
+        rec->timestamps = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1)));
+        rec->channels = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "electrode_indices.npy", NpyType (BaseType::UINT16, 1)));
+        rec->extraFile = std::unique_ptr<NpyFile> (createNpyFile (spikePath + directoryName + "clusters.npy", NpyType (BaseType::UINT16, 1)));
 
         electrodeJSON->setProperty ("folder", directoryName.replace (File::getSeparatorString(), "/"));
         electrodeJSON->setProperty ("source_channels", channelJSON);
@@ -321,18 +361,182 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
         m_syncTextFile = syncFile.createOutputStream();
     }
 
-    DynamicObject::Ptr settingsJSON = new DynamicObject();
+    m_settingsJSON = new DynamicObject();
 
-    settingsJSON->setProperty ("GUI version", CoreServices::getGUIVersion());
-    settingsJSON->setProperty ("continuous", continuousChannelJSON);
-    settingsJSON->setProperty ("events", eventChannelJSON);
-    settingsJSON->setProperty ("spikes", spikeChannelJSON);
+    m_settingsJSON->setProperty ("GUI version", CoreServices::getGUIVersion());
+    m_settingsJSON->setProperty ("continuous", continuousChannelJSON);
+    m_settingsJSON->setProperty ("events", eventChannelJSON);
+    m_settingsJSON->setProperty ("spikes", spikeChannelJSON);
 
-    FileOutputStream settingsFileStream (File (basepath + "structure.oebin"));
+    m_settingsFile = File (basepath + "structure.oebin");
 
-    settingsJSON->writeAsJSON (settingsFileStream, JSON::FormatOptions {}.withIndentLevel (2).withSpacing (JSON::Spacing::multiLine).withMaxDecimalPlaces (10));
+    writeSettings();
+}
 
-    
+bool BinaryRecording::isLfpStream (const ContinuousChannel* firstChannel) const
+{
+    if (m_lfpDecimationFactor <= 1)
+        return false;
+
+    if (m_lfpStreams.trim().isEmpty())
+        return true;
+
+    StringArray streamNames;
+    streamNames.addTokens (m_lfpStreams, ",", "\"");
+    streamNames.trim();
+
+    return streamNames.contains (firstChannel->getStreamName());
+}
+
+void BinaryRecording::createLfpStream (String contPath, const ContinuousChannel* firstChannel, int numChannels, const var& channelsJSON, Array<var>& continuousJSON)
+{
+    const double sampleRate = firstChannel->getSampleRate() / m_lfpDecimationFactor;
+
+    String lfpPath = getProcessorString (firstChannel).trimCharactersAtEnd (File::getSeparatorString()) + "-LFP" + File::getSeparatorString();
+
+    DynamicObject::Ptr fileJSON = new DynamicObject();
+
+    fileJSON->setProperty ("folder_name", lfpPath.replace (File::getSeparatorString(), "/"));
+    fileJSON->setProperty ("sample_rate", sampleRate);
+    fileJSON->setProperty ("source_processor_name", firstChannel->getSourceNodeName());
+    fileJSON->setProperty ("source_processor_id", firstChannel->getSourceNodeId());
+    fileJSON->setProperty ("stream_name", firstChannel->getStreamName() + "-LFP");
+    fileJSON->setProperty ("recorded_processor", firstChannel->getNodeName());
+    fileJSON->setProperty ("recorded_processor_id", firstChannel->getNodeId());
+    fileJSON->setProperty ("num_channels", numChannels);
+    fileJSON->setProperty ("decimated_from", getProcessorString (firstChannel).replace (File::getSeparatorString(), "/"));
+    fileJSON->setProperty ("decimation_factor", m_lfpDecimationFactor);
+    fileJSON->setProperty ("lowpass_cutoff", sampleRate / 2 * LFP_CUTOFF_FRACTION);
+
+    LfpStream* lfp = new LfpStream();
+
+    LOGD ("Creating file: ", contPath, lfpPath, "sample_numbers.npy");
+    lfp->sampleNumbers.reset (createNpyFile (contPath + lfpPath + "sample_numbers.npy", NpyType (BaseType::INT64, 1)));
+    lfp->timestamps.reset (createNpyFile (contPath + lfpPath + "timestamps.npy", NpyType (BaseType::DOUBLE, 1)));
+    lfp->file.reset (createContinuousFile (contPath + lfpPath, numChannels, fileJSON.get()));
+
+    Dsp::Params params;
+    params[0] = firstChannel->getSampleRate(); // sample rate
+    params[1] = LFP_FILTER_ORDER; // order
+    params[2] = sampleRate / 2 * LFP_CUTOFF_FRACTION; // cutoff frequency
+
+    for (int n = 0; n < numChannels; n++)
+    {
+        lfp->filters.add (new Dsp::FilterDesign<Dsp::Butterworth::Design::LowPass // design type
+                                                <LFP_FILTER_ORDER>, // order
+                                                1, // number of channels (must be const)
+                                                Dsp::DirectFormII>()); // realization
+
+        lfp->filters.getLast()->setParams (params);
+    }
+
+    m_lfpFiles.add (lfp);
+
+    fileJSON->setProperty ("channels", channelsJSON);
+
+    continuousJSON.add (var (fileJSON));
+}
+
+void BinaryRecording::writeLfpData (int lfpIndex, int writeChannel, double multFactor, const float* dataBuffer, const double* timestampBuffer, int size)
+{
+    LfpStream* lfp = m_lfpFiles[lfpIndex];
+
+    if (lfp->file == nullptr)
+        return;
+
+    const int channel = m_channelIndexes[writeChannel];
+    const int64 position = m_samplesWritten[writeChannel];
+
+    /* The filter runs at the full rate; only every Nth output is kept */
+    FloatVectorOperations::copy (m_scaledBuffer.getData(), dataBuffer, size);
+
+    float* ptr = m_scaledBuffer.getData();
+    lfp->filters[channel]->process (size, &ptr);
+
+    /* Keep the samples whose position in the full-rate file is a multiple of the factor */
+    const int firstKept = int ((m_lfpDecimationFactor - position % m_lfpDecimationFactor) % m_lfpDecimationFactor);
+    int numKept = 0;
+
+    for (int i = firstKept; i < size; i += m_lfpDecimationFactor)
+        m_scaledBuffer[numKept++] = float (m_scaledBuffer[i] * multFactor);
+
+    if (numKept == 0)
+        return;
+
+    AudioDataConverters::convertFloatToInt16LE (m_scaledBuffer.getData(), m_intBuffer.getData(), numKept);
+
+    lfp->file->writeChannel ((position + m_lfpDecimationFactor - 1) / m_lfpDecimationFactor, channel, m_intBuffer.getData(), numKept);
+
+    if (channel == 0)
+    {
+        const int64 baseSampleNumber = getLatestSampleNumber (writeChannel);
+
+        for (int i = 0; i < numKept; i++)
+        {
+            m_sampleNumberBuffer[i] = baseSampleNumber + firstKept + i * m_lfpDecimationFactor;
+            m_lfpTimestampBuffer[i] = timestampBuffer[firstKept + i * m_lfpDecimationFactor];
+        }
+
+        lfp->sampleNumbers->writeData (m_sampleNumberBuffer, numKept * sizeof (int64));
+        lfp->sampleNumbers->increaseRecordCount (numKept);
+
+        lfp->timestamps->writeData (m_lfpTimestampBuffer, numKept * sizeof (double));
+        lfp->timestamps->increaseRecordCount (numKept);
+    }
+}
+
+void BinaryRecording::writeSettings()
+{
+    FileOutputStream settingsFileStream (m_settingsFile);
+
+    settingsFileStream.setPosition (0);
+    settingsFileStream.truncate();
+
+    m_settingsJSON->writeAsJSON (settingsFileStream, JSON::FormatOptions {}.withIndentLevel (2).withSpacing (JSON::Spacing::multiLine).withMaxDecimalPlaces (10));
+}
+
+NpyFile* BinaryRecording::createNpyFile (String path, const Array<NpyType>& typeList)
+{
+    NpyFile* file = new NpyFile (path, typeList);
+    file->setHeaderMode (m_finalizeNpyHeaders ? NpyFile::FINALIZE_ON_CLOSE : NpyFile::UPDATE_PERIODICALLY);
+    return file;
+}
+
+NpyFile* BinaryRecording::createNpyFile (String path, NpyType type, unsigned int dim)
+{
+    NpyFile* file = new NpyFile (path, type, dim);
+    file->setHeaderMode (m_finalizeNpyHeaders ? NpyFile::FINALIZE_ON_CLOSE : NpyFile::UPDATE_PERIODICALLY);
+    return file;
+}
+
+ContinuousFileWriter* BinaryRecording::createContinuousFile (String streamPath, int numChannels, DynamicObject* streamJSON)
+{
+    if (m_channelMajorChunkMs > 0)
+    {
+        double sampleRate = streamJSON->getProperty ("sample_rate");
+        const int chunkMs = jmin (m_channelMajorChunkMs, MAX_CHANNEL_MAJOR_CHUNK_MS);
+        int samplesPerChunk = jmax (1, roundToInt (sampleRate * chunkMs / 1000.0));
+
+        DynamicObject::Ptr layoutJSON = new DynamicObject();
+        layoutJSON->setProperty ("order", "channel_major");
+        layoutJSON->setProperty ("samples_per_chunk", samplesPerChunk);
+        layoutJSON->setProperty ("data_file", "continuous.dat");
+        streamJSON->setProperty ("layout", var (layoutJSON));
+
+        std::unique_ptr<ChannelMajorBlockFile> file = std::make_unique<ChannelMajorBlockFile> (numChannels, samplesPerChunk);
+
+        if (file->openFile (streamPath + "continuous.dat"))
+            return file.release();
+
+        return nullptr;
+    }
+
+    std::unique_ptr<SequentialBlockFile> bFile = std::make_unique<SequentialBlockFile> (numChannels, samplesPerBlock);
+
+    if (bFile->openFile (streamPath + "continuous.dat"))
+        return bFile.release();
+
+    return nullptr;
 }
 
 std::unique_ptr<NpyFile> BinaryRecording::createEventMetadataFile (const MetadataEventObject* channel, String filename, DynamicObject* jsonFile)
@@ -357,7 +561,7 @@ std::unique_ptr<NpyFile> BinaryRecording::createEventMetadataFile (const Metadat
     }
     if (jsonFile)
         jsonFile->setProperty ("event_metadata", jsonMetadata);
-    return std::make_unique<NpyFile> (filename, types);
+    return std::unique_ptr<NpyFile> (createNpyFile (filename, types));
 }
 
 template <typename TO, typename FROM>
@@ -477,7 +681,37 @@ void BinaryRecording::createChannelMetadata (const MetadataObject* channel, Dyna
 
 void BinaryRecording::closeFiles()
 {
+    for (int i = 0; i < m_timestampSegments.size(); i++)
+        closeTimestampSegment (i);
+
+    if (m_settingsJSON != nullptr)
+    {
+        // record how many events and spikes were dropped because the record queues were full
+        if (auto* events = m_settingsJSON->getProperty ("events").getArray())
+        {
+            for (int i = 0; i < events->size(); i++)
+            {
+                if (auto* channel = (*events)[i].getDynamicObject())
+                    channel->setProperty ("dropped_events", getNumDroppedEvents (i));
+            }
+        }
+
+        if (auto* spikes = m_settingsJSON->getProperty ("spikes").getArray())
+        {
+            for (int i = 0; i < spikes->size(); i++)
+            {
+                if (auto* electrode = (*spikes)[i].getDynamicObject())
+                    electrode->setProperty ("dropped_spikes", getNumDroppedSpikes (i));
+            }
+        }
+
+        writeSettings();
+        m_settingsJSON = nullptr;
+    }
+
     m_continuousFiles.clear();
+    m_lfpFiles.clear();
+    m_lfpIndexes.clear();
     m_eventFiles.clear();
     m_spikeFiles.clear();
 
@@ -489,6 +723,8 @@ void BinaryRecording::closeFiles()
 
     m_dataTimestampFiles.clear();
     m_dataSyncTimestampFiles.clear();
+    m_timestampSegmentFiles.clear();
+    m_timestampSegments.clear();
 
     m_spikeChannelIndexes.clear();
     m_spikeFileIndexes.clear();
@@ -496,6 +732,7 @@ void BinaryRecording::closeFiles()
     m_scaledBuffer.malloc (MAX_BUFFER_SIZE);
     m_intBuffer.malloc (MAX_BUFFER_SIZE);
     m_sampleNumberBuffer.malloc (MAX_BUFFER_SIZE);
+    m_lfpTimestampBuffer.malloc (MAX_BUFFER_SIZE);
     m_bufferSize = MAX_BUFFER_SIZE;
 }
 
@@ -511,15 +748,29 @@ void BinaryRecording::writeEventMetadata (const MetadataEvent* event, NpyFile* f
     }
 }
 
-void BinaryRecording::increaseEventCounts (EventRecording* rec)
+void BinaryRecording::EventRecording::flushIfFull()
 {
-    rec->data->increaseRecordCount();
-    rec->samples->increaseRecordCount();
-    rec->timestamps->increaseRecordCount();
-    if (rec->channels)
-        rec->channels->increaseRecordCount();
-    if (rec->extraFile)
-        rec->extraFile->increaseRecordCount();
+    if (samples->getNumBufferedRecords() >= eventBatchRecords
+        || (data && data->getBufferedBytes() >= eventBatchBytes))
+        flush();
+}
+
+void BinaryRecording::EventRecording::flush()
+{
+    if (data)
+        data->flush();
+    samples->flush();
+    timestamps->flush();
+    if (channels)
+        channels->flush();
+    if (extraFile)
+        extraFile->flush();
+    if (peakAmplitudes)
+        peakAmplitudes->flush();
+    if (troughToPeak)
+        troughToPeak->flush();
+    if (thresholds)
+        thresholds->flush();
 }
 
 void BinaryRecording::writeContinuousData (int writeChannel,
@@ -538,6 +789,7 @@ void BinaryRecording::writeContinuousData (int writeChannel,
         m_scaledBuffer.malloc (size);
         m_intBuffer.malloc (size);
         m_sampleNumberBuffer.malloc (size);
+        m_lfpTimestampBuffer.malloc (size);
         m_bufferSize = size;
     }
 
@@ -556,6 +808,9 @@ void BinaryRecording::writeContinuousData (int writeChannel,
         m_intBuffer.getData(),
         size);
 
+    if (m_lfpIndexes[fileIndex] >= 0)
+        writeLfpData (m_lfpIndexes[fileIndex], writeChannel, multFactor, dataBuffer, timestampBuffer, size);
+
     m_samplesWritten.set (writeChannel, m_samplesWritten[writeChannel] + size);
 
     /* If is first channel in subprocessor */
@@ -571,6 +826,12 @@ void BinaryRecording::writeContinuousData (int writeChannel,
             wroteFirstSampleNumber[streamId] = true;
         }
 
+        if (m_compactTimestamps)
+        {
+            writeTimestampSegment (fileIndex, baseSampleNumber, timestampBuffer, size);
+            return;
+        }
+
         for (int i = 0; i < size; i++)
             /* Generate int sample number */
             m_sampleNumberBuffer[i] = baseSampleNumber + i;
@@ -584,6 +845,59 @@ void BinaryRecording::writeContinuousData (int writeChannel,
     }
 }
 
+void BinaryRecording::writeTimestampSegment (int fileIndex, int64 sampleNumber, const double* timestamps, int size)
+{
+    TimestampSegment& segment = m_timestampSegments.getReference (fileIndex);
+
+    /* Timestamps within a block are generated from a start time and a fixed step,
+       so the first and last samples are enough to describe the block */
+    double blockSampleRate = 0.0;
+
+    if (size > 1 && timestamps[size - 1] > timestamps[0])
+        blockSampleRate = double (size - 1) / (timestamps[size - 1] - timestamps[0]);
+
+    if (segment.numSamples > 0 && sampleNumber == segment.sampleNumber + segment.numSamples)
+    {
+        auto predict = [&segment] (int64 n)
+        {
+            if (segment.sampleRate > 0)
+                return segment.timestamp + double (n - segment.sampleNumber) / segment.sampleRate;
+            else
+                return segment.timestamp;
+        };
+
+        /* Allow a small fraction of a sample period of drift before starting a new segment */
+        double tolerance = (segment.sampleRate > 0) ? 0.01 / segment.sampleRate : 0.0;
+
+        if (std::abs (timestamps[0] - predict (sampleNumber)) <= tolerance
+            && std::abs (timestamps[size - 1] - predict (sampleNumber + size - 1)) <= tolerance)
+        {
+            segment.numSamples += size;
+            return;
+        }
+    }
+
+    closeTimestampSegment (fileIndex);
+
+    segment.sampleNumber = sampleNumber;
+    segment.timestamp = timestamps[0];
+    segment.sampleRate = blockSampleRate;
+    segment.numSamples = size;
+}
+
+void BinaryRecording::closeTimestampSegment (int fileIndex)
+{
+    TimestampSegment& segment = m_timestampSegments.getReference (fileIndex);
+
+    if (segment.numSamples == 0)
+        return;
+
+    m_timestampSegmentFiles[fileIndex]->writeData (&segment, sizeof (TimestampSegment));
+    m_timestampSegmentFiles[fileIndex]->increaseRecordCount();
+
+    segment.numSamples = 0;
+}
+
 void BinaryRecording::writeEvent (int eventIndex, const EventPacket& event)
 {
     const EventChannel* info = getEventChannel (eventIndex);
@@ -599,18 +913,18 @@ void BinaryRecording::writeEvent (int eventIndex, const EventPacket& event)
         TTLEvent* ttl = static_cast<TTLEvent*> (ev.get());
 
         int16 state = (ttl->getLine() + 1) * (ttl->getState() ? 1 : -1);
-        rec->data->writeData (&state, sizeof (int16));
+        rec->data->bufferRecord (&state, sizeof (int16));
 
         int64 sampleIdx = ev->getSampleNumber();
-        rec->samples->writeData (&sampleIdx, sizeof (int64));
+        rec->samples->bufferRecord (&sampleIdx, sizeof (int64));
 
         double ts = ev->getTimestampInSeconds();
-        rec->timestamps->writeData (&ts, sizeof (double));
+        rec->timestamps->bufferRecord (&ts, sizeof (double));
 
         if (rec->extraFile)
         {
             uint64 fullWord = ttl->getWord();
-            rec->extraFile->writeData (&fullWord, sizeof (uint64));
+            rec->extraFile->bufferRecord (&fullWord, sizeof (uint64));
         }
     }
     else if (ev->getEventType() == EventChannel::TEXT)
@@ -618,18 +932,18 @@ void BinaryRecording::writeEvent (int eventIndex, const EventPacket& event)
         TextEvent* text = static_cast<TextEvent*> (ev.get());
 
         int64 sampleIdx = text->getSampleNumber();
-        rec->samples->writeData (&sampleIdx, sizeof (int64));
+        rec->samples->bufferRecord (&sampleIdx, sizeof (int64));
 
         double ts = text->getTimestampInSeconds();
-        rec->timestamps->writeData (&ts, sizeof (double));
+        rec->timestamps->bufferRecord (&ts, sizeof (double));
 
-        rec->data->writeData (ev->getRawDataPointer(), info->getDataSize());
+        rec->data->bufferRecord (ev->getRawDataPointer(), info->getDataSize());
     }
 
     // NOT IMPLEMENTED
     //writeEventMetadata(ev.get(), rec->metaDataFile.get());
 
-    increaseEventCounts (rec);
+    rec->flushIfFull();
 }
 
 void BinaryRecording::writeSpike (int electrodeIndex, const Spike* spike)
@@ -650,26 +964,43 @@ void BinaryRecording::writeSpike (int electrodeIndex, const Spike* spike)
         m_intBuffer.malloc (totalSamples);
     }
 
-    double multFactor = 1 / (float (0x7fff) * channel->getChannelBitVolts (0));
-    FloatVectorOperations::copyWithMultiply (m_scaledBuffer.getData(), spike->getDataPointer(), multFactor, totalSamples);
-    AudioDataConverters::convertFloatToInt16LE (m_scaledBuffer.getData(), m_intBuffer.getData(), totalSamples);
-    rec->data->writeData (m_intBuffer.getData(), totalSamples * sizeof (int16));
+    if (rec->data)
+    {
+        double multFactor = 1 / (float (0x7fff) * channel->getChannelBitVolts (0));
+        FloatVectorOperations::copyWithMultiply (m_scaledBuffer.getData(), spike->getDataPointer(), multFactor, totalSamples);
+        AudioDataConverters::convertFloatToInt16LE (m_scaledBuffer.getData(), m_intBuffer.getData(), totalSamples);
+        rec->data->bufferRecord (m_intBuffer.getData(), totalSamples * sizeof (int16));
+    }
+
+    if (rec->peakAmplitudes)
+    {
+        const int numChannels = channel->getNumChannels();
+
+        uint16 troughToPeak = uint16 (spike->computeFeatures (m_scaledBuffer.getData()));
+        rec->peakAmplitudes->bufferRecord (m_scaledBuffer.getData(), numChannels * sizeof (float));
+        rec->troughToPeak->bufferRecord (&troughToPeak, sizeof (uint16));
+
+        for (int i = 0; i < numChannels; i++)
+            m_scaledBuffer[i] = spike->getThreshold (i);
+
+        rec->thresholds->bufferRecord (m_scaledBuffer.getData(), numChannels * sizeof (float));
+    }
 
     int64 sampleIdx = spike->getSampleNumber();
-    rec->samples->writeData (&sampleIdx, sizeof (int64));
+    rec->samples->bufferRecord (&sampleIdx, sizeof (int64));
 
     double ts = spike->getTimestampInSeconds();
-    rec->timestamps->writeData (&ts, sizeof (double));
+    rec->timestamps->bufferRecord (&ts, sizeof (double));
 
-    rec->channels->writeData (&spikeChannel, sizeof (uint16));
+    rec->channels->bufferRecord (&spikeChannel, sizeof (uint16));
 
     uint16 sortedId = spike->getSortedId();
-    rec->extraFile->writeData (&sortedId, sizeof (uint16));
+    rec->extraFile->bufferRecord (&sortedId, sizeof (uint16));
 
     // NOT IMPLEMENTED
     //writeEventMetadata(spike, rec->metaDataFile.get());
 
-    increaseEventCounts (rec);
+    rec->flushIfFull();
 }
 
 void BinaryRecording::writeTimestampSyncText (uint64 streamId, int64 sampleNumber, float sourceSampleRate, String text)
@@ -693,13 +1024,39 @@ void BinaryRecording::writeTimestampSyncText (uint64 streamId, int64 sampleNumbe
 RecordEngineManager* BinaryRecording::getEngineManager()
 {
     RecordEngineManager* man = new RecordEngineManager ("BINARY", "Binary", &(engineFactory<BinaryRecording>) );
+    addBinaryParameters (man);
+    return man;
+}
+
+void BinaryRecording::addBinaryParameters (RecordEngineManager* man)
+{
     EngineParameter* param;
     param = new EngineParameter (EngineParameter::BOOL, 0, "Record TTL full words", true);
     man->addParameter (param);
-    return man;
+    param = new EngineParameter (EngineParameter::BOOL, 1, "Compact timestamps", false);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::BOOL, 2, "Finalize .npy headers on close", true);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::INT, 3, "Channel-major chunk (ms, 0 = interleaved)", 0, 0, MAX_CHANNEL_MAJOR_CHUNK_MS);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::INT, 4, "LFP decimation factor (1 = off)", 1, 1, 100);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::STR, 5, "LFP streams (comma-separated, empty = all)", "");
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::BOOL, 6, "Record spike waveforms", true);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::BOOL, 7, "Record spike features", false);
+    man->addParameter (param);
 }
 
 void BinaryRecording::setParameter (EngineParameter& parameter)
 {
     boolParameter (0, m_saveTTLWords);
+    boolParameter (1, m_compactTimestamps);
+    boolParameter (2, m_finalizeNpyHeaders);
+    intParameter (3, m_channelMajorChunkMs);
+    intParameter (4, m_lfpDecimationFactor);
+    strParameter (5, m_lfpStreams);
+    boolParameter (6, m_saveSpikeWaveforms);
+    boolParameter (7, m_saveSpikeFeatures);
 }
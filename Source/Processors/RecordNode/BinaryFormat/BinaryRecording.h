@@ -29,8 +29,10 @@
 #include <memory>
 
 #include "../../../Utils/Utils.h"
+#include "../../Dsp/Dsp.h"
 #include "../RecordEngine.h"
 
+#include "ChannelMajorBlockFile.h"
 #include "NpyFile.h"
 #include "SequentialBlockFile.h"
 
@@ -71,10 +73,22 @@ public:
     /** Writes timestamp sync texts */
     void writeTimestampSyncText (uint64 streamId, int64 sampleNumber, float sampleRate, String text);
 
-    /** Sets an engine parameter (in this case TTL word writing bool) */
+    /** Sets an engine parameter (TTL word writing, compact timestamp and .npy header mode bools,
+        channel-major chunk length, LFP decimation factor and streams, spike waveform and feature bools) */
     void setParameter (EngineParameter& parameter);
 
+protected:
+    /** Creates and opens the continuous data file for one stream inside its folder.
+        Subclasses can override this to store samples in a different layout, adding
+        any information a reader needs to the stream's structure.oebin entry. */
+    virtual ContinuousFileWriter* createContinuousFile (String streamPath, int numChannels, DynamicObject* streamJSON);
+
+    /** Adds the parameters shared by all Binary-based engines to a manager */
+    static void addBinaryParameters (RecordEngineManager* manager);
+
 private:
+    /** The column files of one event or spike channel. Records are buffered in each
+        file and written out together once a batch is full, or when files are closed. */
     class EventRecording
     {
     public:
@@ -83,14 +97,79 @@ private:
         std::unique_ptr<NpyFile> channels;
         std::unique_ptr<NpyFile> extraFile;
         std::unique_ptr<NpyFile> timestamps;
+
+        /** Spike features, written instead of or alongside the waveforms */
+        std::unique_ptr<NpyFile> peakAmplitudes;
+        std::unique_ptr<NpyFile> troughToPeak;
+        std::unique_ptr<NpyFile> thresholds;
+
+        /** Writes all columns if the current batch is full */
+        void flushIfFull();
+
+        /** Writes the buffered records of all columns */
+        void flush();
     };
 
+    /** Creates an .npy file using the engine's header mode */
+    NpyFile* createNpyFile (String path, const Array<NpyType>& typeList);
+    NpyFile* createNpyFile (String path, NpyType type, unsigned int dim = 1);
+
     std::unique_ptr<NpyFile> createEventMetadataFile (const MetadataEventObject* channel, String fileName, DynamicObject* jsonObject);
     void createChannelMetadata (const MetadataObject* channel, DynamicObject* jsonObject);
     void writeEventMetadata (const MetadataEvent* event, NpyFile* file);
-    void increaseEventCounts (EventRecording* rec);
+
+    /** A run of contiguous samples whose timestamps follow timestamp + (n - sampleNumber) / sampleRate.
+        Written as one record of timestamp_segments.npy when compact timestamps are enabled. */
+    struct TimestampSegment
+    {
+        int64 sampleNumber;
+        double timestamp;
+        double sampleRate;
+        int64 numSamples;
+    };
+
+    /** Extends the current timestamp segment of a stream, or starts a new one if the block doesn't fit it */
+    void writeTimestampSegment (int fileIndex, int64 sampleNumber, const double* timestamps, int size);
+
+    /** Writes out the current timestamp segment of a stream */
+    void closeTimestampSegment (int fileIndex);
+
+    /** Writes the recording's structure.oebin file */
+    void writeSettings();
+
+    /** A low-passed, decimated copy of a stream, written next to the full-rate stream */
+    struct LfpStream
+    {
+        std::unique_ptr<ContinuousFileWriter> file;
+        std::unique_ptr<NpyFile> sampleNumbers;
+        std::unique_ptr<NpyFile> timestamps;
+
+        /** Anti-aliasing filters (1 per channel) */
+        OwnedArray<Dsp::Filter> filters;
+    };
+
+    /** Returns true if a decimated copy of a stream should be written */
+    bool isLfpStream (const ContinuousChannel* firstChannel) const;
+
+    /** Creates the files and filters of a stream's decimated copy, and adds it to structure.oebin */
+    void createLfpStream (String contPath, const ContinuousChannel* firstChannel, int numChannels, const var& channelsJSON, Array<var>& continuousJSON);
+
+    /** Filters a block of one channel and writes every Nth sample to the stream's decimated copy */
+    void writeLfpData (int lfpIndex, int writeChannel, double multFactor, const float* dataBuffer, const double* timestampBuffer, int size);
 
     bool m_saveTTLWords { true };
+    bool m_compactTimestamps { false };
+    bool m_finalizeNpyHeaders { true };
+    int m_channelMajorChunkMs { 0 };
+    int m_lfpDecimationFactor { 1 };
+    String m_lfpStreams;
+    bool m_saveSpikeWaveforms { true };
+    bool m_saveSpikeFeatures { false };
+
+    /** Decimated copies, and the copy belonging to each continuous file (-1 if none) */
+    OwnedArray<LfpStream> m_lfpFiles;
+    Array<int> m_lfpIndexes;
+    HeapBlock<double> m_lfpTimestampBuffer;
 
     HeapBlock<float> m_scaledBuffer;
     HeapBlock<int16> m_intBuffer;
@@ -101,7 +180,7 @@ private:
     Array<unsigned int> m_channelIndexes;
     Array<unsigned int> m_fileIndexes;
 
-    OwnedArray<SequentialBlockFile> m_continuousFiles;
+    OwnedArray<ContinuousFileWriter> m_continuousFiles;
     OwnedArray<EventRecording> m_eventFiles;
     OwnedArray<EventRecording> m_spikeFiles;
 
@@ -110,8 +189,13 @@ private:
 
     OwnedArray<NpyFile> m_dataTimestampFiles;
     OwnedArray<NpyFile> m_dataSyncTimestampFiles;
+    OwnedArray<NpyFile> m_timestampSegmentFiles;
+    Array<TimestampSegment> m_timestampSegments;
     std::unique_ptr<FileOutputStream> m_syncTextFile;
 
+    DynamicObject::Ptr m_settingsJSON;
+    File m_settingsFile;
+
     Array<unsigned int> m_spikeFileIndexes;
     Array<uint16> m_spikeChannelIndexes;
 
@@ -123,5 +207,9 @@ private:
     std::map<uint64, bool> wroteFirstSampleNumber;
 
     const int samplesPerBlock { 4096 };
+
+    /** Events and spikes are written to disk in batches of at most this many records or bytes */
+    static const int eventBatchRecords = 4096;
+    static const size_t eventBatchBytes = 4 * 1024 * 1024;
 };
 #endif
@@ -0,0 +1,108 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ChannelMajorBlockFile.h"
+
+ChannelMajorBlockFile::ChannelMajorBlockFile (int nChannels, int samplesPerChunk)
+    : m_nChannels (nChannels),
+      m_samplesPerChunk (jmax (1, samplesPerChunk))
+{
+    m_pending.resize (nChannels);
+
+    for (auto& channel : m_pending)
+        channel.reserve (2 * m_samplesPerChunk);
+}
+
+ChannelMajorBlockFile::~ChannelMajorBlockFile()
+{
+    if (m_file == nullptr)
+        return;
+
+    /* Write whatever is left as a final, shorter chunk */
+    size_t remaining = m_pending.size() > 0 ? m_pending[0].size() : 0;
+
+    for (auto& channel : m_pending)
+        remaining = jmin (remaining, channel.size());
+
+    if (remaining > 0)
+        writeChunk (int (remaining));
+
+    m_file->flush();
+}
+
+bool ChannelMajorBlockFile::openFile (String filename)
+{
+    File file (filename);
+    Result res = file.create();
+    if (res.failed())
+    {
+        LOGE ("Error creating file ", filename, ": ", res.getErrorMessage());
+        return false;
+    }
+
+    m_file = file.createOutputStream();
+    if (! m_file)
+    {
+        LOGD ("Unable to create output stream!");
+        return false;
+    }
+
+    return true;
+}
+
+bool ChannelMajorBlockFile::writeChannel (uint64 startPos, int channel, int16* data, int nSamples)
+{
+    if (! m_file)
+        return false;
+
+    std::vector<int16>& pending = m_pending[channel];
+    pending.insert (pending.end(), data, data + nSamples);
+
+    /* Channels of a block are written in order, so once the last one has arrived
+       every channel has been extended and complete chunks can be written */
+    if (channel == m_nChannels - 1)
+    {
+        size_t available = pending.size();
+
+        for (auto& ch : m_pending)
+            available = jmin (available, ch.size());
+
+        while (available >= (size_t) m_samplesPerChunk)
+        {
+            writeChunk (m_samplesPerChunk);
+            available -= m_samplesPerChunk;
+        }
+    }
+
+    return true;
+}
+
+void ChannelMajorBlockFile::writeChunk (int numSamples)
+{
+    for (int ch = 0; ch < m_nChannels; ch++)
+    {
+        m_file->write (m_pending[ch].data(), numSamples * sizeof (int16));
+
+        m_pending[ch].erase (m_pending[ch].begin(), m_pending[ch].begin() + numSamples);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CHANNELMAJORBLOCKFILE_H
+#define CHANNELMAJORBLOCKFILE_H
+
+#include "../../../Utils/Utils.h"
+#include "ContinuousFileWriter.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+/**
+
+    Writes int16 data in time chunks, with each channel contiguous within a chunk
+
+    With N channels and M samples per chunk, every chunk contains:
+
+    <Channel 1 Sample 1> ... <Channel 1 Sample M>
+    <Channel 2 Sample 1> ... <Channel 2 Sample M>
+    ...
+    <Channel N Sample 1> ... <Channel N Sample M>
+
+    All chunks hold M samples except the last one, which holds the remainder,
+    so chunk k starts at byte k * M * N * 2 and the total sample count follows
+    from the file size. Reading one channel only touches that channel's runs.
+
+ */
+
+class PLUGIN_API ChannelMajorBlockFile : public ContinuousFileWriter
+{
+public:
+    /** Creates a file with nChannels and samplesPerChunk samples per channel in each chunk */
+    ChannelMajorBlockFile (int nChannels, int samplesPerChunk);
+
+    /** Destructor (writes any remaining samples as a shorter chunk) */
+    ~ChannelMajorBlockFile() override;
+
+    /** Opens the file at the requested path */
+    bool openFile (String filename) override;
+
+    /** Writes nSamples of data for a particular channel */
+    bool writeChannel (uint64 startPos, int channel, int16* data, int nSamples) override;
+
+private:
+    /** Writes the first numSamples pending samples of every channel as one chunk */
+    void writeChunk (int numSamples);
+
+    std::unique_ptr<FileOutputStream> m_file;
+
+    const int m_nChannels;
+    const int m_samplesPerChunk;
+
+    std::vector<std::vector<int16>> m_pending;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelMajorBlockFile);
+};
+
+#endif // CHANNELMAJORBLOCKFILE_H
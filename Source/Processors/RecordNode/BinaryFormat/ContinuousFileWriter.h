@@ -0,0 +1,53 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CONTINUOUSFILEWRITER_H
+#define CONTINUOUSFILEWRITER_H
+
+#include "../../../Utils/Utils.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+/**
+
+    Base class for the per-stream continuous data files written by BinaryRecording
+
+    Each instance receives int16 samples one channel at a time, with the
+    position of the first sample given relative to the start of the file.
+
+ */
+
+class PLUGIN_API ContinuousFileWriter
+{
+public:
+    /** Destructor (flushes any remaining data) */
+    virtual ~ContinuousFileWriter() {}
+
+    /** Opens the file at the requested path */
+    virtual bool openFile (String filename) = 0;
+
+    /** Writes nSamples of data for a particular channel */
+    virtual bool writeChannel (uint64 startPos, int channel, int16* data, int nSamples) = 0;
+};
+
+#endif // !CONTINUOUSFILEWRITER_H
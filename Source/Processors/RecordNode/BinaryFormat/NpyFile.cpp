@@ -140,9 +140,11 @@ void NpyFile::writeHeader (const Array<NpyType>& typeList)
     // magic + header length field + current string header length:
     m_shapePos = magicLen + sizeof (uint16) + strHeader.length();
     strHeader += getShapeString(); // inits to 0 records, i.e. 1st dim has length 0
-    int baseHeaderLen = magicLen + sizeof (uint16) + strHeader.length() + 1; // +1 for newline
+    // +1 for newline, and reserve room for the widest record count (the header holds a single "0")
+    int reservedLen = maxRecordCountDigits - 1;
+    int baseHeaderLen = magicLen + sizeof (uint16) + strHeader.length() + 1 + reservedLen;
     int padlen = nbytesAlign - (baseHeaderLen % nbytesAlign);
-    strHeader = strHeader.paddedRight (' ', strHeader.length() + padlen);
+    strHeader = strHeader.paddedRight (' ', strHeader.length() + padlen + reservedLen);
     strHeader += '\n';
     uint16 strHeaderLen = strHeader.length();
 
@@ -184,7 +186,11 @@ void NpyFile::updateHeader()
 
 NpyFile::~NpyFile()
 {
-    updateHeader();
+    flush();
+
+    // the header always gets its final shape, whatever the header mode
+    if (m_okOpen)
+        updateHeader();
 }
 
 void NpyFile::writeData (const void* data, size_t size)
@@ -196,10 +202,133 @@ void NpyFile::increaseRecordCount (int count)
 {
     int64 old_recordCount = m_recordCount;
     m_recordCount += count;
-    if ((old_recordCount / recordBufferSize) != (m_recordCount / recordBufferSize))
+    if (m_headerMode == UPDATE_PERIODICALLY && (old_recordCount / recordBufferSize) != (m_recordCount / recordBufferSize))
         updateHeader(); // crossed recordBufferSize threshold, update header
 }
 
+void NpyFile::bufferRecord (const void* data, size_t size)
+{
+    m_buffer.write (data, size);
+    m_bufferedRecords++;
+}
+
+void NpyFile::flush()
+{
+    if (! m_okOpen)
+        return;
+
+    if (m_bufferedRecords > 0)
+    {
+        m_file->write (m_buffer.getData(), m_buffer.getDataSize());
+        m_recordCount += m_bufferedRecords;
+
+        m_buffer.reset();
+        m_bufferedRecords = 0;
+    }
+
+    if (m_headerMode == UPDATE_PERIODICALLY)
+        updateHeader();
+}
+
+int64 NpyFile::repairHeader (File file)
+{
+    std::unique_ptr<FileInputStream> input = file.createInputStream();
+
+    if (input == nullptr)
+        return -1;
+
+    // \x93NUMPY + version (2 bytes) + header length (2 bytes, little endian)
+    char magic[6];
+    if (input->read (magic, 6) != 6 || uint8 (magic[0]) != 0x93 || String (magic + 1, 5) != "NUMPY")
+        return -1;
+
+    input->skipNextBytes (2);
+    int headerLength = uint16 (input->readShort());
+
+    MemoryBlock headerData;
+    if (input->readIntoMemoryBlock (headerData, headerLength) != size_t (headerLength))
+        return -1;
+
+    String header = headerData.toString();
+    int64 dataStart = 10 + headerLength;
+    int64 dataSize = file.getSize() - dataStart;
+
+    input.reset();
+
+    int shapeStart = header.indexOf ("'shape': (");
+    int shapeEnd = header.indexOf (shapeStart, ")");
+    if (shapeStart < 0 || shapeEnd < 0)
+        return -1;
+
+    shapeStart += 10;
+
+    // size of one record: size of the type(s) in 'descr' times any trailing dimensions of the shape
+    String descr = header.fromFirstOccurrenceOf ("'descr':", false, false).upToFirstOccurrenceOf ("'fortran_order'", false, false);
+    int64 recordSize = 0;
+
+    StringArray tokens;
+    tokens.addTokens (descr, "'", "");
+
+    for (int i = 1; i < tokens.size(); i += 2) // odd tokens are quoted
+    {
+        const String& token = tokens[i];
+
+        if (token.length() < 3 || ! String ("<>|=").containsChar (token[0]))
+            continue;
+
+        int64 typeSize = token.substring (2).getLargeIntValue();
+
+        // structured fields are stored as ('name', 'type', (n,))
+        String following = tokens[i + 1].trimStart();
+        if (following.startsWith (", ("))
+            typeSize *= following.fromFirstOccurrenceOf ("(", false, false).getLargeIntValue();
+
+        recordSize += typeSize;
+    }
+
+    StringArray dims;
+    dims.addTokens (header.substring (shapeStart, shapeEnd), ",", "");
+
+    for (int i = 1; i < dims.size(); i++)
+    {
+        if (dims[i].trim().isNotEmpty())
+            recordSize *= dims[i].trim().getLargeIntValue();
+    }
+
+    if (recordSize <= 0 || dataSize < 0)
+        return -1;
+
+    int64 numRecords = dataSize / recordSize;
+
+    // keep the other dimensions and the padding, only replace the record count
+    String newHeader = header.substring (0, shapeStart) + String (numRecords)
+                       + header.substring (shapeStart, shapeEnd).fromFirstOccurrenceOf (",", true, false);
+    newHeader += header.substring (shapeEnd).upToFirstOccurrenceOf ("}", true, false);
+
+    if (newHeader.length() + 1 > headerLength)
+        return -1;
+
+    newHeader = newHeader.paddedRight (' ', headerLength - 1) + "\n";
+
+    FileOutputStream output (file);
+
+    if (! output.openedOk())
+        return -1;
+
+    output.setPosition (10);
+    output.write (newHeader.toRawUTF8(), headerLength);
+
+    if (numRecords * recordSize < dataSize)
+    {
+        output.setPosition (dataStart + numRecords * recordSize);
+        output.truncate();
+    }
+
+    output.flush();
+
+    return numRecords;
+}
+
 NpyType::NpyType (String n, BaseType t, size_t l)
     : name (n), type (t), length (l)
 {
@@ -84,6 +84,13 @@ private:
 class PLUGIN_API NpyFile
 {
 public:
+    /** Controls when the array shape stored in the header is rewritten */
+    enum HeaderMode
+    {
+        UPDATE_PERIODICALLY, // every recordBufferSize records, so the file can be read while it is written
+        FINALIZE_ON_CLOSE // only when the file is closed, so data is written purely sequentially
+    };
+
     /** Constructor for an array of types */
     NpyFile (String path, const Array<NpyType>& typeList);
 
@@ -99,6 +106,27 @@ public:
     /** Increases the count of the number of records in the file (must match the number of samples written) */
     void increaseRecordCount (int count = 1);
 
+    /** Appends one complete record to the file's write buffer. Buffered records are
+        written, and counted in the header, on the next call to flush() */
+    void bufferRecord (const void* data, size_t size);
+
+    /** Returns the number of records waiting in the write buffer */
+    int getNumBufferedRecords() const { return m_bufferedRecords; }
+
+    /** Returns the number of bytes waiting in the write buffer */
+    size_t getBufferedBytes() const { return m_buffer.getDataSize(); }
+
+    /** Writes all buffered records in a single write and updates the header (if updating periodically) */
+    void flush();
+
+    /** Sets when the header is rewritten (defaults to UPDATE_PERIODICALLY) */
+    void setHeaderMode (HeaderMode mode) { m_headerMode = mode; }
+
+    /** Rewrites the shape in the header of a file that was never finalized (e.g. after a crash)
+        to match the data it contains, dropping any trailing partial record.
+        Returns the number of records in the repaired file, or -1 if it is not a valid .npy file. */
+    static int64 repairHeader (File file);
+
 private:
     /** Opens the file at a specified path */
     bool openFile (String path);
@@ -116,12 +144,18 @@ private:
     int64 m_headerLen;
     bool m_okOpen { false };
     int64 m_recordCount { 0 };
+    MemoryOutputStream m_buffer;
+    int m_bufferedRecords { 0 };
+    HeaderMode m_headerMode { UPDATE_PERIODICALLY };
     size_t m_shapePos;
     unsigned int m_dim1;
     unsigned int m_dim2;
 
     /** flush file buffer to disk and update the .npy header every this many records: */
     const int recordBufferSize { 1024 };
+
+    /** room reserved in the header for the record count, so the shape can always be rewritten in place */
+    static const int maxRecordCountDigits = 20;
 };
 
 #endif
@@ -25,6 +25,7 @@
 #define SEQUENTIALBLOCKFILE_H
 
 #include "../../../Utils/Utils.h"
+#include "ContinuousFileWriter.h"
 #include "FileMemoryBlock.h"
 
 #include "../../PluginManager/PluginClass.h"
@@ -51,20 +52,20 @@ typedef FileMemoryBlock<int16> FileBlock;
 
  */
 
-class PLUGIN_API SequentialBlockFile
+class PLUGIN_API SequentialBlockFile : public ContinuousFileWriter
 {
 public:
     /** Creates a file with nChannels */
     SequentialBlockFile (int nChannels, int samplesPerBlock = 4096);
 
     /** Destructor */
-    ~SequentialBlockFile();
+    ~SequentialBlockFile() override;
 
     /** Opens the file at the requested path */
-    bool openFile (String filename);
+    bool openFile (String filename) override;
 
     /** Writes nSamples of data for a particular channel */
-    bool writeChannel (uint64 startPos, int channel, int16* data, int nSamples);
+    bool writeChannel (uint64 startPos, int channel, int16* data, int nSamples) override;
 
 private:
     std::shared_ptr<FileOutputStream> m_file;
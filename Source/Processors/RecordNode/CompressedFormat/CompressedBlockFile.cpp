@@ -0,0 +1,188 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedBlockFile.h"
+#include "DeltaCodec.h"
+
+const char* const CompressedBlockFile::indexFileName = "chunk_index.npy";
+
+CompressedBlockFile::CompressionJob::CompressionJob (CompressedBlockFile* file_, int firstChannel_, int numChannels_)
+    : ThreadPoolJob ("Compression_" + String (firstChannel_)),
+      file (file_),
+      firstChannel (firstChannel_),
+      numChannels (numChannels_)
+{
+}
+
+ThreadPoolJob::JobStatus CompressedBlockFile::CompressionJob::runJob()
+{
+    for (int i = 0; i < numChannels; i++)
+        file->encodeChannel (firstChannel + i);
+
+    return ThreadPoolJob::jobHasFinished;
+}
+
+CompressedBlockFile::CompressedBlockFile (int nChannels, int samplesPerChunk, int channelsPerGroup, ThreadPool* threadPool)
+    : m_threadPool (threadPool),
+      m_nChannels (nChannels),
+      m_samplesPerChunk (samplesPerChunk),
+      m_channelsPerGroup (jmax (1, channelsPerGroup)),
+      m_maxChannelBytes (DeltaCodec::getMaxEncodedSize (samplesPerChunk))
+{
+    m_pending.resize (nChannels);
+
+    for (auto& channel : m_pending)
+        channel.reserve (2 * samplesPerChunk);
+
+    m_chunkBuffer.malloc (m_maxChannelBytes * nChannels);
+    m_encodedSizes.malloc (nChannels);
+
+    for (int ch = 0; ch < nChannels; ch += m_channelsPerGroup)
+        m_jobs.add (new CompressionJob (this, ch, jmin (m_channelsPerGroup, nChannels - ch)));
+}
+
+CompressedBlockFile::~CompressedBlockFile()
+{
+    if (m_file == nullptr)
+        return;
+
+    /* Write whatever is left as a final, shorter chunk */
+    size_t remaining = m_pending.size() > 0 ? m_pending[0].size() : 0;
+
+    for (auto& channel : m_pending)
+        remaining = jmin (remaining, channel.size());
+
+    if (remaining > 0)
+        writeChunk (int (remaining));
+
+    m_file->flush();
+}
+
+bool CompressedBlockFile::openFile (String filename)
+{
+    File file (filename);
+    Result res = file.create();
+    if (res.failed())
+    {
+        LOGE ("Error creating file ", filename, ": ", res.getErrorMessage());
+        return false;
+    }
+
+    m_file = file.createOutputStream();
+    if (! m_file)
+    {
+        LOGD ("Unable to create output stream!");
+        return false;
+    }
+
+    Array<NpyType> indexTypes;
+    indexTypes.add (NpyType ("byte_offset", BaseType::INT64, 1));
+    indexTypes.add (NpyType ("num_bytes", BaseType::INT64, 1));
+    indexTypes.add (NpyType ("sample_offset", BaseType::INT64, 1));
+    indexTypes.add (NpyType ("num_samples", BaseType::INT64, 1));
+
+    m_indexFile = std::make_unique<NpyFile> (file.getSiblingFile (indexFileName).getFullPathName(), indexTypes);
+
+    return true;
+}
+
+bool CompressedBlockFile::writeChannel (uint64 startPos, int channel, int16* data, int nSamples)
+{
+    if (! m_file)
+        return false;
+
+    std::vector<int16>& pending = m_pending[channel];
+    pending.insert (pending.end(), data, data + nSamples);
+
+    /* Channels of a block are written in order, so once the last one has arrived
+       every channel has been extended and complete chunks can be written */
+    if (channel == m_nChannels - 1)
+    {
+        size_t available = pending.size();
+
+        for (auto& ch : m_pending)
+            available = jmin (available, ch.size());
+
+        while (available >= (size_t) m_samplesPerChunk)
+        {
+            writeChunk (m_samplesPerChunk);
+            available -= m_samplesPerChunk;
+        }
+    }
+
+    return true;
+}
+
+double CompressedBlockFile::getBytesPerSample() const
+{
+    if (m_samplesWritten == 0)
+        return 0.0;
+
+    return double (m_bytesWritten) / (double (m_samplesWritten) * m_nChannels);
+}
+
+void CompressedBlockFile::encodeChannel (int channel)
+{
+    m_encodedSizes[channel] = uint32 (DeltaCodec::encodeChannel (m_pending[channel].data(),
+                                                                 m_chunkSamples,
+                                                                 1,
+                                                                 m_chunkBuffer + channel * m_maxChannelBytes));
+}
+
+void CompressedBlockFile::writeChunk (int numSamples)
+{
+    m_chunkSamples = numSamples;
+
+    if (m_threadPool != nullptr && m_jobs.size() > 1)
+    {
+        for (auto job : m_jobs)
+            m_threadPool->addJob (job, false);
+
+        for (auto job : m_jobs)
+            m_threadPool->waitForJobToFinish (job, -1);
+    }
+    else
+    {
+        for (int ch = 0; ch < m_nChannels; ch++)
+            encodeChannel (ch);
+    }
+
+    int64 chunkBytes = m_nChannels * sizeof (uint32);
+
+    m_file->write (m_encodedSizes, m_nChannels * sizeof (uint32));
+
+    for (int ch = 0; ch < m_nChannels; ch++)
+    {
+        m_file->write (m_chunkBuffer + ch * m_maxChannelBytes, m_encodedSizes[ch]);
+        chunkBytes += m_encodedSizes[ch];
+
+        m_pending[ch].erase (m_pending[ch].begin(), m_pending[ch].begin() + numSamples);
+    }
+
+    int64 indexEntry[4] = { m_bytesWritten, chunkBytes, m_samplesWritten, numSamples };
+    m_indexFile->writeData (indexEntry, sizeof (indexEntry));
+    m_indexFile->increaseRecordCount();
+
+    m_bytesWritten += chunkBytes;
+    m_samplesWritten += numSamples;
+}
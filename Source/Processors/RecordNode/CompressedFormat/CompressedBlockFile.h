@@ -0,0 +1,114 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDBLOCKFILE_H
+#define COMPRESSEDBLOCKFILE_H
+
+#include "../../../Utils/Utils.h"
+#include "../BinaryFormat/ContinuousFileWriter.h"
+#include "../BinaryFormat/NpyFile.h"
+
+/**
+
+    Writes losslessly compressed int16 data in fixed-length chunks
+
+    Samples are collected per channel until every channel holds a full chunk.
+    The chunk is then encoded with DeltaCodec, with channel groups encoded in
+    parallel on a shared ThreadPool, and appended to the data file as:
+
+    <uint32 encoded size of channel 1> ... <uint32 encoded size of channel N>
+    <channel 1 payload> ... <channel N payload>
+
+    Every chunk is also listed in chunk_index.npy (byte_offset, num_bytes,
+    sample_offset, num_samples) so readers can seek to any sample and decode
+    only the chunk that contains it.
+
+ */
+
+class PLUGIN_API CompressedBlockFile : public ContinuousFileWriter
+{
+public:
+    /** Creates a file with nChannels, compressing groups of channelsPerGroup on the given pool
+        (or on the calling thread if no pool is supplied) */
+    CompressedBlockFile (int nChannels, int samplesPerChunk, int channelsPerGroup, ThreadPool* threadPool);
+
+    /** Destructor (compresses and writes any remaining samples) */
+    ~CompressedBlockFile() override;
+
+    /** Opens the data file at the requested path, and its chunk index in the same folder */
+    bool openFile (String filename) override;
+
+    /** Writes nSamples of data for a particular channel */
+    bool writeChannel (uint64 startPos, int channel, int16* data, int nSamples) override;
+
+    /** Returns the compressed bytes written so far per channel sample (0 before the first chunk) */
+    double getBytesPerSample() const;
+
+    /** Name of the chunk index file written next to the data file */
+    static const char* const indexFileName;
+
+private:
+    /** Encodes one group of channels of the current chunk */
+    class CompressionJob : public ThreadPoolJob
+    {
+    public:
+        /** Constructor */
+        CompressionJob (CompressedBlockFile* file, int firstChannel, int numChannels);
+
+        /** Runs the job inside a thread */
+        JobStatus runJob() override;
+
+    private:
+        CompressedBlockFile* file;
+        const int firstChannel;
+        const int numChannels;
+    };
+
+    /** Encodes one channel of the current chunk into its slot of the chunk buffer */
+    void encodeChannel (int channel);
+
+    /** Compresses and writes the first numSamples pending samples of every channel */
+    void writeChunk (int numSamples);
+
+    std::unique_ptr<FileOutputStream> m_file;
+    std::unique_ptr<NpyFile> m_indexFile;
+    ThreadPool* m_threadPool;
+    OwnedArray<CompressionJob> m_jobs;
+
+    const int m_nChannels;
+    const int m_samplesPerChunk;
+    const int m_channelsPerGroup;
+    const size_t m_maxChannelBytes;
+
+    std::vector<std::vector<int16>> m_pending;
+    HeapBlock<uint8> m_chunkBuffer;
+    HeapBlock<uint32> m_encodedSizes;
+    int m_chunkSamples { 0 };
+
+    int64 m_bytesWritten { 0 };
+    int64 m_samplesWritten { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressedBlockFile);
+};
+
+#endif // COMPRESSEDBLOCKFILE_H
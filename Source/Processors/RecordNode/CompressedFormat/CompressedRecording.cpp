@@ -0,0 +1,112 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedRecording.h"
+#include "CompressedBlockFile.h"
+#include "DeltaCodec.h"
+
+CompressedRecording::CompressedRecording() {}
+
+CompressedRecording::~CompressedRecording() {}
+
+String CompressedRecording::getEngineId() const
+{
+    return "COMPRESSED";
+}
+
+ContinuousFileWriter* CompressedRecording::createContinuousFile (String streamPath, int numChannels, DynamicObject* streamJSON)
+{
+    if (m_threadPool == nullptr || m_threadPool->getNumThreads() != m_numThreads)
+        m_threadPool = std::make_unique<ThreadPool> (m_numThreads);
+
+    /* One group per worker thread */
+    int channelsPerGroup = (numChannels + m_numThreads - 1) / m_numThreads;
+
+    DynamicObject::Ptr compressionJSON = new DynamicObject();
+    compressionJSON->setProperty ("codec", "delta_bitpack");
+    compressionJSON->setProperty ("block_samples", DeltaCodec::samplesPerBlock);
+    compressionJSON->setProperty ("samples_per_chunk", m_samplesPerChunk);
+    compressionJSON->setProperty ("data_file", "continuous.zdat");
+    compressionJSON->setProperty ("index_file", CompressedBlockFile::indexFileName);
+    streamJSON->setProperty ("compression", var (compressionJSON));
+
+    std::unique_ptr<CompressedBlockFile> file = std::make_unique<CompressedBlockFile> (numChannels,
+                                                                                      m_samplesPerChunk,
+                                                                                      channelsPerGroup,
+                                                                                      m_threadPool.get());
+
+    if (file->openFile (streamPath + "continuous.zdat"))
+    {
+        m_compressedFiles.add (file.get());
+        return file.release();
+    }
+
+    return nullptr;
+}
+
+double CompressedRecording::getContinuousBytesPerSample() const
+{
+    return m_bytesPerSample;
+}
+
+void CompressedRecording::closeFiles()
+{
+    int64 numFiles = 0;
+    double bytesPerSample = 0.0;
+
+    for (auto file : m_compressedFiles)
+    {
+        if (file->getBytesPerSample() > 0.0)
+        {
+            bytesPerSample += file->getBytesPerSample();
+            numFiles++;
+        }
+    }
+
+    if (numFiles > 0)
+        m_bytesPerSample = bytesPerSample / numFiles;
+
+    m_compressedFiles.clear();
+
+    BinaryRecording::closeFiles();
+}
+
+RecordEngineManager* CompressedRecording::getEngineManager()
+{
+    RecordEngineManager* man = new RecordEngineManager ("COMPRESSED", "Compressed binary", &(engineFactory<CompressedRecording>) );
+    addBinaryParameters (man);
+    EngineParameter* param;
+    param = new EngineParameter (EngineParameter::INT, 10, "Compression threads", 4, 1, 32);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::INT, 11, "Samples per chunk", 16384, 1024, 1048576);
+    man->addParameter (param);
+    return man;
+}
+
+void CompressedRecording::setParameter (EngineParameter& parameter)
+{
+    BinaryRecording::setParameter (parameter);
+
+    intParameter (10, m_numThreads);
+    intParameter (11, m_samplesPerChunk);
+}
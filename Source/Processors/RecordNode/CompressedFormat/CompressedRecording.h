@@ -0,0 +1,87 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDRECORDING_H
+#define COMPRESSEDRECORDING_H
+
+#include "../BinaryFormat/BinaryRecording.h"
+
+class CompressedBlockFile;
+
+/**
+
+    Variant of the Binary format that stores continuous data losslessly compressed
+
+    Events, spikes, timestamps and structure.oebin are identical to the Binary
+    format; each stream's continuous.dat is replaced by continuous.zdat plus a
+    chunk index (see CompressedBlockFile). Channel groups are compressed in
+    parallel on a pool of worker threads, so the RecordThread only copies samples
+    and writes the finished chunks.
+
+    Compressed recordings are played back by the File Reader's Binary source,
+    which decodes one chunk at a time.
+
+ */
+
+class CompressedRecording : public BinaryRecording
+{
+public:
+    /** Constructor */
+    CompressedRecording();
+
+    /** Destructor */
+    ~CompressedRecording();
+
+    /** Returns the unique identifier of this RecordEngine */
+    String getEngineId() const override;
+
+    /** Launches the manager for this Record Engine, and instantiates any parameters */
+    static RecordEngineManager* getEngineManager();
+
+    /** Sets an engine parameter (Binary parameters, plus thread count and chunk length) */
+    void setParameter (EngineParameter& parameter) override;
+
+    /** Returns the compressed size of a sample measured in the last recording (or a typical one before that) */
+    double getContinuousBytesPerSample() const override;
+
+    /** Measures the compression achieved by this recording, then closes its files */
+    void closeFiles() override;
+
+protected:
+    /** Creates a compressed data file for one stream */
+    ContinuousFileWriter* createContinuousFile (String streamPath, int numChannels, DynamicObject* streamJSON) override;
+
+private:
+    std::unique_ptr<ThreadPool> m_threadPool;
+
+    int m_numThreads { 4 };
+    int m_samplesPerChunk { 16384 };
+
+    /** Files of the current recording, owned by BinaryRecording */
+    Array<CompressedBlockFile*> m_compressedFiles;
+
+    /** Delta-bitpacked extracellular data typically shrinks to about 60% of its raw size */
+    double m_bytesPerSample { 1.2 };
+};
+
+#endif // COMPRESSEDRECORDING_H
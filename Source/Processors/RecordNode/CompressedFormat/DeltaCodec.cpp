@@ -0,0 +1,139 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "DeltaCodec.h"
+
+namespace
+{
+/* Differences between two int16 values need 17 bits */
+const int maxBitWidth = 17;
+
+inline uint32 zigzagEncode (int32 value)
+{
+    return (uint32 (value) << 1) ^ uint32 (value >> 31);
+}
+
+inline int32 zigzagDecode (uint32 value)
+{
+    return int32 (value >> 1) ^ -int32 (value & 1);
+}
+} // namespace
+
+size_t DeltaCodec::getMaxEncodedSize (int nSamples)
+{
+    size_t numBlocks = (nSamples + samplesPerBlock - 1) / samplesPerBlock;
+    return numBlocks * (1 + (samplesPerBlock * maxBitWidth + 7) / 8);
+}
+
+size_t DeltaCodec::encodeChannel (const int16* input, int nSamples, int stride, uint8* output)
+{
+    uint8* out = output;
+    uint32 values[samplesPerBlock];
+    int32 previous = 0;
+
+    for (int blockStart = 0; blockStart < nSamples; blockStart += samplesPerBlock)
+    {
+        const int blockSize = jmin (samplesPerBlock, nSamples - blockStart);
+        uint32 combined = 0;
+
+        for (int i = 0; i < blockSize; i++)
+        {
+            int32 sample = input[(size_t) (blockStart + i) * stride];
+            values[i] = zigzagEncode (sample - previous);
+            combined |= values[i];
+            previous = sample;
+        }
+
+        int bitWidth = 0;
+
+        while (bitWidth < maxBitWidth && (combined >> bitWidth) != 0)
+            bitWidth++;
+
+        *out++ = uint8 (bitWidth);
+
+        if (bitWidth == 0)
+            continue;
+
+        uint64 accumulator = 0;
+        int bitsInAccumulator = 0;
+
+        for (int i = 0; i < blockSize; i++)
+        {
+            accumulator |= uint64 (values[i]) << bitsInAccumulator;
+            bitsInAccumulator += bitWidth;
+
+            while (bitsInAccumulator >= 8)
+            {
+                *out++ = uint8 (accumulator);
+                accumulator >>= 8;
+                bitsInAccumulator -= 8;
+            }
+        }
+
+        if (bitsInAccumulator > 0)
+            *out++ = uint8 (accumulator);
+    }
+
+    return size_t (out - output);
+}
+
+size_t DeltaCodec::decodeChannel (const uint8* input, int nSamples, int16* output, int stride)
+{
+    const uint8* in = input;
+    int32 previous = 0;
+
+    for (int blockStart = 0; blockStart < nSamples; blockStart += samplesPerBlock)
+    {
+        const int blockSize = jmin (samplesPerBlock, nSamples - blockStart);
+        const int bitWidth = *in++;
+
+        if (bitWidth == 0)
+        {
+            for (int i = 0; i < blockSize; i++)
+                output[(size_t) (blockStart + i) * stride] = int16 (previous);
+
+            continue;
+        }
+
+        const uint32 mask = (1u << bitWidth) - 1;
+        uint64 accumulator = 0;
+        int bitsInAccumulator = 0;
+
+        for (int i = 0; i < blockSize; i++)
+        {
+            while (bitsInAccumulator < bitWidth)
+            {
+                accumulator |= uint64 (*in++) << bitsInAccumulator;
+                bitsInAccumulator += 8;
+            }
+
+            previous += zigzagDecode (uint32 (accumulator) & mask);
+            accumulator >>= bitWidth;
+            bitsInAccumulator -= bitWidth;
+
+            output[(size_t) (blockStart + i) * stride] = int16 (previous);
+        }
+    }
+
+    return size_t (in - input);
+}
@@ -0,0 +1,62 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DELTACODEC_H
+#define DELTACODEC_H
+
+#include "../../../Utils/Utils.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+/**
+
+    Lossless codec for int16 sample data, used by the compressed recording format
+
+    Each channel is encoded independently as the zigzag-coded difference between
+    consecutive samples (the first sample is taken relative to zero). Differences are
+    grouped in blocks of 64; every block starts with a single byte holding the bit width
+    of its largest value, followed by the block's values packed at that width.
+
+    Neural signals change slowly relative to their int16 range, so most blocks fit in
+    4 to 8 bits per sample.
+
+ */
+
+class PLUGIN_API DeltaCodec
+{
+public:
+    /** Number of samples sharing one bit width */
+    static const int samplesPerBlock = 64;
+
+    /** Returns an upper bound on the encoded size (in bytes) of nSamples of one channel */
+    static size_t getMaxEncodedSize (int nSamples);
+
+    /** Encodes nSamples, read every `stride` values starting at `input`. Returns the number of bytes written. */
+    static size_t encodeChannel (const int16* input, int nSamples, int stride, uint8* output);
+
+    /** Decodes nSamples from `input`, writing them every `stride` values starting at `output`.
+        Returns the number of bytes consumed. */
+    static size_t decodeChannel (const uint8* input, int nSamples, int16* output, int stride);
+};
+
+#endif // DELTACODEC_H
@@ -23,6 +23,40 @@
 
 #include "DataQueue.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DATA_QUEUE_USE_SSE2 1
+#else
+#define DATA_QUEUE_USE_SSE2 0
+#endif
+
+/** Writes start + i * step for i in [0, n); each value is computed from its index,
+    so rounding errors do not accumulate along the block */
+static void fillTimestampRamp (double* dest, double start, double step, int n)
+{
+    int i = 0;
+
+#if DATA_QUEUE_USE_SSE2
+    const __m128d starts = _mm_set1_pd (start);
+    const __m128d steps = _mm_set1_pd (step);
+    const __m128d four = _mm_set1_pd (4.0);
+    __m128d indices01 = _mm_set_pd (1.0, 0.0);
+    __m128d indices23 = _mm_set_pd (3.0, 2.0);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_pd (dest + i, _mm_add_pd (starts, _mm_mul_pd (indices01, steps)));
+        _mm_storeu_pd (dest + i + 2, _mm_add_pd (starts, _mm_mul_pd (indices23, steps)));
+
+        indices01 = _mm_add_pd (indices01, four);
+        indices23 = _mm_add_pd (indices23, four);
+    }
+#endif
+
+    for (; i < n; i++)
+        dest[i] = start + double (i) * step;
+}
+
 DataQueue::DataQueue (int blockSize, int nBlocks) : m_buffer (0, blockSize * nBlocks),
                                                     m_numChans (0),
                                                     m_blockSize (blockSize),
@@ -41,6 +75,21 @@ int DataQueue::getBlockSize()
     return m_blockSize;
 }
 
+int DataQueue::getNumBlocks() const
+{
+    return m_numBlocks;
+}
+
+float DataQueue::getMaxUsage() const
+{
+    float usage = 0.0f;
+
+    for (auto* fifo : m_fifos)
+        usage = jmax (usage, (float) fifo->getNumReady() / (float) fifo->getTotalSize());
+
+    return usage;
+}
+
 void DataQueue::setTimestampStreamCount (int nStreams)
 {
     if (m_readInProgress)
@@ -158,18 +207,11 @@ float DataQueue::writeSynchronizedTimestamps (double start, double step, int des
         LOGE (__FUNCTION__, " Recording Data Queue Overflow: sz1: ", size1, " sz2: ", size2, " nSamples: ", nSamples);
     }
 
-    for (int i = 0; i < size1; i++)
-    {
-        m_FTSBuffer.setSample (destChannel, index1 + i, start + (double) i * step);
-    }
+    if (size1 > 0)
+        fillTimestampRamp (m_FTSBuffer.getWritePointer (destChannel, index1), start, step, size1);
 
     if (size2 > 0)
-    {
-        for (int i = 0; i < size2; i++)
-        {
-            m_FTSBuffer.setSample (destChannel, index2 + i, start + (double) (size1 * step) + double (i * step));
-        }
-    }
+        fillTimestampRamp (m_FTSBuffer.getWritePointer (destChannel, index2), start + double (size1) * step, step, size2);
 
     m_FTSFifos[destChannel]->finishedWrite (size1 + size2);
 
@@ -307,6 +349,47 @@ void DataQueue::stopRead()
     m_readInProgress = false;
 }
 
+void DataQueue::discardOldest (int channel, int maxReady)
+{
+    AbstractFifo* fifo = m_fifos.getUnchecked (channel);
+
+    int numToDiscard = fifo->getNumReady() - jmax (0, maxReady);
+
+    if (numToDiscard <= 0)
+        return;
+
+    fifo->finishedRead (numToDiscard);
+
+    // keep the fallback sample number in step with the new read position
+    int index1, size1, index2, size2;
+    fifo->prepareToRead (fifo->getNumReady(), index1, size1, index2, size2);
+
+    int blockMod = index1 % m_blockSize;
+    int blockDiff = (blockMod == 0) ? 0 : (m_blockSize - blockMod);
+
+    if (blockDiff < (size1 + size2))
+    {
+        int blockIdx = ((index1 + blockDiff) / m_blockSize) % m_numBlocks;
+        m_lastReadSampleNumbers[channel] = m_sampleNumbers[channel]->at (blockIdx) - blockDiff;
+    }
+    else
+    {
+        // no block starts in the remaining samples, so count on from the start of the current block
+        int blockIdx = (index1 / m_blockSize) % m_numBlocks;
+        m_lastReadSampleNumbers[channel] = m_sampleNumbers[channel]->at (blockIdx) + blockMod;
+    }
+}
+
+void DataQueue::discardOldestTimestamps (int stream, int maxReady)
+{
+    AbstractFifo* fifo = m_FTSFifos.getUnchecked (stream);
+
+    int numToDiscard = fifo->getNumReady() - jmax (0, maxReady);
+
+    if (numToDiscard > 0)
+        fifo->finishedRead (numToDiscard);
+}
+
 void DataQueue::getSampleNumbersForBlock (int idx, Array<int64>& sampleNumbers) const
 {
     sampleNumbers.clear();
@@ -81,6 +81,14 @@ public:
     /** Called when data read is finished */
     void stopRead();
 
+    /** Drops the oldest samples of a channel, so that at most maxReady samples remain.
+        Must be called from the reading side, while no other read is in progress. */
+    void discardOldest (int channel, int maxReady);
+
+    /** Drops the oldest timestamps of a stream, so that at most maxReady remain.
+        Must be called from the reading side, while no other read is in progress. */
+    void discardOldestTimestamps (int stream, int maxReady);
+
     /** Returns a reference to the continuous data buffer */
     const AudioBuffer<float>& getContinuousDataBufferReference() const;
 
@@ -90,6 +98,12 @@ public:
     /** Returns the current block size*/
     int getBlockSize();
 
+    /** Returns the number of blocks in the queue */
+    int getNumBlocks() const;
+
+    /** Returns the fraction (0-1) of the fullest channel that holds unread samples */
+    float getMaxUsage() const;
+
 private:
     /** Fills the sample number buffer for a given channel */
     void fillSampleNumbers (int channel, int index, int size, int64 sampleNumber);
@@ -29,7 +29,9 @@ DiskSpaceChecker::DiskSpaceChecker (RecordNode* rn)
       lastUpdateTime (0),
       lastFreeSpace (0),
       dataRate (0),
-      recordingTimeLeftInSeconds (0)
+      recordingTimeLeftInSeconds (0),
+      lastWriteRateTime (0),
+      lastBytesWritten (0)
 {
     startTimerHz (1);
 }
@@ -83,10 +85,22 @@ void DiskSpaceChecker::checkDirectoryAndDiskSpace()
     if (ratio > 0)
         notifyDiskSpaceRemaining (ratio);
 
-    float currentTime = Time::getMillisecondCounterHiRes();
+    const double currentTime = Time::getMillisecondCounterHiRes();
+    const int64 bytesWritten = recordNode->recordThread->getBytesWritten();
 
     if (recordNode->getRecordingStatus())
     {
+        // Update the live write bandwidth every second
+        if (currentTime > lastWriteRateTime)
+        {
+            const double bytesPerSecond = (bytesWritten - lastBytesWritten) / (currentTime - lastWriteRateTime) * 1000.0;
+
+            notifyWriteBandwidth (float (bytesPerSecond), float (recordNode->recordThread->getWriteLatencyPercentile (0.99)));
+        }
+
+        lastWriteRateTime = currentTime;
+        lastBytesWritten = bytesWritten;
+
         // Update data rate and recording time left every 5 seconds
         if (currentTime - lastUpdateTime > 5000.0f)
         {
@@ -113,10 +127,122 @@ void DiskSpaceChecker::checkDirectoryAndDiskSpace()
     {
         lastUpdateTime = currentTime;
         lastFreeSpace = bytesFree;
+        lastWriteRateTime = currentTime;
+        lastBytesWritten = bytesWritten;
         update (0, bytesFree, 0);
     }
 }
 
+double DiskSpaceChecker::measureWriteBandwidth (const File& directory, int64 numBytes)
+{
+    if (! directory.isDirectory())
+        return 0.0;
+
+    File testFile = directory.getNonexistentChildFile ("write_benchmark", ".tmp", false);
+
+    // random contents, so compressing file systems can't skip the writes
+    HeapBlock<char> chunk (DISK_BENCHMARK_CHUNK_BYTES);
+    Random().fillBitsRandomly (chunk.getData(), DISK_BENCHMARK_CHUNK_BYTES);
+
+    int64 bytesWritten = 0;
+    double elapsedSeconds = 0.0;
+
+    {
+        FileOutputStream stream (testFile);
+
+        if (stream.failedToOpen())
+            return 0.0;
+
+        const int64 startTicks = Time::getHighResolutionTicks();
+
+        while (bytesWritten < numBytes)
+        {
+            const int64 chunkBytes = jmin (int64 (DISK_BENCHMARK_CHUNK_BYTES), numBytes - bytesWritten);
+
+            if (! stream.write (chunk.getData(), size_t (chunkBytes)))
+                break;
+
+            bytesWritten += chunkBytes;
+        }
+
+        // flushing syncs the file, so the page cache doesn't hide the disk's speed
+        stream.flush();
+
+        elapsedSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+    }
+
+    testFile.deleteFile();
+
+    if (bytesWritten < numBytes || elapsedSeconds <= 0.0)
+        return 0.0;
+
+    return double (bytesWritten) / elapsedSeconds;
+}
+
+double DiskSpaceChecker::getWriteBandwidth (const File& directory)
+{
+    {
+        std::lock_guard<std::mutex> lock (bandwidthMutex);
+
+        auto it = writeBandwidths.find (directory.getFullPathName());
+
+        if (it != writeBandwidths.end())
+            return it->second;
+    }
+
+    measureWriteBandwidthAsync (directory);
+
+    return 0.0;
+}
+
+void DiskSpaceChecker::measureWriteBandwidthAsync (const File& directory)
+{
+    const String path = directory.getFullPathName();
+
+    {
+        std::lock_guard<std::mutex> lock (bandwidthMutex);
+
+        if (writeBandwidths.find (path) != writeBandwidths.end() || pendingBandwidths.count (path) > 0)
+            return;
+
+        pendingBandwidths.insert (path);
+    }
+
+    WeakReference<DiskSpaceChecker> checker (this);
+
+    // the benchmark syncs tens of megabytes to disk, so it never runs on the message thread
+    benchmarkPool.addJob ([this, checker, directory, path]
+                          {
+                              const double bytesPerSecond = measureWriteBandwidth (directory);
+
+                              {
+                                  std::lock_guard<std::mutex> lock (bandwidthMutex);
+
+                                  pendingBandwidths.erase (path);
+
+                                  if (bytesPerSecond > 0.0)
+                                      writeBandwidths[path] = bytesPerSecond;
+                              }
+
+                              if (bytesPerSecond > 0.0)
+                              {
+                                  MessageManager::callAsync ([checker]
+                                                             {
+                                                                 if (checker != nullptr)
+                                                                     checker->recordNode->checkWriteBandwidth();
+                                                             });
+                              } });
+}
+
+double DiskSpaceChecker::getMeasuredWriteBandwidth()
+{
+    std::lock_guard<std::mutex> lock (bandwidthMutex);
+
+    auto it = writeBandwidths.find (recordNode->getDataDirectory().getFullPathName());
+
+    return it != writeBandwidths.end() ? it->second : 0.0;
+}
+
 void DiskSpaceChecker::update (float dataRate, int64 bytesFree, float timeLeft)
 {
     std::lock_guard<std::mutex> lock (listenerMutex);
@@ -199,3 +325,22 @@ void DiskSpaceChecker::notifyLowDiskSpace()
         }
     }
 }
+
+void DiskSpaceChecker::notifyWriteBandwidth (float bytesPerSecond, float writeLatencyMs)
+{
+    std::lock_guard<std::mutex> lock (listenerMutex);
+    for (auto listener : listeners)
+    {
+        if (listener != nullptr)
+        {
+            juce::MessageManager::callAsync ([listener, bytesPerSecond, writeLatencyMs]()
+            {
+                try {
+                    listener->updateWriteBandwidth (bytesPerSecond, writeLatencyMs);
+                } catch (const std::exception& e) {
+                    LOGE("Error updating write bandwidth: ", e.what());
+                }
+            });
+        }
+    }
+}
@@ -26,9 +26,14 @@
 
 #include "../../../../JuceLibraryCode/JuceHeader.h"
 #include "DiskSpaceListener.h"
+#include <map>
 #include <mutex>
+#include <set>
 #include <vector>
 
+#define DISK_BENCHMARK_BYTES (64 * 1024 * 1024)
+#define DISK_BENCHMARK_CHUNK_BYTES (1024 * 1024)
+
 class RecordNode;
 
 class DiskSpaceChecker : public Timer
@@ -54,12 +59,25 @@ public:
 
     void checkDiskSpace();
 
+    /* Writes numBytes to a temporary file in a directory and returns the sustained sequential write bandwidth in bytes/s, or 0 if the directory can't be written */
+    static double measureWriteBandwidth (const File& directory, int64 numBytes = DISK_BENCHMARK_BYTES);
+
+    /* Returns the write bandwidth of a directory, or 0 while it is measured in the background the first time the directory is used */
+    double getWriteBandwidth (const File& directory);
+
+    /* Measures the write bandwidth of a directory on a background thread, then asks the Record Node to check it */
+    void measureWriteBandwidthAsync (const File& directory);
+
+    /* Returns the write bandwidth measured for the current data directory, or 0 if it hasn't been measured */
+    double getMeasuredWriteBandwidth();
+
 protected:
     void checkDirectoryAndDiskSpace();
     void update (float dataRate, int64 bytesFree, float timeLeft);
     void notifyDiskSpaceRemaining (float percentage);
     void notifyDirectoryInvalid();
     void notifyLowDiskSpace();
+    void notifyWriteBandwidth (float bytesPerSecond, float writeLatencyMs);
 
 private:
     RecordNode* recordNode;
@@ -69,8 +87,19 @@ private:
     float dataRate;
     float recordingTimeLeftInSeconds;
 
+    double lastWriteRateTime;
+    int64 lastBytesWritten;
+
+    std::map<String, double> writeBandwidths;
+    std::set<String> pendingBandwidths;
+    std::mutex bandwidthMutex;
+
     std::vector<DiskSpaceListener*> listeners;
     std::mutex listenerMutex;
+
+    ThreadPool benchmarkPool { 1 };
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (DiskSpaceChecker)
 };
 
 #endif // DISKSPACECHECKER_H_INCLUDED
\ No newline at end of file
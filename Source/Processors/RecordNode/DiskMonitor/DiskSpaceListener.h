@@ -34,6 +34,7 @@ public:
     virtual void updateDiskSpace (float percentage) = 0;
     virtual void directoryInvalid(bool recordingStopped = false) = 0;
     virtual void lowDiskSpace() = 0;
+    virtual void updateWriteBandwidth (float bytesPerSecond, float writeLatencyMs) = 0;
 };
 
 #endif // DISKSPACELISTENER_H_INCLUDED
\ No newline at end of file
@@ -26,115 +26,223 @@
 
 #include <JuceHeader.h>
 
-#include <vector>
+#include <atomic>
+#include <memory>
 
 #include "../Events/Spike.h"
 
-template <class MsgContainer>
-class AsyncEventMessage : public ReferenceCountedObject
-{
-public:
-    AsyncEventMessage (const MsgContainer& m, int64 t, int extra) : ReferenceCountedObject(),
-                                                                    m_data (m),
-                                                                    m_timestamp (t),
-                                                                    m_extra (extra)
-    {
-    }
-
-    ~AsyncEventMessage() {};
+/**
+    Single-producer, single-consumer queue of serialized events or spikes,
+    passed from the audio thread to the RecordThread.
 
-    const MsgContainer& getData() const { return m_data; }
-    const int64& getTimestamp() const { return m_timestamp; }
-    const int& getExtra() const { return m_extra; }
+    All storage is allocated up front by prepare(): a ring of fixed-size slots,
+    each large enough for the biggest packet of any channel feeding the queue.
+    Packets are serialized straight into their slot, so neither side allocates.
 
-private:
-    const MsgContainer m_data;
-    const int64 m_timestamp;
-    const int m_extra;
-};
-
-template <class EventClass>
+    When the ring is full, incoming packets are dropped and counted as overruns
+    for the channel they belong to.
+*/
 class EventQueue
 {
 public:
-    typedef AsyncEventMessage<EventClass> EventContainer;
-    typedef ReferenceCountedObjectPtr<EventContainer> EventClassPtr;
-
-    EventQueue (int size) : m_fifo (size)
+    /** A packet waiting in the queue. The data stays valid until finishRead() is called. */
+    struct Packet
     {
-        m_data.resize (size);
-    }
-
-    ~EventQueue()
+        const uint8* data;
+        size_t size;
+        int64 sampleNumber;
+        int extra;
+    };
+
+    /** Constructor */
+    EventQueue() : m_fifo (1) {}
+
+    /** Allocates numSlots slots of at least slotSize bytes each, and overrun counters for
+        numChannels channels. Must not be called while either thread is using the queue. */
+    void prepare (int numSlots, size_t slotSize, int numChannels)
     {
+        // keep each slot's header and data 8-byte aligned
+        size_t stride = (sizeof (SlotHeader) + slotSize + 7) & ~size_t (7);
+
+        if (numSlots + 1 != m_fifo.getTotalSize() || stride != m_slotStride)
+        {
+            m_fifo.setTotalSize (numSlots + 1); // the fifo holds at most totalSize - 1 items
+            m_slotStride = stride;
+            m_storage.allocate (m_slotStride * (numSlots + 1), true);
+        }
+
+        m_fifo.reset();
+        m_slotSize = slotSize;
+
+        m_numChannels = numChannels;
+        m_overruns.reset (new std::atomic<int64>[numChannels + 1]);
+        resetOverruns();
     }
 
+    /** Returns the largest packet a slot can hold */
+    size_t getSlotSize() const { return m_slotSize; }
+
+    /** Returns the number of packets waiting to be read */
     int getRemainingEvents() const
     {
         return m_fifo.getNumReady();
     }
 
+    /** Discards all queued packets */
     void reset()
     {
-        m_data.clear();
-        m_data.resize (m_fifo.getTotalSize());
+        m_fifo.reset();
     }
 
-    void resize (int size)
+    /** Clears the overrun counters (e.g. at the start of a recording) */
+    void resetOverruns()
     {
-        m_data.clear();
-        m_fifo.setTotalSize (size);
-        m_data.resize (size);
+        for (int i = 0; i <= m_numChannels; i++)
+            m_overruns[i] = 0;
     }
 
-    void addEvent (const EventClass& ev, int64 t, int extra = 0)
+    /** Returns the number of packets dropped for a channel (or for packets without a channel, if the index is out of range) */
+    int64 getOverruns (int channel) const
     {
-        int pos1, size1, pos2, size2;
-        size1 = 0;
-        m_fifo.prepareToWrite (1, pos1, size1, pos2, size2);
+        if (m_overruns == nullptr)
+            return 0;
 
-        /* This means there is a buffer overrun. Instead of overwriting the existing data and risking a collision of both threads
-			we just skip the incoming samples. TODO: use this to notify of the overrun and act consequently   */
-        if (size1 > 0)
+        return m_overruns[channelSlot (channel)].load (std::memory_order_relaxed);
+    }
+
+    /** Returns a slot for a packet of `size` bytes, or nullptr (counting an overrun for the channel)
+        if the queue is full or the packet is too large. Must be followed by finishWrite() on success. */
+    uint8* beginWrite (size_t size, int channel)
+    {
+        if (size <= m_slotSize)
         {
-            m_data[pos1] = new EventContainer (ev, t, extra);
-            m_fifo.finishedWrite (1);
+            int pos1, size1, pos2, size2;
+            size1 = 0;
+            m_fifo.prepareToWrite (1, pos1, size1, pos2, size2);
+
+            if (size1 > 0)
+            {
+                m_writeSlot = pos1;
+                return slotAt (pos1) + sizeof (SlotHeader);
+            }
+        }
+        else
+        {
+            jassert (m_slotSize == 0); // queue was prepared with a slot size that is too small for this channel
         }
+
+        if (m_overruns != nullptr)
+            m_overruns[channelSlot (channel)].fetch_add (1, std::memory_order_relaxed);
+
+        return nullptr;
     }
 
-    int getEvents (std::vector<EventClassPtr>& vec, int max)
+    /** Publishes the packet written into the slot returned by beginWrite() */
+    void finishWrite (size_t size, int64 sampleNumber, int extra)
     {
-        int pos1, size1, pos2, size2;
-        int numAvailable = m_fifo.getNumReady();
-        int numToRead = ((max < numAvailable) && (max > 0)) ? max : numAvailable;
-        m_fifo.prepareToRead (numToRead, pos1, size1, pos2, size2);
-        vec.resize (numToRead);
-        for (int i = 0; i < size1; ++i)
+        SlotHeader* header = reinterpret_cast<SlotHeader*> (slotAt (m_writeSlot));
+        header->size = size;
+        header->sampleNumber = sampleNumber;
+        header->extra = extra;
+
+        m_fifo.finishedWrite (1);
+    }
+
+    /** Copies a serialized event into the queue */
+    void addEvent (const EventPacket& ev, int64 sampleNumber, int extra = 0, int channel = -1)
+    {
+        size_t size = size_t (ev.getRawDataSize());
+
+        if (uint8* slot = beginWrite (size, channel))
         {
-            vec[i] = m_data[pos1 + i];
+            memcpy (slot, ev.getRawData(), size);
+            finishWrite (size, sampleNumber, extra);
         }
-        if (size2 > 0)
+    }
+
+    /** Serializes a spike directly into the queue */
+    void addSpike (const Spike& spike, int64 sampleNumber, int electrodeIndex)
+    {
+        size_t size = getSerializedSize (spike.getChannelInfo());
+
+        if (uint8* slot = beginWrite (size, electrodeIndex))
         {
-            for (int i = 0; i < size2; ++i)
-            {
-                vec[size1 + i] = m_data[pos2 + i];
-            }
+            spike.serialize (slot, size);
+            finishWrite (size, sampleNumber, electrodeIndex);
         }
-        m_fifo.finishedRead (numToRead);
+    }
+
+    /** Returns the size of a serialized spike from a given channel */
+    static size_t getSerializedSize (const SpikeChannel* channel)
+    {
+        return channel->getDataSize() + SPIKE_BASE_SIZE + channel->getNumChannels() * sizeof (float)
+               + channel->getTotalEventMetadataSize();
+    }
+
+    /** Makes up to max packets (all available packets if max <= 0) readable through getPacket().
+        Returns the number of packets. */
+    int startRead (int max)
+    {
+        int numAvailable = m_fifo.getNumReady();
+        int numToRead = ((max < numAvailable) && (max > 0)) ? max : numAvailable;
+
+        int size2;
+        m_fifo.prepareToRead (numToRead, m_readPos1, m_readSize1, m_readPos2, size2);
+
         return numToRead;
     }
 
+    /** Returns the index-th packet made readable by startRead() */
+    Packet getPacket (int index) const
+    {
+        int slot = (index < m_readSize1) ? m_readPos1 + index : m_readPos2 + index - m_readSize1;
+        const SlotHeader* header = reinterpret_cast<const SlotHeader*> (slotAt (slot));
+
+        return { slotAt (slot) + sizeof (SlotHeader), header->size, header->sampleNumber, header->extra };
+    }
+
+    /** Releases the slots of the packets returned by startRead() */
+    void finishRead (int numRead)
+    {
+        m_fifo.finishedRead (numRead);
+    }
+
 private:
-    std::vector<EventClassPtr> m_data;
+    struct SlotHeader
+    {
+        int64 sampleNumber;
+        size_t size;
+        int extra;
+    };
+
+    uint8* slotAt (int slot) const
+    {
+        return m_storage.getData() + size_t (slot) * m_slotStride;
+    }
+
+    int channelSlot (int channel) const
+    {
+        return (channel >= 0 && channel < m_numChannels) ? channel : m_numChannels;
+    }
+
+    HeapBlock<uint8> m_storage;
+    size_t m_slotSize { 0 };
+    size_t m_slotStride { 0 };
     AbstractFifo m_fifo;
 
+    int m_writeSlot { 0 };
+    int m_readPos1 { 0 };
+    int m_readSize1 { 0 };
+    int m_readPos2 { 0 };
+
+    int m_numChannels { 0 };
+    std::unique_ptr<std::atomic<int64>[]> m_overruns;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EventQueue);
 };
-//NOTE: Events are sent as midimessages while spikes as spike objects due to the difference on how they are passed to the record node.
-//Once the probe system is implemented, this will be normalized
-typedef EventQueue<EventPacket> EventMsgQueue;
-typedef EventQueue<Spike> SpikeMsgQueue;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<EventPacket>> EventMessagePtr;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<Spike>> SpikeMessagePtr;
+
+// Events and spikes share the same queue type, each holding serialized packets
+typedef EventQueue EventMsgQueue;
+typedef EventQueue SpikeMsgQueue;
 
 #endif // EVENTQUEUE_H_INCLUDED
@@ -25,6 +25,7 @@
 #include "RecordNode.h"
 
 #include "BinaryFormat/BinaryRecording.h"
+#include "CompressedFormat/CompressedRecording.h"
 
 RecordEngine::RecordEngine()
     : manager (nullptr), recordNode (nullptr)
@@ -70,6 +71,16 @@ const SpikeChannel* RecordEngine::getSpikeChannel (int index) const
     return recordNode->spikeChannels[index];
 }
 
+int64 RecordEngine::getNumDroppedEvents (int index) const
+{
+    return recordNode->getDroppedEvents (index);
+}
+
+int64 RecordEngine::getNumDroppedSpikes (int index) const
+{
+    return recordNode->getDroppedSpikes (index);
+}
+
 String RecordEngine::generateDateString() const
 {
     return recordNode->generateDateString();
@@ -96,6 +107,35 @@ void RecordEngine::setChannelMap (const Array<int>& globalChans,
         localChannelMap.add (chan);
 }
 
+RecordEngine* RecordEngine::createCopy() const
+{
+    RecordEngineManager* engineManager = manager;
+
+    if (engineManager == nullptr)
+    {
+        for (auto available : CoreServices::getAvailableRecordEngines())
+        {
+            if (available->getID().equalsIgnoreCase (getEngineId()))
+                engineManager = available;
+        }
+    }
+
+    if (engineManager == nullptr)
+        return nullptr;
+
+    RecordEngine* copy = engineManager->instantiateEngine();
+
+    if (copy != nullptr)
+    {
+        copy->registerRecordNode (recordNode);
+        copy->registerManager (engineManager);
+        copy->setChannelMap (globalChannelMap, localChannelMap);
+        copy->configureEngine();
+    }
+
+    return copy;
+}
+
 int64 RecordEngine::getLatestSampleNumber (int channel) const
 {
     return sampleNumbers[channel];
@@ -220,7 +260,7 @@ void RecordEngineManager::addParameter (EngineParameter* param)
 
 int RecordEngineManager::getNumOfBuiltInEngines()
 {
-    return 1;
+    return 2;
 }
 
 RecordEngineManager* RecordEngineManager::createBuiltInEngineManager (int index)
@@ -230,6 +270,9 @@ RecordEngineManager* RecordEngineManager::createBuiltInEngineManager (int index)
         case 0:
             return BinaryRecording::getEngineManager();
 
+        case 1:
+            return CompressedRecording::getEngineManager();
+
         default:
             return nullptr;
     }
@@ -247,6 +290,11 @@ RecordEngine* RecordEngineManager::instantiateEngine()
         return new BinaryRecording();
     }
 
+    if (id == "COMPRESSED")
+    {
+        return new CompressedRecording();
+    }
+
     return nullptr;
 }
 
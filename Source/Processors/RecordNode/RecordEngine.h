@@ -115,6 +115,9 @@ public:
     /** Called by configureEngine() */
     virtual void setParameter (EngineParameter& parameter) {}
 
+    /** Returns the bytes this engine is expected to write per continuous sample (used to size disk bandwidth) */
+    virtual double getContinuousBytesPerSample() const { return sizeof (int16); }
+
     // ------------------------------------------------------------
     //                    OTHER METHODS
     // ------------------------------------------------------------
@@ -134,6 +137,10 @@ public:
     /** Called at the start of every write block */
     void updateLatestSampleNumbers (const Array<int64>& sampleNumbers, int channel = -1);
 
+    /** Creates an engine of the same type with the same Record Node, manager and channel map.
+        Used to open the next recording's files while this engine is still writing. */
+    RecordEngine* createCopy() const;
+
 protected:
     // ------------------------------------------------------------
     //    HELPFUL METHODS FOR GETTING INFO ABOUT INCOMING DATA
@@ -166,6 +173,12 @@ protected:
     /** Gets the specified spike channel from the array stored in RecordNode */
     const SpikeChannel* getSpikeChannel (int index) const;
 
+    /** Gets the number of events dropped for an event channel because the record queue was full */
+    int64 getNumDroppedEvents (int index) const;
+
+    /** Gets the number of spikes dropped for a spike channel because the record queue was full */
+    int64 getNumDroppedSpikes (int index) const;
+
     /** Generate a Matlab-compatible datestring */
     String generateDateString() const;
 
@@ -84,8 +84,8 @@ RecordNode::RecordNode()
     int bufferSize = ads.bufferSize;
 
     dataQueue = std::make_unique<DataQueue> (bufferSize, DATA_BUFFER_NBLOCKS);
-    eventQueue = std::make_unique<EventMsgQueue> (EVENT_BUFFER_NEVENTS);
-    spikeQueue = std::make_unique<SpikeMsgQueue> (SPIKE_BUFFER_NSPIKES);
+    eventQueue = std::make_unique<EventMsgQueue>();
+    spikeQueue = std::make_unique<SpikeMsgQueue>();
 
     isSyncReady = true;
 
@@ -118,6 +118,7 @@ void RecordNode::registerParameters()
 
     addBooleanParameter (Parameter::PROCESSOR_SCOPE, "events", "Record Events", "Toggle saving events coming into this node", true, true);
     addBooleanParameter (Parameter::PROCESSOR_SCOPE, "spikes", "Record Spikes", "Toggle saving spikes coming into this node", true, true);
+    addFloatParameter (Parameter::PROCESSOR_SCOPE, "pre_trigger", "Pre-trigger", "Seconds of continuous data kept in memory and written when recording starts", "s", 0.0f, 0.0f, 60.0f, 0.5f, true);
 
     addMaskChannelsParameter (Parameter::STREAM_SCOPE, "channels", "Channels", "Channels to record from", true);
     addTtlLineParameter (Parameter::STREAM_SCOPE, "sync_line", "Sync Line", "Event line to use for sync signal", 8, true, false, true);
@@ -157,6 +158,10 @@ void RecordNode::parameterValueChanged (Parameter* p)
     {
         setRecordSpikes (((BooleanParameter*) p)->getBoolValue());
     }
+    else if (p->getName() == "pre_trigger")
+    {
+        preTriggerSeconds = ((FloatParameter*) p)->getFloatValue();
+    }
     else if (p->getName() == "channels")
     {
         LOGD ("Parameter changed: channels");
@@ -279,229 +284,111 @@ void RecordNode::checkDiskSpace()
     }
 }
 
-String RecordNode::handleConfigMessage (const String& msg)
+double RecordNode::getRequiredWriteBandwidth (const File& directory)
 {
-    /*
-	Available messages:
-	- engine=<engine_name> -- changes the record engine
-	- SELECT <stream_index> NONE / ALL / <channels> -- selects which channels to record, e.g.:
-		"SELECT 0 NONE" -- deselect all channels for stream 0
-		"SELECT 1 1 2 3 4 5 6 7 8" -- select channels 1-8 for stream 1
-	*/
-
-    if (CoreServices::getAcquisitionStatus())
-    {
-        return "Cannot configure Record Node while acquisition is active.";
-    }
-
-    const MessageManagerLock mml;
+    Array<bool> mainChannels, bufferChannels;
+    Array<int> channelSources, channelStreams;
 
-    StringArray tokens;
-    tokens.addTokens (msg, "=", "\"");
+    getRecordedChannels (mainChannels, bufferChannels, channelSources, channelStreams);
 
-    LOGD ("Record Node received: ", tokens[0]);
+    double bytesPerSecond = 0.0;
 
-    if (tokens[0] == "engine")
+    for (int engineIndex = 0; engineIndex <= secondaryEngines.size(); engineIndex++)
     {
-        if (tokens.size() == 2)
-        {
-            RecordNodeEditor* ed = static_cast<RecordNodeEditor*> (getEditor());
+        RecordEngine* engine = engineIndex == 0 ? recordEngine.get() : secondaryEngines[engineIndex - 1]->engine.get();
+        const File& engineDirectory = engineIndex == 0 ? dataDirectory : secondaryEngines[engineIndex - 1]->dataDirectory;
 
-            String engineValue = tokens[1];
-            int engineIndex = -1;
-
-            // Try to parse as an integer first
-            if (engineValue.containsOnly ("0123456789"))
-            {
-                engineIndex = engineValue.getIntValue();
-            }
-            else // If not an integer, try to match by name
-            {
-                auto engines = getAvailableRecordEngines();
-                for (int i = 0; i < engines.size(); ++i)
-                {
-                    if (engines[i]->getID().toLowerCase() == engineValue.toLowerCase())
-                    {
-                        engineIndex = i;
-                        break;
-                    }
-                }
-
-                if (engineIndex == -1)
-                {
-                    return "Record Node: unknown engine name \"" + engineValue + "\"";
-                }
-            }
-
-            int numEngines = ((CategoricalParameter*) getParameter ("engine"))->getCategories().size();
-
-            if (engineIndex >= 0 && engineIndex < numEngines)
-            {
-                getParameter ("engine")->setNextValue (engineIndex);
-                return "Record Node: updated record engine to " + ((CategoricalParameter*) getParameter ("engine"))->getCategories()[engineIndex];
-            }
-            else
-            {
-                return "Record Node: invalid engine index (max = " + String (numEngines - 1) + ")";
-            }
-        }
-        else
-        {
-            return "Record Node: invalid engine key";
-        }
-    }
+        if (directory != File() && engineDirectory != directory)
+            continue;
 
-    tokens.clear();
-    tokens.addTokens (msg, " ", "");
+        const double bytesPerSample = engine != nullptr ? engine->getContinuousBytesPerSample() : sizeof (int16);
 
-    LOGD (tokens[0]);
+        Array<bool> recordedStreams;
+        recordedStreams.insertMultiple (0, false, dataStreams.size());
 
-    if (tokens[0] == "SELECT")
-    {
-        if (tokens.size() >= 3)
+        for (int ch = 0; ch < mainChannels.size(); ch++)
         {
-            int streamIndex = tokens[1].getIntValue();
-            uint16 streamId;
-            //std::vector<bool> channelStates;
-            Array<var> channelStates;
-
-            int channelCount;
+            const bool recorded = engineIndex == 0 ? mainChannels[ch]
+                                                   : (secondaryEngines[engineIndex - 1]->channels.isEmpty()
+                                                      || secondaryEngines[engineIndex - 1]->channels.contains (ch));
 
-            if (streamIndex >= 0 && streamIndex < dataStreams.size())
-            {
-                streamId = dataStreams[streamIndex]->getStreamId();
-                channelCount = dataStreams[streamIndex]->getChannelCount();
-            }
-            else
-            {
-                return "Record Node: Invalid stream index; max = " + String (dataStreams.size() - 1);
-            }
-
-            if (tokens[2] == "NONE")
-            {
-                //select no channels
-                channelStates.clear();
-            }
-            else if (tokens[2] == "ALL")
-            {
-                //select all channels
-                for (int i = 0; i < channelCount; i++)
-                {
-                    channelStates.add (i);
-                }
-            }
-            else
-            {
-                Array<int> channels;
-
-                for (int i = 2; i < tokens.size(); i++)
-                {
-                    int ch = tokens[i].getIntValue() - 1;
-                    channels.add (ch);
-                }
-
-                //select some channels
-                for (int i = 0; i < channelCount; i++)
-                {
-                    if (channels.contains (i))
-                        channelStates.add (i);
-                }
-            }
+            if (! recorded)
+                continue;
 
-            DataStream* stream = getDataStream (streamId);
-            MaskChannelsParameter* maskChannels = (MaskChannelsParameter*) stream->getParameter ("channels");
-            maskChannels->setNextValue (channelStates);
+            bytesPerSecond += dataStreams[channelStreams[ch]]->getSampleRate() * bytesPerSample;
+            recordedStreams.set (channelStreams[ch], true);
         }
-        else
+
+        // each recorded stream also stores a sample number and a timestamp per sample
+        for (int i = 0; i < dataStreams.size(); i++)
         {
-            LOGD ("Record Node: invalid config message");
+            if (recordedStreams[i])
+                bytesPerSecond += dataStreams[i]->getSampleRate() * (sizeof (int64) + sizeof (double));
         }
     }
 
-    return "Record Node received config: " + msg;
+    return bytesPerSecond;
 }
 
-void RecordNode::handleBroadcastMessage (const String& msg, const int64 messageSystemTime)
+Array<File> RecordNode::getRecordingDestinations() const
 {
-    if (recordEvents && isRecording)
-    {
-        String streamKey = synchronizer.mainStreamKey;
-
-        DataStream* mainStream = getDataStream (streamKey);
-
-        int64 offsetMilliseconds = Time::currentTimeMillis() - messageSystemTime;
+    Array<File> directories;
+    directories.add (dataDirectory);
 
-        int64 messageSampleNumber = getFirstSampleNumberForBlock (mainStream->getStreamId())
-                                    - int64 (offsetMilliseconds * mainStream->getSampleRate() / 1000.0f);
+    for (auto secondary : secondaryEngines)
+        directories.addIfNotAlreadyThere (secondary->dataDirectory);
 
-        TextEventPtr event = TextEvent::createTextEvent (getMessageChannel(), messageSampleNumber, msg);
+    return directories;
+}
 
-        double ts = synchronizer.convertSampleNumberToTimestamp (synchronizer.mainStreamKey, messageSampleNumber);
+bool RecordNode::checkWriteBandwidth()
+{
+    String slowDirectories;
 
-        event->setTimestampInSeconds (ts);
+    // each destination is usually a different drive, so each one is compared with its own benchmark
+    for (auto& directory : getRecordingDestinations())
+    {
+        const double requiredBandwidth = getRequiredWriteBandwidth (directory);
 
-        size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
+        // any disk sustains low data rates, so skip the benchmark
+        if (requiredBandwidth < DISK_BANDWIDTH_MIN_CHECKED)
+            continue;
 
-        HeapBlock<char> buffer (size);
+        // an unmeasured disk is benchmarked in the background, and checked again once the result is in
+        const double availableBandwidth = diskSpaceChecker->getWriteBandwidth (directory);
 
-        event->serialize (buffer, size);
+        if (availableBandwidth <= 0.0 || requiredBandwidth <= availableBandwidth * DISK_BANDWIDTH_HEADROOM)
+            continue;
 
-        eventQueue->addEvent (EventPacket (buffer, int (size)), messageSampleNumber, -1);
+        slowDirectories += "\n";
+        slowDirectories += directory.getFullPathName() + "\n";
+        slowDirectories += "needs " + String (requiredBandwidth / pow (2, 20), 1) + " MB/s, ";
+        slowDirectories += "but the disk sustains " + String (availableBandwidth / pow (2, 20), 1) + " MB/s\n";
     }
-}
-
-void RecordNode::updateBlockSize (int newBlockSize)
-{
-    if (dataQueue->getBlockSize() != newBlockSize)
-        dataQueue = std::make_unique<DataQueue> (newBlockSize, DATA_BUFFER_NBLOCKS);
-}
-
-String RecordNode::getEngineId()
-{
-    return recordEngine->getEngineId();
-}
 
-void RecordNode::setEngine (String id)
-{
-    availableEngines = getAvailableRecordEngines();
+    if (slowDirectories.isEmpty())
+        return true;
 
-    int foundIndex = 0;
+    String msg = "Record Node " + String (getNodeId());
+    msg += "\n\n";
+    msg += "The selected channels need more write bandwidth than the disk provides in:\n";
+    msg += slowDirectories;
+    msg += "\n";
+    msg += "Recording may stop when the record buffer fills up. Please record fewer channels or distribute them across Record Nodes writing to different drives.";
 
-    for (auto engine : availableEngines)
+    if (headlessMode)
     {
-        if (engine->getID().equalsIgnoreCase (id))
-        {
-            if (recordEngine.get() != nullptr)
-            {
-                if (recordEngine->getEngineId() != id)
-                {
-                    recordEngine.reset (engine->instantiateEngine());
-
-                    if (recordThread != nullptr)
-                        recordThread->setEngine (recordEngine.get());
-                }
-            }
-            else
-            {
-                recordEngine.reset (engine->instantiateEngine());
-            }
-            engineIndex = foundIndex;
-        }
-        foundIndex += 1;
+        LOGC (msg);
+    }
+    else
+    {
+        MessageManager::callAsync ([msg]
+                                   { AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "WARNING", msg); });
     }
-}
 
-std::vector<RecordEngineManager*> RecordNode::getAvailableRecordEngines()
-{
-    return CoreServices::getAvailableRecordEngines();
+    return false;
 }
 
-String RecordNode::generateDirectoryName()
-{
-    return AccessClass::getControlPanel()->getRecordingDirectoryName();
-}
-
-// called by FifoMonitor
 File RecordNode::getDataDirectory()
 {
     return dataDirectory;
@@ -516,6 +403,10 @@ void RecordNode::setDataDirectory (File directory)
     createNewDirectory();
 
     checkDiskSpace();
+
+    // benchmark the new disk before acquisition needs it
+    if (getRequiredWriteBandwidth (dataDirectory) >= DISK_BANDWIDTH_MIN_CHECKED)
+        diskSpaceChecker->measureWriteBandwidthAsync (dataDirectory);
 }
 
 void RecordNode::setDefaultRecordingDirectory (File directory)
@@ -633,6 +524,7 @@ AudioProcessorEditor* RecordNode::createEditor()
 void RecordNode::updateSettings()
 {
     activeStreamIds.clear();
+    syncStreamHandles.clear();
     synchronizer.prepareForUpdate();
 
     for (auto stream : dataStreams)
@@ -643,7 +535,7 @@ void RecordNode::updateSettings()
 
         LOGD ("Record Node found stream: (", streamId, ") ", stream->getName(), " with sample rate ", stream->getSampleRate());
         int syncLine = syncLineParam->getSelectedLine();
-        synchronizer.addDataStream (stream->getKey(), stream->getSampleRate(), syncLine, stream->generatesTimestamps());
+        syncStreamHandles[streamId] = synchronizer.addDataStream (stream->getKey(), stream->getSampleRate(), syncLine, stream->generatesTimestamps());
 
         fifoUsage[streamId] = 0.0f;
 
@@ -725,16 +617,83 @@ bool RecordNode::startAcquisition()
         eventChannels.getLast()->setDataStream (getDataStream (synchronizer.mainStreamKey), false);
     }
 
+    if (! recordThread->isThreadRunning())
+        prepareEventQueues();
+
+    checkWriteBandwidth();
+
+    // keep the most recent samples in the record buffer until recording starts
+    preTriggerActive = preTriggerSeconds > 0 && ! isRecording;
+    preTriggerFilling = false;
+
+    if (preTriggerActive)
+        prepareRecordBuffer();
+
     if (! headlessMode)
         startTimer (1000);
 
     return true;
 }
 
+void RecordNode::prepareEventQueues()
+{
+    size_t eventSlotSize = MIN_EVENT_SLOT_SIZE;
+
+    for (auto channel : eventChannels)
+        eventSlotSize = jmax (eventSlotSize, channel->getDataSize() + channel->getTotalEventMetadataSize() + EVENT_BASE_SIZE);
+
+    size_t spikeSlotSize = 0;
+
+    for (auto channel : spikeChannels)
+        spikeSlotSize = jmax (spikeSlotSize, EventQueue::getSerializedSize (channel));
+
+    eventQueue->prepare (int (jmin (size_t (EVENT_BUFFER_NEVENTS), EVENT_BUFFER_BYTES / eventSlotSize)),
+                         eventSlotSize,
+                         eventChannels.size());
+
+    if (spikeSlotSize > 0)
+        spikeQueue->prepare (int (jmin (size_t (SPIKE_BUFFER_NSPIKES), SPIKE_BUFFER_BYTES / spikeSlotSize)),
+                             spikeSlotSize,
+                             spikeChannels.size());
+    else
+        spikeQueue->prepare (1, 0, 0);
+}
+
+int64 RecordNode::getDroppedEvents (int eventIndex) const
+{
+    return eventQueue->getOverruns (eventIndex);
+}
+
+int64 RecordNode::getDroppedSpikes (int electrodeIndex) const
+{
+    return spikeQueue->getOverruns (electrodeIndex);
+}
+
+int64 RecordNode::getDroppedEventsForStream (uint16 streamId) const
+{
+    int64 dropped = 0;
+
+    for (int i = 0; i < eventChannels.size(); i++)
+    {
+        if (eventChannels[i]->getStreamId() == streamId)
+            dropped += getDroppedEvents (i);
+    }
+
+    for (int i = 0; i < spikeChannels.size(); i++)
+    {
+        if (spikeChannels[i]->getStreamId() == streamId)
+            dropped += getDroppedSpikes (i);
+    }
+
+    return dropped;
+}
+
 bool RecordNode::stopAcquisition()
 {
     synchronizer.stopAcquisition();
 
+    preTriggerActive = false;
+
     if (hasRecorded)
     {
         // stopRecording() signals the thread to exit, but we should wait here until the thread actually gracefully
@@ -762,6 +721,10 @@ bool RecordNode::stopAcquisition()
 
     recordingNumber = 0;
     recordEngine->configureEngine();
+
+    for (auto secondary : secondaryEngines)
+        secondary->engine->configureEngine();
+
     synchronizer.reset();
     eventMonitor->reset();
 
@@ -774,12 +737,140 @@ bool RecordNode::stopAcquisition()
     return true;
 }
 
+void RecordNode::getRecordedChannels (Array<bool>& mainChannels,
+                                      Array<bool>& bufferChannels,
+                                      Array<int>& channelSources,
+                                      Array<int>& channelStreams)
+{
+    int streamIndex = 0;
+
+    for (auto stream : dataStreams)
+    {
+        for (auto channelRecordState : ((MaskChannelsParameter*) stream->getParameter ("channels"))->getChannelStates())
+        {
+            mainChannels.add (channelRecordState);
+            channelSources.add (stream->getSourceNodeId());
+            channelStreams.add (streamIndex);
+        }
+
+        streamIndex++;
+    }
+
+    // the record buffer holds every channel written by at least one engine
+    bufferChannels = mainChannels;
+
+    for (auto secondary : secondaryEngines)
+    {
+        for (int ch = 0; ch < bufferChannels.size(); ch++)
+        {
+            if (secondary->channels.isEmpty() || secondary->channels.contains (ch))
+                bufferChannels.set (ch, true);
+        }
+    }
+}
+
+void RecordNode::prepareRecordBuffer()
+{
+    Array<bool> mainChannels, bufferChannels;
+    Array<int> channelSources, channelStreams;
+
+    getRecordedChannels (mainChannels, bufferChannels, channelSources, channelStreams);
+
+    channelMap.clear();
+    timestampChannelMap.clear();
+    recordedChannelCounts.clearQuick();
+    recordedChannelCounts.insertMultiple (0, 0, dataStreams.size());
+
+    for (int ch = 0; ch < bufferChannels.size(); ch++)
+    {
+        if (bufferChannels[ch])
+        {
+            channelMap.add (ch);
+            timestampChannelMap.add (channelStreams[ch]);
+            recordedChannelCounts.set (channelStreams[ch], recordedChannelCounts[channelStreams[ch]] + 1);
+        }
+    }
+
+    validBlocks.clear();
+    validBlocks.insertMultiple (0, false, getNumInputs());
+
+    const int blockSize = dataQueue->getBlockSize();
+    float maxSampleRate = 0.0f;
+
+    for (int i = 0; i < dataStreams.size(); i++)
+    {
+        if (recordedChannelCounts[i] > 0)
+            maxSampleRate = jmax (maxSampleRate, dataStreams[i]->getSampleRate());
+    }
+
+    // until enough writes have been timed, keep the default size
+    int numBlocks = DATA_BUFFER_NBLOCKS;
+
+    if (recordThread->getNumTimedWrites() >= DATA_BUFFER_MIN_TIMED_WRITES)
+    {
+        // leave room for the data that arrives during the slowest writes seen so far
+        const double latencySeconds = recordThread->getWriteLatencyPercentile (0.999) / 1000.0;
+        const double headroomSeconds = jmax (DATA_BUFFER_MIN_SECONDS, DATA_BUFFER_LATENCY_FACTOR * latencySeconds);
+
+        numBlocks = int (std::ceil (headroomSeconds * maxSampleRate / blockSize));
+    }
+
+    numBlocks = jmax (numBlocks, DATA_BUFFER_MIN_NBLOCKS);
+
+    int headroomBlocks = numBlocks;
+
+    // the pre-trigger window is kept on top of the headroom
+    preTriggerWindowSeconds = preTriggerSeconds;
+
+    if (preTriggerSeconds > 0)
+        numBlocks += int (std::ceil (preTriggerSeconds * maxSampleRate / blockSize));
+
+    const int64 bytesPerBlock = int64 (blockSize) * (channelMap.size() * sizeof (float) + dataStreams.size() * sizeof (double));
+    const int maxBlocks = int (jmax (int64 (DATA_BUFFER_MIN_NBLOCKS), recordBufferBudget / jmax (int64 (1), bytesPerBlock)));
+
+    if (numBlocks > maxBlocks)
+    {
+        LOGC ("Record Node ", getNodeId(), ": record buffer limited to ", maxBlocks, " blocks by its ", recordBufferBudget / (1024 * 1024), " MB budget");
+        numBlocks = maxBlocks;
+
+        // shrink the window rather than the headroom, so new blocks never overflow the buffer
+        if (preTriggerSeconds > 0 && maxSampleRate > 0)
+        {
+            const int windowBlocks = jmax (0, maxBlocks - headroomBlocks);
+            preTriggerWindowSeconds = float (windowBlocks) * blockSize / maxSampleRate;
+
+            LOGC ("Record Node ", getNodeId(), ": pre-trigger window reduced from ", preTriggerSeconds, " s to ", preTriggerWindowSeconds, " s to fit the record buffer");
+        }
+
+        headroomBlocks = jmin (headroomBlocks, numBlocks);
+    }
+
+    // recording stops when less than a tenth of the headroom is left, however much of the
+    // buffer the pre-trigger window still holds when recording starts
+    maxRecordBufferUsage = 1.0f - 0.1f * float (headroomBlocks) / float (numBlocks);
+
+    LOGD ("Record Node ", getNodeId(), ": record buffer holds ", numBlocks * blockSize, " samples per channel");
+
+    if (numBlocks != dataQueue->getNumBlocks())
+        dataQueue->resize (numBlocks);
+
+    dataQueue->setChannelCount (channelMap.size());
+    dataQueue->setTimestampStreamCount (dataStreams.size());
+}
+
 // called by GenericProcessor::setRecording() and CoreServices::setRecordingStatus()
 void RecordNode::startRecording()
 {
-    Array<int> chanProcessorMap;
-    Array<int> chanOrderinProc;
-    OwnedArray<RecordProcessorInfo> procInfo;
+    // a recording started while the Record Thread is still writing continues in new files
+    if (isRecording && recordThread->isThreadRunning())
+    {
+        rolloverRecording();
+        return;
+    }
+
+    // the previous recording's remaining data is still being written
+    if (recordThread->isThreadRunning())
+        recordThread->waitForThreadToExit (-1);
 
     // in case recording starts before acquisition:
     if (eventChannels.size() == 0 || eventChannels.getLast()->getSourceNodeName() != "Message Center")
@@ -789,58 +880,57 @@ void RecordNode::startRecording()
         eventChannels.getLast()->setDataStream (getDataStream (synchronizer.mainStreamKey), false);
     }
 
-    int lastSourceNodeId = -1;
+    // when a pre-trigger window is being kept, the record buffer already holds its data
+    if (! preTriggerActive)
+        prepareRecordBuffer();
 
-    int channelIndexInRecordNode = 0;
-    int channelIndexInStream = 0;
+    Array<bool> mainChannels, bufferChannels;
+    Array<int> channelSources, channelStreams;
 
-    channelMap.clear();
-    localChannelMap.clear();
+    getRecordedChannels (mainChannels, bufferChannels, channelSources, channelStreams);
 
-    timestampChannelMap.clear();
+    recordThread->setEngineChannels (mapEngineChannels (recordEngine.get(), mainChannels, channelSources));
+    recordThread->clearSecondaryEngines();
 
-    int streamIndex = 0;
-
-    for (auto stream : dataStreams)
+    for (auto secondary : secondaryEngines)
     {
-        RecordProcessorInfo* pi = new RecordProcessorInfo();
-        pi->processorId = stream->getSourceNodeId();
+        Array<bool> channels;
 
-        if (stream->getSourceNodeId() != lastSourceNodeId)
-        {
-            channelIndexInStream = 0;
-            lastSourceNodeId = stream->getSourceNodeId();
-        }
+        for (int ch = 0; ch < bufferChannels.size(); ch++)
+            channels.add (secondary->channels.isEmpty() || secondary->channels.contains (ch));
 
-        for (auto channelRecordState : ((MaskChannelsParameter*) stream->getParameter ("channels"))->getChannelStates())
-        {
-            if (channelRecordState)
-            {
-                channelMap.add (channelIndexInRecordNode);
-                localChannelMap.add (channelIndexInStream++);
-                timestampChannelMap.add (streamIndex);
-            }
+        File secondaryRoot = secondary->dataDirectory.getChildFile (rootFolder.getRelativePathFrom (dataDirectory));
 
-            channelIndexInRecordNode++;
-        }
+        if (! secondaryRoot.exists())
+            secondaryRoot.createDirectory();
 
-        procInfo.add (pi);
-        streamIndex++;
+        recordThread->addSecondaryEngine (secondary->engine.get(),
+                                          secondaryRoot,
+                                          mapEngineChannels (secondary->engine.get(), channels, channelSources));
     }
 
-    int numRecordedChannels = channelMap.size();
+    if (! recordThread->isThreadRunning())
+    {
+        // idle copies of every engine, used to open the next recording's files during a rollover
+        Array<RecordEngine*> standbyEngines;
 
-    validBlocks.clear();
-    validBlocks.insertMultiple (0, false, getNumInputs());
+        rolloverEngines.clear();
+        standbyEngines.add (rolloverEngines.add (recordEngine->createCopy()));
 
-    recordEngine->registerRecordNode (this);
-    recordEngine->setChannelMap (channelMap, localChannelMap);
+        for (auto secondary : secondaryEngines)
+            standbyEngines.add (rolloverEngines.add (secondary->engine->createCopy()));
+
+        recordThread->setRolloverEngines (standbyEngines);
+    }
 
     recordThread->setChannelMap (channelMap);
     recordThread->setTimestampChannelMap (timestampChannelMap);
 
-    dataQueue->setChannelCount (numRecordedChannels);
-    dataQueue->setTimestampStreamCount (dataStreams.size());
+    if (! CoreServices::getAcquisitionStatus())
+        prepareEventQueues();
+
+    eventQueue->resetOverruns();
+    spikeQueue->resetOverruns();
 
     recordThread->setQueuePointers (dataQueue.get(), eventQueue.get(), spikeQueue.get());
     recordThread->setFirstBlockFlag (false);
@@ -854,9 +944,17 @@ void RecordNode::startRecording()
     }
 
     recordThread->setFileComponents (rootFolder, experimentNumber, recordingNumber);
-    recordThread->startThread();
+
+    // once process() sees isRecording it stops discarding the oldest samples, so wait for
+    // any block still doing so before the Record Thread starts reading the record buffer
     isRecording = true;
 
+    while (writingRecordBuffer)
+        Thread::yield();
+
+    preTriggerFilling = false;
+    recordThread->startThread();
+
     if (settingsNeeded)
     {
         String settingsFileName = rootFolder.getFullPathName() + File::getSeparatorString() + "settings" + ((experimentNumber > 1) ? "_" + String (experimentNumber) : String()) + ".xml";
@@ -871,6 +969,146 @@ void RecordNode::startRecording()
     }
 }
 
+bool RecordNode::rolloverRecording()
+{
+    if (! isRecording)
+        return false;
+
+    if (! recordThread->requestRollover (recordingNumber + 1))
+    {
+        LOGD ("Record Node ", getNodeId(), ": rollover is not available yet");
+        return false;
+    }
+
+    recordingNumber++;
+
+    LOGC ("Record Node ", getNodeId(), ": rolling over to recording ", recordingNumber + 1);
+
+    return true;
+}
+
+Array<int> RecordNode::mapEngineChannels (RecordEngine* engine, const Array<bool>& recorded, const Array<int>& channelSources)
+{
+    Array<int> globalChannels;
+    Array<int> localChannels;
+
+    int lastSourceNodeId = -1;
+    int channelIndexInStream = 0;
+
+    for (int ch = 0; ch < recorded.size(); ch++)
+    {
+        if (channelSources[ch] != lastSourceNodeId)
+        {
+            channelIndexInStream = 0;
+            lastSourceNodeId = channelSources[ch];
+        }
+
+        if (recorded[ch])
+        {
+            globalChannels.add (ch);
+            localChannels.add (channelIndexInStream++);
+        }
+    }
+
+    engine->registerRecordNode (this);
+    engine->setChannelMap (globalChannels, localChannels);
+
+    if (engine == recordEngine.get())
+        localChannelMap = localChannels;
+
+    Array<int> writeChannels;
+
+    for (auto ch : channelMap)
+        writeChannels.add (globalChannels.indexOf (ch));
+
+    return writeChannels;
+}
+
+void RecordNode::setRecordBufferBudget (int64 bytes)
+{
+    recordBufferBudget = bytes;
+}
+
+int64 RecordNode::getRecordBufferBudget() const
+{
+    return recordBufferBudget;
+}
+
+int RecordNode::getRecordBufferBlocks() const
+{
+    return dataQueue->getNumBlocks();
+}
+
+float RecordNode::getRecordBufferUsage() const
+{
+    return dataQueue->getMaxUsage();
+}
+
+int RecordNode::addSecondaryEngine (String engineId, File directory, const Array<int>& channels)
+{
+    if (isRecording)
+    {
+        LOGE ("Record Node ", getNodeId(), ": cannot add a record engine while recording");
+        return -1;
+    }
+
+    for (auto manager : getAvailableRecordEngines())
+    {
+        if (manager->getID().equalsIgnoreCase (engineId))
+        {
+            SecondaryEngine* secondary = new SecondaryEngine();
+            secondary->engine.reset (manager->instantiateEngine());
+            secondary->dataDirectory = directory;
+            secondary->channels = channels;
+
+            if (secondary->engine == nullptr)
+            {
+                delete secondary;
+                break;
+            }
+
+            // rollover copies are configured from the manager, so the original must be too
+            secondary->engine->registerManager (manager);
+            secondary->engine->configureEngine();
+
+            secondaryEngines.add (secondary);
+
+            // benchmark the engine's disk before acquisition needs it
+            if (getRequiredWriteBandwidth (directory) >= DISK_BANDWIDTH_MIN_CHECKED)
+                diskSpaceChecker->measureWriteBandwidthAsync (directory);
+
+            LOGC ("Record Node ", getNodeId(), ": added ", manager->getName(), " engine writing to ", directory.getFullPathName());
+
+            return secondaryEngines.size() - 1;
+        }
+    }
+
+    LOGE ("Record Node ", getNodeId(), ": unknown record engine \"", engineId, "\"");
+    return -1;
+}
+
+void RecordNode::clearSecondaryEngines()
+{
+    if (isRecording)
+        return;
+
+    recordThread->clearSecondaryEngines();
+    secondaryEngines.clear();
+}
+
+int RecordNode::getNumSecondaryEngines() const
+{
+    return secondaryEngines.size();
+}
+
+RecordEngine* RecordNode::getSecondaryEngine (int index) const
+{
+    if (auto secondary = secondaryEngines[index])
+        return secondary->engine.get();
+
+    return nullptr;
+}
+
 // called by GenericProcessor::setRecording() and CoreServices::setRecordingStatus()
 void RecordNode::stopRecording()
 {
@@ -878,6 +1116,14 @@ void RecordNode::stopRecording()
     hasRecorded = true;
     recordingNumber++; // increment recording number within this directory; should be zero for first recording
 
+    for (auto stream : dataStreams)
+    {
+        int64 dropped = getDroppedEventsForStream (stream->getStreamId());
+
+        if (dropped > 0)
+            LOGC ("Record Node ", getNodeId(), " dropped ", dropped, " events/spikes from ", stream->getName(), " because the record queue was full");
+    }
+
     if (recordThread->isThreadRunning())
     {
         recordThread->signalThreadShouldExit();
@@ -904,31 +1150,33 @@ void RecordNode::handleTTLEvent (TTLEventPtr event)
     eventMonitor->receivedEvents++;
 
     int64 sampleNumber = event->getSampleNumber();
+    uint16 streamId = event->getStreamId();
 
-    String streamKey = getDataStream (event->getStreamId())->getKey();
+    const int syncHandle = syncStreamHandles[streamId];
 
-    synchronizer.addEvent (streamKey, event->getLine(), sampleNumber, event->getState());
+    synchronizer.addEvent (syncHandle, event->getLine(), sampleNumber, event->getState());
 
     if (recordEvents && isRecording)
     {
         size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
-        uint16 streamId = event->getStreamId();
 
         double ts = -1.0;
-        if (synchronizer.streamGeneratesTimestamps (streamKey))
+        if (synchronizer.streamGeneratesTimestamps (syncHandle))
         {
             ts = getFirstTimestampForBlock (streamId) + (sampleNumber - getFirstSampleNumberForBlock (streamId)) / getDataStream (streamId)->getSampleRate();
         }
         else
         {
-            ts = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber);
+            ts = synchronizer.convertSampleNumberToTimestamp (syncHandle, sampleNumber);
         }
 
-        HeapBlock<char> buffer (size);
         event->setTimestampInSeconds (ts);
-        event->serialize (buffer, size);
 
-        eventQueue->addEvent (EventPacket (buffer, int (size)), sampleNumber);
+        if (uint8* slot = eventQueue->beginWrite (size, getIndexOfMatchingChannel (event->getChannelInfo())))
+        {
+            event->serialize (slot, size);
+            eventQueue->finishWrite (size, sampleNumber, 0);
+        }
 
         eventMonitor->bufferedEvents++;
     }
@@ -942,11 +1190,11 @@ void RecordNode::handleEvent (const EventChannel* eventInfo, const EventPacket&
 
         int eventIndex = getIndexOfMatchingChannel (eventInfo);
 
-        String streamKey = getDataStream (eventInfo->getStreamId())->getKey();
+        const int syncHandle = syncStreamHandles[eventInfo->getStreamId()];
 
-        Event::setTimestampInSeconds (packet, synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber));
+        Event::setTimestampInSeconds (packet, synchronizer.convertSampleNumberToTimestamp (syncHandle, sampleNumber));
 
-        eventQueue->addEvent (packet, sampleNumber, eventIndex);
+        eventQueue->addEvent (packet, sampleNumber, eventIndex, eventIndex);
     }
 }
 
@@ -957,18 +1205,18 @@ void RecordNode::handleSpike (SpikePtr spike)
 
     if (recordSpikes && isRecording)
     {
-        String streamKey = getDataStream (spike->getStreamId())->getKey();
         uint16 streamId = spike->getStreamId();
+        const int syncHandle = syncStreamHandles[streamId];
         int64 sampleNumber = spike->getSampleNumber();
 
         double ts = -1.0;
-        if (synchronizer.streamGeneratesTimestamps (streamKey))
+        if (synchronizer.streamGeneratesTimestamps (syncHandle))
         {
             ts = getFirstTimestampForBlock (streamId) + (sampleNumber - getFirstSampleNumberForBlock (streamId)) / getDataStream (streamId)->getSampleRate();
         }
         else
         {
-            ts = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber);
+            ts = synchronizer.convertSampleNumberToTimestamp (syncHandle, sampleNumber);
         }
 
         spike->setTimestampInSeconds (ts);
@@ -993,9 +1241,30 @@ void RecordNode::process (AudioBuffer<float>& buffer)
 
     checkForEvents (recordSpikes);
 
-    if (isRecording)
+    // startRecording() waits for this to be cleared before starting the Record Thread
+    writingRecordBuffer = true;
+
+    const bool recording = isRecording;
+
+    // between recordings, the record buffer keeps the last preTriggerSeconds of data;
+    // the Record Thread isn't reading it, so the oldest samples are dropped here
+    const bool preTriggering = ! recording && preTriggerActive && ! recordThread->isThreadRunning();
+
+    if (preTriggering && ! preTriggerFilling)
+    {
+        // drop anything left over from the previous recording
+        for (int ch = 0; ch < channelMap.size(); ch++)
+            dataQueue->discardOldest (ch, 0);
+
+        for (int stream = 0; stream < dataStreams.size(); stream++)
+            dataQueue->discardOldestTimestamps (stream, 0);
+
+        preTriggerFilling = true;
+    }
+
+    if (recording || preTriggering)
     {
-        if (! setFirstBlock)
+        if (recording && ! setFirstBlock)
         {
             MidiBuffer& eventBuffer = *AccessClass::ExternalProcessorAccessor::getMidiBuffer (this);
             HeapBlock<char> data;
@@ -1037,13 +1306,13 @@ void RecordNode::process (AudioBuffer<float>& buffer)
         {
             streamIndex++;
 
-            int recordChanCount = (*stream)["channels"].getArray()->size();
+            int recordChanCount = recordedChannelCounts[streamIndex];
 
             if (recordChanCount == 0)
                 continue;
 
             const uint16 streamId = stream->getStreamId();
-            const String streamKey = stream->getKey();
+            const int syncHandle = syncStreamHandles[streamId];
 
             uint32 numSamples = getNumSamplesInBlock (streamId);
 
@@ -1051,27 +1320,28 @@ void RecordNode::process (AudioBuffer<float>& buffer)
 
             float totalFifoUsage = 0.0f;
 
-            double first, second;
+            double first, step;
 
             if (numSamples > 0)
             {
-                if (! synchronizer.streamGeneratesTimestamps (streamKey))
+                if (! synchronizer.streamGeneratesTimestamps (syncHandle))
                 {
-                    first = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber);
-                    second = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber + 1);
+                    synchronizer.getTimestampConversion (syncHandle, sampleNumber, first, step);
                 }
                 else
                 {
                     first = getFirstTimestampForBlock (streamId);
-                    second = first + 1 / stream->getSampleRate();
+                    step = 1 / stream->getSampleRate();
                 }
                 dataQueue->writeSynchronizedTimestamps (
                     first,
-                    second - first,
+                    step,
                     streamIndex,
                     numSamples);
             }
 
+            const int preTriggerSamples = int (preTriggerWindowSeconds * stream->getSampleRate());
+
             for (int i = 0; i < recordChanCount; i++)
             {
                 channelIndex++;
@@ -1083,18 +1353,27 @@ void RecordNode::process (AudioBuffer<float>& buffer)
                                                                channelIndex,
                                                                numSamples,
                                                                sampleNumber);
+
+                    if (preTriggering)
+                        dataQueue->discardOldest (channelIndex, preTriggerSamples);
                 }
             }
 
+            if (preTriggering)
+            {
+                dataQueue->discardOldestTimestamps (streamIndex, preTriggerSamples);
+                continue;
+            }
+
             fifoUsage[streamId] = totalFifoUsage / recordChanCount;
 
-            if (fifoUsage[streamId] > 0.9)
+            if (fifoUsage[streamId] > maxRecordBufferUsage)
                 fifoAlmostFull = true;
 
             samplesWritten += numSamples;
         }
 
-        if (fifoAlmostFull)
+        if (fifoAlmostFull && recording)
         {
             CoreServices::setRecordingStatus (false);
 
@@ -1116,12 +1395,14 @@ void RecordNode::process (AudioBuffer<float>& buffer)
             }
         }
 
-        if (! setFirstBlock)
+        if (recording && ! setFirstBlock)
         {
             recordThread->setFirstBlockFlag (true);
             setFirstBlock = true;
         }
     }
+
+    writingRecordBuffer = false;
 }
 
 // called in RecordNode::handleSpike
@@ -1130,7 +1411,7 @@ void RecordNode::writeSpike (const Spike* spike, const SpikeChannel* spikeElectr
     int electrodeIndex = getIndexOfMatchingChannel (spikeElectrode);
 
     if (electrodeIndex >= 0)
-        spikeQueue->addEvent (*spike, spike->getSampleNumber(), electrodeIndex);
+        spikeQueue->addSpike (*spike, spike->getSampleNumber(), electrodeIndex);
 }
 
 void RecordNode::timerCallback()
@@ -1190,10 +1471,46 @@ void RecordNode::saveCustomParametersToXml (XmlElement* xml)
         RecordNodeEditor* recordNodeEditor = (RecordNodeEditor*) getEditor();
         xml->setAttribute ("fifoMonitorsVisible", recordNodeEditor->fifoDrawerButton->getToggleState());
     }
+
+    xml->setAttribute ("recordBufferBudget", String (recordBufferBudget));
+
+    for (auto secondary : secondaryEngines)
+    {
+        XmlElement* engineXml = xml->createNewChildElement ("SECONDARY_ENGINE");
+
+        StringArray channels;
+
+        for (auto channel : secondary->channels)
+            channels.add (String (channel));
+
+        engineXml->setAttribute ("engine", secondary->engine->getEngineId());
+        engineXml->setAttribute ("directory", secondary->dataDirectory.getFullPathName());
+        engineXml->setAttribute ("channels", channels.joinIntoString (","));
+    }
 }
 
 void RecordNode::loadCustomParametersFromXml (XmlElement* xml)
 {
+    if (xml->hasAttribute ("recordBufferBudget"))
+        recordBufferBudget = xml->getStringAttribute ("recordBufferBudget").getLargeIntValue();
+
+    clearSecondaryEngines();
+
+    for (auto* engineXml : xml->getChildWithTagNameIterator ("SECONDARY_ENGINE"))
+    {
+        Array<int> channels;
+
+        for (auto channel : StringArray::fromTokens (engineXml->getStringAttribute ("channels"), ",", ""))
+        {
+            if (channel.isNotEmpty())
+                channels.add (channel.getIntValue());
+        }
+
+        addSecondaryEngine (engineXml->getStringAttribute ("engine"),
+                            File (engineXml->getStringAttribute ("directory")),
+                            channels);
+    }
+
     if (xml->hasAttribute ("fifoMonitorsVisible"))
     {
         if (! headlessMode)
@@ -43,8 +43,18 @@
 
 #define WRITE_BLOCK_LENGTH 1024
 #define DATA_BUFFER_NBLOCKS 300
+#define DATA_BUFFER_MIN_NBLOCKS 16
+#define DATA_BUFFER_MIN_SECONDS 2.0
+#define DATA_BUFFER_BYTES (int64 (1024) * 1024 * 1024)
+#define DATA_BUFFER_LATENCY_FACTOR 4.0
+#define DATA_BUFFER_MIN_TIMED_WRITES 100
 #define EVENT_BUFFER_NEVENTS 200000
 #define SPIKE_BUFFER_NSPIKES 200000
+#define EVENT_BUFFER_BYTES (32 * 1024 * 1024)
+#define SPIKE_BUFFER_BYTES (64 * 1024 * 1024)
+#define MIN_EVENT_SLOT_SIZE 512
+#define DISK_BANDWIDTH_HEADROOM 0.8
+#define DISK_BANDWIDTH_MIN_CHECKED (4.0 * 1024 * 1024)
 
 #define NIDAQ_BIT_VOLTS 0.001221f
 #define NPX_BIT_VOLTS 0.195f
@@ -170,6 +180,38 @@ public:
     /** Sets the engine ID for this record node */
     void setEngine (String engineId);
 
+    /** Starts the next recording without stopping: its files are opened in the background, data switches
+        over to them at a block boundary, and the current files are closed in the background.
+        Returns false if not recording, or if the previous rollover hasn't finished. */
+    bool rolloverRecording();
+
+    /** Adds an engine that writes from this Record Node's record buffer alongside the main engine,
+        into its own data directory. Channels are indices into the Record Node's continuous channels;
+        an empty array records every channel. Returns the engine's index, or -1 if it can't be created. */
+    int addSecondaryEngine (String engineId, File directory, const Array<int>& channels = {});
+
+    /** Removes all secondary engines */
+    void clearSecondaryEngines();
+
+    /** Returns the number of secondary engines */
+    int getNumSecondaryEngines() const;
+
+    /** Returns a secondary engine */
+    RecordEngine* getSecondaryEngine (int index) const;
+
+    /** Sets the most memory the continuous record buffer may use, in bytes.
+        Takes effect the next time recording starts. */
+    void setRecordBufferBudget (int64 bytes);
+
+    /** Returns the memory budget of the continuous record buffer, in bytes */
+    int64 getRecordBufferBudget() const;
+
+    /** Returns the current number of blocks per channel in the continuous record buffer */
+    int getRecordBufferBlocks() const;
+
+    /** Returns the fraction (0-1) of the fullest channel's record buffer that is waiting to be written */
+    float getRecordBufferUsage() const;
+
     /** Turns event recording on or off*/
     void setRecordEvents (bool);
 
@@ -188,6 +230,17 @@ public:
     /** Checks if the current recording directory has sufficient space to record */
     void checkDiskSpace();
 
+    /** Returns the bytes per second written to a directory by the engines for the selected channels
+        (or to all directories, if none is given) */
+    double getRequiredWriteBandwidth (const File& directory = File());
+
+    /** Returns the directories written by the main engine and every secondary engine */
+    Array<File> getRecordingDestinations() const;
+
+    /** Warns if any recording directory can't sustain the channels written to it; returns false if one can't.
+        A directory that hasn't been measured yet passes, and is checked again once its benchmark finishes. */
+    bool checkWriteBandwidth();
+
     /** Returns true if this Record Node is writing data*/
     bool getRecordingStatus() const;
 
@@ -226,6 +279,9 @@ public:
 
     Array<uint16> activeStreamIds;
 
+    /** Synchronizer handle of each stream, by stream ID */
+    std::map<uint16, int> syncStreamHandles;
+
     std::map<uint16, float> fifoUsage;
 
     ScopedPointer<EventMonitor> eventMonitor;
@@ -251,6 +307,15 @@ public:
 
     DiskSpaceChecker* getDiskSpaceChecker() { return diskSpaceChecker.get(); }
 
+    /** Returns the number of events dropped for an event channel because the event queue was full */
+    int64 getDroppedEvents (int eventIndex) const;
+
+    /** Returns the number of spikes dropped for a spike channel because the spike queue was full */
+    int64 getDroppedSpikes (int electrodeIndex) const;
+
+    /** Returns the total number of events and spikes dropped for a data stream in the current recording */
+    int64 getDroppedEventsForStream (uint16 streamId) const;
+
     /** Used to update sync monitors */
     void timerCallback() override;
 
@@ -274,11 +339,60 @@ private:
     /** Handles incoming timestamp sync messages */
     virtual void handleTimestampSyncTexts (const EventPacket& packet);
 
+    /** Allocates the event and spike queue slots for the current event and spike channels */
+    void prepareEventQueues();
+
+    /** Finds the channels recorded by the main engine, and by any engine (the record buffer channels) */
+    void getRecordedChannels (Array<bool>& mainChannels,
+                              Array<bool>& bufferChannels,
+                              Array<int>& channelSources,
+                              Array<int>& channelStreams);
+
+    /** Sets up the record buffer channel maps and sizes the data queue */
+    void prepareRecordBuffer();
+
+    /** Sets the channels recorded by an engine and returns, for each record buffer channel,
+        the engine's channel index (or -1 if the engine doesn't record it) */
+    Array<int> mapEngineChannels (RecordEngine* engine, const Array<bool>& recorded, const Array<int>& channelSources);
+
+    /** An additional engine fed from the same record buffer as the main engine */
+    struct SecondaryEngine
+    {
+        std::unique_ptr<RecordEngine> engine;
+        File dataDirectory;
+        Array<int> channels;
+    };
+
+    OwnedArray<SecondaryEngine> secondaryEngines;
+
+    /** Idle engines that receive the next recording during a rollover */
+    OwnedArray<RecordEngine> rolloverEngines;
+
+    /** Number of record buffer channels for each stream */
+    Array<int> recordedChannelCounts;
+
+    /** Most memory the continuous record buffer may use */
+    int64 recordBufferBudget = DATA_BUFFER_BYTES;
+
+    /** Seconds of continuous data kept in the record buffer before recording starts */
+    float preTriggerSeconds = 0.0f;
+
+    /** The part of the pre-trigger window that fits in the record buffer, set when it is sized */
+    float preTriggerWindowSeconds = 0.0f;
+    bool preTriggerActive = false;
+    bool preTriggerFilling = false;
+
+    /** Set by process() while it may be discarding the oldest samples of the record buffer */
+    std::atomic<bool> writingRecordBuffer { false };
+
+    /** Record buffer usage above which recording is stopped, set when the buffer is sized */
+    float maxRecordBufferUsage = 0.9f;
+
     /**RecordEngines loaded**/
     OwnedArray<RecordEngine> engineArray;
 
     bool isProcessing;
-    bool isRecording;
+    std::atomic<bool> isRecording;
     bool hasRecorded;
     bool settingsNeeded;
     bool shouldRecord;
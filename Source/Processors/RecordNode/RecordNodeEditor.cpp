@@ -131,6 +131,23 @@ void StreamMonitor::timerCallback()
         setFillPercentage (((RecordNode*) processor)->fifoUsage[streamId]);
     else
         setFillPercentage (0.0);
+
+    int64 dropped = ((RecordNode*) processor)->getDroppedEventsForStream (uint16 (streamId));
+
+    if (dropped != droppedEvents)
+    {
+        if (droppedEvents == 0)
+            streamTooltip = getTooltip();
+
+        droppedEvents = dropped;
+
+        if (droppedEvents > 0)
+            setTooltip (streamTooltip + "\n" + String (droppedEvents) + " events/spikes dropped (record queue full)");
+        else
+            setTooltip (streamTooltip);
+
+        repaint();
+    }
 }
 
 void StreamMonitor::paintButton (Graphics& g, bool isMouseOver, bool isButtonDown)
@@ -149,7 +166,9 @@ void StreamMonitor::paintButton (Graphics& g, bool isMouseOver, bool isButtonDow
 
     g.addTransform (t);
 
-    if (selectedChannels == 0)
+    if (droppedEvents > 0)
+        g.setColour (Colours::red);
+    else if (selectedChannels == 0)
         g.setColour (findColour (ThemeColours::defaultText).withAlpha (0.5f));
     else
         g.setColour (findColour (ThemeColours::defaultText));
@@ -168,7 +187,9 @@ DiskMonitor::DiskMonitor (RecordNode* rn)
     : LevelMonitor (rn),
       lastFreeSpace (0.0),
       recordingTimeLeftInSeconds (0),
-      dataRate (0.0)
+      dataRate (0.0),
+      writeBandwidth (0.0f),
+      writeLatency (0.0f)
 {
     rn->getDiskSpaceChecker()->addListener (this);
     startTimerHz (1);
@@ -186,7 +207,14 @@ void DiskMonitor::update (float dataRate, int64 bytesFree, float timeLeft)
     {
         String msg = String (bytesFree / pow (2, 30)) + " GB available\n";
         msg += String (int (timeLeft / 60.0f)) + " minutes remaining\n";
-        msg += "Data rate: " + String (dataRate * 1000 / pow (2, 20), 2) + " MB/s";
+        msg += "Data rate: " + String (dataRate * 1000 / pow (2, 20), 2) + " MB/s\n";
+        msg += "Written: " + String (writeBandwidth / pow (2, 20), 2) + " MB/s, 99% of writes within " + String (int (writeLatency)) + " ms";
+
+        const double diskBandwidth = ((RecordNode*) processor)->getDiskSpaceChecker()->getMeasuredWriteBandwidth();
+
+        if (diskBandwidth > 0.0)
+            msg += "\nDisk sustains " + String (diskBandwidth / pow (2, 20), 1) + " MB/s";
+
         setTooltip (msg);
     }
     else
@@ -219,6 +247,12 @@ void DiskMonitor::lowDiskSpace()
     AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "WARNING", msg);
 }
 
+void DiskMonitor::updateWriteBandwidth (float bytesPerSecond, float writeLatencyMs)
+{
+    writeBandwidth = bytesPerSecond;
+    writeLatency = writeLatencyMs;
+}
+
 void DiskMonitor::timerCallback()
 {
     repaint();
@@ -140,6 +140,9 @@ private:
     uint64 streamId;
     int selectedChannels;
     int totalChannels;
+
+    int64 droppedEvents = 0;
+    String streamTooltip;
 };
 
 class DiskMonitor : public LevelMonitor, public DiskSpaceListener
@@ -166,10 +169,15 @@ public:
     /** Responds to low disk space */
     void lowDiskSpace() override;
 
+    /** Updates the write bandwidth measured by the record thread */
+    void updateWriteBandwidth (float bytesPerSecond, float writeLatencyMs) override;
+
 private:
     int64 lastFreeSpace;
     float recordingTimeLeftInSeconds;
     float dataRate;
+    float writeBandwidth;
+    float writeLatency;
 };
 
 class RecordChannelsParameterEditor : public ParameterEditor,
@@ -24,9 +24,6 @@
 #include "RecordThread.h"
 #include "RecordNode.h"
 
-//#define EVERY_ENGINE for(int eng = 0; eng < m_engineArray.size(); eng++) m_engineArray[eng]
-#define EVERY_ENGINE m_engine;
-
 RecordThread::RecordThread (RecordNode* parentNode, RecordEngine* engine) : Thread ("Record Thread"),
                                                                             m_engine (engine),
                                                                             recordNode (parentNode),
@@ -45,6 +42,137 @@ void RecordThread::setEngine (RecordEngine* engine)
     m_engine = engine;
 }
 
+void RecordThread::setEngineChannels (const Array<int>& writeChannels)
+{
+    if (isThreadRunning())
+        return;
+    m_engineChannels = writeChannels;
+}
+
+void RecordThread::addSecondaryEngine (RecordEngine* engine, File rootFolder, const Array<int>& writeChannels)
+{
+    if (isThreadRunning())
+        return;
+    m_secondaryEngines.add ({ engine, nullptr, rootFolder, writeChannels, {} });
+}
+
+void RecordThread::clearSecondaryEngines()
+{
+    if (isThreadRunning())
+        return;
+    m_secondaryEngines.clear();
+}
+
+void RecordThread::setRolloverEngines (const Array<RecordEngine*>& engines)
+{
+    if (isThreadRunning())
+        return;
+    m_rolloverEngines = engines;
+}
+
+bool RecordThread::requestRollover (int recordingNumber)
+{
+    if (! m_isWriting || m_rolloverState != ROLLOVER_IDLE)
+        return false;
+
+    for (auto& target : m_engines)
+    {
+        if (target.standby == nullptr)
+            return false;
+    }
+
+    m_rolloverState = ROLLOVER_OPENING;
+
+    m_rolloverPool.addJob ([this, recordingNumber]
+                           {
+                               for (auto& target : m_engines)
+                                   target.standby->openFiles (target.rootFolder, m_experimentNumber, recordingNumber);
+
+                               m_rolloverState = ROLLOVER_READY; });
+
+    return true;
+}
+
+bool RecordThread::isRolloverPending() const
+{
+    return m_rolloverState != ROLLOVER_IDLE;
+}
+
+void RecordThread::switchToRolloverFiles()
+{
+    for (auto& target : m_engines)
+    {
+        std::swap (target.engine, target.standby);
+        target.engine->updateLatestSampleNumbers (target.sampleNumbers);
+    }
+
+    // the new files start with the next samples read from the queue
+    m_firstSampleNumbers.clear();
+    m_rolloverSyncPending = ! m_syncTexts.empty();
+
+    auto softwareTime = m_syncTexts.find (0);
+
+    if (softwareTime != m_syncTexts.end())
+    {
+        for (auto& target : m_engines)
+            target.engine->writeTimestampSyncText (0, CoreServices::getSystemTime(), 0.0f, softwareTime->second);
+    }
+
+    m_rolloverState = ROLLOVER_CLOSING;
+
+    m_rolloverPool.addJob ([this]
+                           {
+                               for (auto& target : m_engines)
+                                   target.standby->closeFiles();
+
+                               m_rolloverState = ROLLOVER_IDLE; });
+}
+
+void RecordThread::writeRolloverSyncTexts()
+{
+    m_rolloverSyncPending = false;
+
+    for (auto& syncText : m_syncTexts)
+    {
+        if (syncText.first == 0)
+            continue;
+
+        auto firstSample = m_firstSampleNumbers.find (syncText.first);
+
+        // this stream has no samples in the new files yet
+        if (firstSample == m_firstSampleNumbers.end())
+        {
+            m_rolloverSyncPending = true;
+            continue;
+        }
+
+        for (auto& target : m_engines)
+            target.engine->writeTimestampSyncText (syncText.first, firstSample->second, 0.0f, syncText.second);
+    }
+}
+
+void RecordThread::updateLatestSampleNumbers (int channel)
+{
+    for (auto& target : m_engines)
+    {
+        if (channel < 0)
+        {
+            for (int chan = 0; chan < m_numChannels; ++chan)
+            {
+                if (target.writeChannels[chan] >= 0)
+                    target.sampleNumbers.set (target.writeChannels[chan], sampleNumbers[chan]);
+            }
+
+            target.engine->updateLatestSampleNumbers (target.sampleNumbers);
+        }
+        else if (target.writeChannels[channel] >= 0)
+        {
+            target.sampleNumbers.set (target.writeChannels[channel], sampleNumbers[channel]);
+            target.engine->updateLatestSampleNumbers (target.sampleNumbers, target.writeChannels[channel]);
+        }
+    }
+}
+
 void RecordThread::setFileComponents (File rootFolder, int experimentNumber, int recordingNumber)
 {
     if (isThreadRunning())
@@ -110,14 +238,46 @@ void RecordThread::run()
         timestampBufferIdxs.push_back (CircularBufferIndexes());
     }
 
+    m_channelStreamIds.clear();
+
+    for (int chan = 0; chan < m_numChannels; ++chan)
+        m_channelStreamIds.add (recordNode->getContinuousChannel (m_channelArray[chan])->getStreamId());
+
+    m_syncTexts.clear();
+    m_firstSampleNumbers.clear();
+    m_rolloverSyncPending = false;
+
+    m_engines.clear();
+    m_engines.add ({ m_engine, nullptr, m_rootFolder, m_engineChannels, {} });
+    m_engines.addArray (m_secondaryEngines);
+
+    for (int i = 0; i < m_engines.size(); i++)
+        m_engines.getReference (i).standby = m_rolloverEngines[i];
+
+    for (auto& target : m_engines)
+    {
+        if (target.writeChannels.isEmpty())
+        {
+            for (int chan = 0; chan < m_numChannels; ++chan)
+                target.writeChannels.add (chan);
+        }
+
+        int numEngineChannels = 0;
+
+        for (auto writeChannel : target.writeChannels)
+            numEngineChannels = jmax (numEngineChannels, writeChannel + 1);
+
+        target.sampleNumbers.insertMultiple (0, 0, numEngineChannels);
+    }
+
     bool closeEarly = true;
 
     //1-Open Files
     m_cleanExit = false;
     closeEarly = false;
-    Array<int64> sampleNumbers;
 
-    m_engine->openFiles (m_rootFolder, m_experimentNumber, m_recordingNumber);
+    for (auto& target : m_engines)
+        target.engine->openFiles (target.rootFolder, m_experimentNumber, m_recordingNumber);
 
     //2-Wait until the first block has arrived, so we can align the timestamps
     bool isWaiting = false;
@@ -131,11 +291,35 @@ void RecordThread::run()
     }
 
     m_dataQueue->getSampleNumbersForBlock (0, sampleNumbers);
-    m_engine->updateLatestSampleNumbers (sampleNumbers);
+    updateLatestSampleNumbers();
 
     //3-Normal loop
+    m_isWriting = true;
+
     while (! threadShouldExit())
-        writeData (dataBuffer, ftsBuffer, BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES);
+    {
+        // switch files between two writes, so every sample goes to exactly one recording
+        if (m_rolloverState == ROLLOVER_READY)
+            switchToRolloverFiles();
+
+        const int64 startTicks = Time::getHighResolutionTicks();
+
+        if (writeData (dataBuffer, ftsBuffer, BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES))
+        {
+            const double elapsedMs = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+            m_writeLatencyCounts[jmin (int (elapsedMs), numLatencyBuckets - 1)]++;
+        }
+    }
+
+    m_isWriting = false;
+
+    // a rollover requested just before stopping still gets its files
+    while (m_rolloverState == ROLLOVER_OPENING)
+        wait (1);
+
+    if (m_rolloverState == ROLLOVER_READY)
+        switchToRolloverFiles();
 
     //LOGD(__FUNCTION__, " Exiting record thread");
     //4-Before closing the thread, try to write the remaining samples
@@ -148,30 +332,57 @@ void RecordThread::run()
         writeData (dataBuffer, ftsBuffer, BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES, true);
 
         //5-Close files
-        m_engine->closeFiles();
+        for (auto& target : m_engines)
+            target.engine->closeFiles();
     }
+
+    // wait for the files of a previous recording to be closed
+    while (m_rolloverState != ROLLOVER_IDLE)
+        wait (1);
+
     m_cleanExit = true;
     m_receivedFirstBlock = false;
 
     //LOGC("RecordThread received ", spikesReceived, " spikes and wrote ", spikesWritten, ".");
 }
 
-void RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
+bool RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
                               const SynchronizedTimestampBuffer& timestampBuffer,
                               int maxSamples,
                               int maxEvents,
                               int maxSpikes,
                               bool lastBlock)
 {
+    bool wroteSamples = false;
+
     if (m_dataQueue->startRead (dataBufferIdxs, timestampBufferIdxs, sampleNumbers, maxSamples))
     {
-        m_engine->updateLatestSampleNumbers (sampleNumbers);
+        updateLatestSampleNumbers();
+
+        for (int chan = 0; chan < m_numChannels; ++chan)
+        {
+            if (dataBufferIdxs[chan].size1 > 0)
+                m_firstSampleNumbers.emplace (m_channelStreamIds[chan], sampleNumbers[chan]);
+        }
 
-        /* Copy data to record engine */
+        /* Copy data to record engines */
         for (int chan = 0; chan < m_numChannels; ++chan)
         {
             if (dataBufferIdxs[chan].size1 > 0)
             {
+                wroteSamples = true;
+
+                int numWriters = 0;
+
+                for (auto& target : m_engines)
+                {
+                    if (target.writeChannels[chan] >= 0)
+                        numWriters++;
+                }
+
+                // engines store continuous samples as 16-bit integers
+                m_bytesWritten += int64 (numWriters) * (dataBufferIdxs[chan].size1 + dataBufferIdxs[chan].size2) * int64 (sizeof (int16));
+
                 const double* r = timestampBuffer.getReadPointer (m_timestampBufferChannelArray[chan],
                                                                   dataBufferIdxs[chan].index1);
 
@@ -179,12 +390,18 @@ void RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
                 //  std::cout << "Writing " << dataBufferIdxs[chan].size1 << " samples for channel 0"
                 //            << std::endl;
 
-                m_engine->writeContinuousData (
-                    chan, // write channel (index among all recorded channels)
-                    m_channelArray[chan], // real channel (index within processor)
-                    dataBuffer.getReadPointer (chan, dataBufferIdxs[chan].index1), // pointer to float
-                    r, // pointer to float
-                    dataBufferIdxs[chan].size1); // integer
+                for (auto& target : m_engines)
+                {
+                    if (target.writeChannels[chan] < 0)
+                        continue;
+
+                    target.engine->writeContinuousData (
+                        target.writeChannels[chan], // write channel (index among the engine's recorded channels)
+                        m_channelArray[chan], // real channel (index within processor)
+                        dataBuffer.getReadPointer (chan, dataBufferIdxs[chan].index1), // pointer to float
+                        r, // pointer to float
+                        dataBufferIdxs[chan].size1); // integer
+                }
 
                 /*if (chan == 0)
 			{
@@ -212,15 +429,21 @@ void RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
                 {
                     sampleNumbers.set (chan, sampleNumbers[chan] + dataBufferIdxs[chan].size1);
 
-                    m_engine->updateLatestSampleNumbers (sampleNumbers, chan);
+                    updateLatestSampleNumbers (chan);
 
-                    m_engine->writeContinuousData (
-                        chan, // write channel (index among all recorded channels)
-                        m_channelArray[chan], // real channel (index within processor)
-                        dataBuffer.getReadPointer (chan, dataBufferIdxs[chan].index2), // pointer to float
-                        timestampBuffer.getReadPointer (m_timestampBufferChannelArray[chan],
-                                                        dataBufferIdxs[chan].index2), // pointer to float
-                        dataBufferIdxs[chan].size2); // integer
+                    for (auto& target : m_engines)
+                    {
+                        if (target.writeChannels[chan] < 0)
+                            continue;
+
+                        target.engine->writeContinuousData (
+                            target.writeChannels[chan], // write channel (index among the engine's recorded channels)
+                            m_channelArray[chan], // real channel (index within processor)
+                            dataBuffer.getReadPointer (chan, dataBufferIdxs[chan].index2), // pointer to float
+                            timestampBuffer.getReadPointer (m_timestampBufferChannelArray[chan],
+                                                            dataBufferIdxs[chan].index2), // pointer to float
+                            dataBufferIdxs[chan].size2); // integer
+                    }
 
                     //samplesWritten += dataBufferIdxs[chan].size2;
                 }
@@ -228,19 +451,35 @@ void RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
         }
 
         m_dataQueue->stopRead();
+
+        // once the engines know the first sample numbers of the rollover files
+        if (m_rolloverSyncPending)
+            writeRolloverSyncTexts();
     }
 
-    std::vector<EventMessagePtr> events;
-    int nEvents = m_eventQueue->getEvents (events, maxEvents);
+    int nEvents = m_eventQueue->startRead (maxEvents);
 
     for (int ev = 0; ev < nEvents; ++ev)
     {
-        const MidiMessage& event = events[ev]->getData();
+        EventQueue::Packet packet = m_eventQueue->getPacket (ev);
+        const EventPacket event (packet.data, int (packet.size));
 
         if (SystemEvent::getBaseType (event) == EventBase::Type::SYSTEM_EVENT)
         {
             String syncText = SystemEvent::getSyncText (event);
-            m_engine->writeTimestampSyncText (SystemEvent::getStreamId (event), SystemEvent::getSampleNumber (event), 0.0f, SystemEvent::getSyncText (event));
+            const uint16 streamId = SystemEvent::getStreamId (event);
+            int64 sampleNumber = SystemEvent::getSampleNumber (event);
+
+            m_syncTexts[streamId] = syncText;
+
+            // a pre-trigger window starts the files before the block that sent the sync text
+            auto firstSample = m_firstSampleNumbers.find (streamId);
+
+            if (streamId > 0 && firstSample != m_firstSampleNumbers.end())
+                sampleNumber = firstSample->second;
+
+            for (auto& target : m_engines)
+                target.engine->writeTimestampSyncText (streamId, sampleNumber, 0.0f, syncText);
         }
         else
         {
@@ -251,27 +490,77 @@ void RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
             const EventChannel* chan = recordNode->getEventChannel (processorId, streamId, channelIdx);
             int eventIndex = recordNode->getIndexOfMatchingChannel (chan);
 
-            m_engine->writeEvent (eventIndex, event);
+            for (auto& target : m_engines)
+                target.engine->writeEvent (eventIndex, event);
         }
     }
 
-    std::vector<SpikeMessagePtr> spikes;
-    int nSpikes = m_spikeQueue->getEvents (spikes, BLOCK_MAX_WRITE_SPIKES);
+    m_eventQueue->finishRead (nEvents);
+
+    int nSpikes = m_spikeQueue->startRead (BLOCK_MAX_WRITE_SPIKES);
 
     for (int sp = 0; sp < nSpikes; ++sp)
     {
         spikesReceived++;
 
-        if (spikes[sp] != nullptr)
+        EventQueue::Packet packet = m_spikeQueue->getPacket (sp);
+        const SpikeChannel* chan = recordNode->getSpikeChannel (packet.extra);
+        SpikePtr spike = Spike::deserialize (packet.data, chan);
+
+        if (spike != nullptr)
         {
-            const Spike& spike = spikes[sp]->getData();
-            const SpikeChannel* chan = spike.getChannelInfo();
-            int spikeIndex = recordNode->getIndexOfMatchingChannel (chan);
             spikesWritten++;
 
-            m_engine->writeSpike (spikeIndex, &spikes[sp]->getData());
+            for (auto& target : m_engines)
+                target.engine->writeSpike (packet.extra, spike.get());
         }
     }
+
+    m_spikeQueue->finishRead (nSpikes);
+
+    return wroteSamples;
+}
+
+double RecordThread::getWriteLatencyPercentile (double fraction) const
+{
+    const int64 numWrites = getNumTimedWrites();
+
+    if (numWrites == 0)
+        return 0.0;
+
+    const int64 target = int64 (std::ceil (jlimit (0.0, 1.0, fraction) * double (numWrites)));
+    int64 count = 0;
+
+    for (int i = 0; i < numLatencyBuckets; i++)
+    {
+        count += m_writeLatencyCounts[i].load (std::memory_order_relaxed);
+
+        if (count >= target)
+            return double (i + 1);
+    }
+
+    return double (numLatencyBuckets);
+}
+
+int64 RecordThread::getNumTimedWrites() const
+{
+    int64 numWrites = 0;
+
+    for (int i = 0; i < numLatencyBuckets; i++)
+        numWrites += m_writeLatencyCounts[i].load (std::memory_order_relaxed);
+
+    return numWrites;
+}
+
+int64 RecordThread::getBytesWritten() const
+{
+    return m_bytesWritten.load (std::memory_order_relaxed);
+}
+
+void RecordThread::resetWriteLatencies()
+{
+    for (int i = 0; i < numLatencyBuckets; i++)
+        m_writeLatencyCounts[i] = 0;
 }
 
 void RecordThread::forceCloseFiles()
@@ -279,6 +568,8 @@ void RecordThread::forceCloseFiles()
     if (isThreadRunning() || m_cleanExit)
         return;
 
-    m_engine->closeFiles();
+    for (auto& target : m_engines)
+        target.engine->closeFiles();
+
     m_cleanExit = true;
 }
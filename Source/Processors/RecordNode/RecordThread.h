@@ -29,6 +29,7 @@
 #include "DataQueue.h"
 #include "EventQueue.h"
 #include <atomic>
+#include <map>
 
 #define BLOCK_MAX_WRITE_SAMPLES 4096
 #define BLOCK_MAX_WRITE_EVENTS 50000
@@ -75,12 +76,77 @@ public:
     /** Updates the Record Engine for this thread*/
     void setEngine (RecordEngine* engine);
 
+    /** Sets which data queue channels the main engine writes. For each queue channel,
+        holds the engine's channel index, or -1 if the engine doesn't record it.
+        An empty array writes every queue channel. */
+    void setEngineChannels (const Array<int>& writeChannels);
+
+    /** Adds an engine that is fed from the same queue reads as the main engine,
+        writing into its own root folder */
+    void addSecondaryEngine (RecordEngine* engine, File rootFolder, const Array<int>& writeChannels);
+
+    /** Removes all secondary engines */
+    void clearSecondaryEngines();
+
+    /** Sets the idle engines used to open the next recording during a rollover,
+        one for the main engine followed by one for each secondary engine */
+    void setRolloverEngines (const Array<RecordEngine*>& engines);
+
+    /** Opens the files of the next recording in the background. Once they are open, the thread
+        switches to them between two writes and closes the previous files in the background.
+        Returns false if a rollover is already in progress or isn't available. */
+    bool requestRollover (int recordingNumber);
+
+    /** Returns true while a rollover is opening the next files or closing the previous ones */
+    bool isRolloverPending() const;
+
+    /** Returns the time (in ms) within which the given fraction of data writes finished,
+        measured over all recordings since the last reset */
+    double getWriteLatencyPercentile (double fraction) const;
+
+    /** Returns the number of data writes that have been timed */
+    int64 getNumTimedWrites() const;
+
+    /** Returns the number of bytes of continuous samples passed to the record engines since the thread was created */
+    int64 getBytesWritten() const;
+
+    /** Clears the measured write latencies */
+    void resetWriteLatencies();
+
     /** Pointer to the RecordNode */
     RecordNode* recordNode;
 
 private:
-    /** Writes continuous data with an array of synchronized timestamps */
-    void writeData (const AudioBuffer<float>& dataBuffer,
+    /** An engine written by this thread, and the data queue channels it records */
+    struct EngineTarget
+    {
+        RecordEngine* engine;
+        RecordEngine* standby;
+        File rootFolder;
+        Array<int> writeChannels;
+        Array<int64> sampleNumbers;
+    };
+
+    /** Maps the queue's latest sample numbers onto each engine's channels */
+    void updateLatestSampleNumbers (int channel = -1);
+
+    /** Swaps every engine with its standby engine, and closes the previous files in the background */
+    void switchToRolloverFiles();
+
+    /** Writes the sync text of every stream that has started writing to the rollover files */
+    void writeRolloverSyncTexts();
+
+    enum RolloverState
+    {
+        ROLLOVER_IDLE,
+        ROLLOVER_OPENING,
+        ROLLOVER_READY,
+        ROLLOVER_CLOSING
+    };
+
+    /** Writes continuous data with an array of synchronized timestamps.
+        Returns true if any samples were written. */
+    bool writeData (const AudioBuffer<float>& dataBuffer,
                     const SynchronizedTimestampBuffer& timestampBuffer,
                     int maxSamples,
                     int maxEvents,
@@ -88,14 +154,42 @@ private:
                     bool lastBlock = false);
 
     RecordEngine* m_engine;
+    Array<int> m_engineChannels;
+    Array<EngineTarget> m_secondaryEngines;
+
+    /** The main engine followed by the secondary engines, built when the thread starts */
+    Array<EngineTarget> m_engines;
+
+    Array<RecordEngine*> m_rolloverEngines;
+    std::atomic<int> m_rolloverState { ROLLOVER_IDLE };
+    ThreadPool m_rolloverPool { 1 };
+
     Array<int> m_channelArray;
     Array<int> m_timestampBufferChannelArray;
 
+    /** Stream ID of each data queue channel, set when the thread starts */
+    Array<uint16> m_channelStreamIds;
+
+    /** The sync texts received during this recording, by stream ID (0 for the software time) */
+    std::map<uint16, String> m_syncTexts;
+
+    /** The first sample number written to the current files, by stream ID */
+    std::map<uint16, int64> m_firstSampleNumbers;
+
+    /** True until every stream's sync text has been written to the rollover files */
+    bool m_rolloverSyncPending = false;
+
     DataQueue* m_dataQueue;
     EventMsgQueue* m_eventQueue;
     SpikeMsgQueue* m_spikeQueue;
 
     std::atomic<bool> m_receivedFirstBlock;
+    std::atomic<bool> m_isWriting { false };
+
+    /** Number of data writes that took each whole number of milliseconds; the last bucket holds anything longer */
+    static const int numLatencyBuckets = 2000;
+    std::atomic<int64> m_writeLatencyCounts[numLatencyBuckets] {};
+    std::atomic<int64> m_bytesWritten { 0 };
     std::atomic<bool> m_cleanExit;
 
     Array<int64> sampleNumbers;
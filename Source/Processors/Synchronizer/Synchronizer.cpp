@@ -47,6 +47,8 @@ void SyncStream::reset (String mainStreamKey)
     latestGlobalSyncTime = 0.0;
     latestSyncMillis = -1;
 
+    resetRegression();
+
     if (isMainStream)
     {
         actualSampleRate = expectedSampleRate;
@@ -61,9 +63,287 @@ void SyncStream::reset (String mainStreamKey)
         overrideHardwareTimestamps = syncLine > -1; // override hardware timestamps for other streams if sync line is set
         isSynchronized = generatesTimestamps && !overrideHardwareTimestamps; // if the stream generates its own timestamps, it is synchronized unless it overrides hardware timestamps
     }
+
+    // discard events queued before the reset
+    eventFifo.finishedRead (eventFifo.getNumReady());
+
+    publishConversion();
+}
+
+void SyncStream::queueEvent (int64 sampleNumber, bool state)
+{
+    int start1, size1, start2, size2;
+    eventFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return; // the timer thread is behind; sync pulses are rare enough to drop one
+
+    queuedEvents[start1] = { sampleNumber, Time::currentTimeMillis(), state };
+    eventFifo.finishedWrite (1);
+}
+
+void SyncStream::addQueuedEvents()
+{
+    int start1, size1, start2, size2;
+    eventFifo.prepareToRead (eventFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; i++)
+        addEvent (queuedEvents[start1 + i].sampleNumber, queuedEvents[start1 + i].state, queuedEvents[start1 + i].computerTimeMillis);
+
+    for (int i = 0; i < size2; i++)
+        addEvent (queuedEvents[start2 + i].sampleNumber, queuedEvents[start2 + i].state, queuedEvents[start2 + i].computerTimeMillis);
+
+    eventFifo.finishedRead (size1 + size2);
+}
+
+void SyncStream::updateConversionSegment()
+{
+    if (fitIsValid && ! isMainStream)
+    {
+        // the segment already starts at the latest matched pulse
+        if (segmentFromFit && segmentSampleNumber == lastMatchedSampleNumber)
+            return;
+
+        const int64 boundary = lastMatchedSampleNumber;
+        const double fitTime = predictGlobalTime (boundary);
+
+        segmentFromFit = true;
+
+        /* Start the new segment where the current one reaches the pulse, so that timestamps
+           never step, and steer it onto the regression line by the time the next pulse is due */
+        if (segmentSampleRate > 0 && boundary > segmentSampleNumber)
+        {
+            const int64 pulseInterval = boundary - segmentSampleNumber;
+            const double segmentTime = segmentTimestamp + double (pulseInterval) / segmentSampleRate;
+            const double offset = segmentTime - fitTime;
+
+            if (std::abs (offset) < MIN_OUTLIER_RESIDUAL_S)
+            {
+                segmentSampleNumber = boundary;
+                segmentTimestamp = segmentTime;
+                segmentSampleRate = 1.0 / (fitSecondsPerSample - offset / double (pulseInterval));
+                return;
+            }
+        }
+
+        // too far from the fit to steer (e.g. after the clocks changed): start on the regression line
+        segmentSampleNumber = boundary;
+        segmentTimestamp = fitTime;
+        segmentSampleRate = 1.0 / fitSecondsPerSample;
+    }
+    else
+    {
+        segmentFromFit = false;
+        segmentSampleNumber = baselineMatchingPulse.localSampleNumber;
+        segmentTimestamp = baselineMatchingPulse.globalTimestamp;
+        segmentSampleRate = actualSampleRate;
+    }
+}
+
+void SyncStream::resetRegression()
+{
+    regressionStart = 0;
+    regressionCount = 0;
+    sumX = sumY = sumXX = sumXY = sumYY = 0;
+    lastMatchedSampleNumber = -1;
+    consecutiveOutliers = 0;
+    fitIsValid = false;
+    fitResidualRms = 0.0;
+}
+
+void SyncStream::rebaseRegression()
+{
+    const MatchedPulse& origin = regressionWindow[regressionStart];
+    regressionOriginSample = origin.localSampleNumber;
+    regressionOriginTime = origin.globalTimestamp;
+
+    sumX = sumY = sumXX = sumXY = sumYY = 0;
+
+    for (int i = 0; i < regressionCount; i++)
+    {
+        const MatchedPulse& pulse = regressionWindow[(regressionStart + i) % REGRESSION_WINDOW_PULSES];
+        const double x = double (pulse.localSampleNumber - regressionOriginSample);
+        const double y = pulse.globalTimestamp - regressionOriginTime;
+
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        sumYY += y * y;
+    }
+}
+
+double SyncStream::predictGlobalTime (int64 localSampleNumber) const
+{
+    return regressionOriginTime + fitIntercept + fitSecondsPerSample * double (localSampleNumber - regressionOriginSample);
+}
+
+void SyncStream::addMatchedPulse (int64 localSampleNumber, double globalTimestamp)
+{
+    // the same match is found again on every timer tick until a newer pulse arrives
+    if (localSampleNumber <= lastMatchedSampleNumber)
+        return;
+
+    lastMatchedSampleNumber = localSampleNumber;
+
+    if (fitIsValid)
+    {
+        const double residual = globalTimestamp - predictGlobalTime (localSampleNumber);
+
+        if (std::abs (residual) > jmax (MIN_OUTLIER_RESIDUAL_S, 5.0 * fitResidualRms))
+        {
+            if (++consecutiveOutliers < MAX_CONSECUTIVE_OUTLIERS)
+                return;
+
+            // persistent outliers mean the clocks have changed: start again
+            resetRegression();
+            lastMatchedSampleNumber = localSampleNumber;
+        }
+    }
+
+    consecutiveOutliers = 0;
+
+    if (regressionCount == REGRESSION_WINDOW_PULSES)
+    {
+        // slide the window by dropping the oldest pulse
+        const MatchedPulse& oldest = regressionWindow[regressionStart];
+        const double x = double (oldest.localSampleNumber - regressionOriginSample);
+        const double y = oldest.globalTimestamp - regressionOriginTime;
+
+        sumX -= x;
+        sumY -= y;
+        sumXX -= x * x;
+        sumXY -= x * y;
+        sumYY -= y * y;
+
+        regressionStart = (regressionStart + 1) % REGRESSION_WINDOW_PULSES;
+        regressionCount--;
+
+        // every time the window turns over, move the origin up to it (amortized O(1))
+        if (regressionStart == 0)
+            rebaseRegression();
+    }
+
+    if (regressionCount == 0)
+    {
+        regressionOriginSample = localSampleNumber;
+        regressionOriginTime = globalTimestamp;
+    }
+
+    regressionWindow[(regressionStart + regressionCount) % REGRESSION_WINDOW_PULSES] = { localSampleNumber, globalTimestamp };
+    regressionCount++;
+
+    const double x = double (localSampleNumber - regressionOriginSample);
+    const double y = globalTimestamp - regressionOriginTime;
+
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+    sumYY += y * y;
+
+    const double n = double (regressionCount);
+    const double sxx = sumXX - sumX * sumX / n;
+    const double sxy = sumXY - sumX * sumY / n;
+    const double syy = sumYY - sumY * sumY / n;
+
+    if (regressionCount < MIN_REGRESSION_PULSES || sxx <= 0)
+    {
+        fitIsValid = false;
+        return;
+    }
+
+    fitSecondsPerSample = sxy / sxx;
+    fitIntercept = (sumY - fitSecondsPerSample * sumX) / n;
+    fitResidualRms = std::sqrt (jmax (0.0, syy - fitSecondsPerSample * sxy) / n);
+
+    fitIsValid = fitSecondsPerSample > 0
+                 && std::abs (1.0 / fitSecondsPerSample - expectedSampleRate) / expectedSampleRate < 0.05;
 }
 
-void SyncStream::addEvent (int64 sampleNumber, bool state)
+void SyncStream::publishConversion()
+{
+    updateConversionSegment();
+
+    const uint32 sequence = conversionSequence.load (std::memory_order_relaxed);
+
+    conversionSequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    conversionSynchronized.store (isSynchronized, std::memory_order_relaxed);
+    conversionBaseSampleNumber.store (segmentSampleNumber, std::memory_order_relaxed);
+    conversionBaseTimestamp.store (segmentTimestamp, std::memory_order_relaxed);
+    conversionSampleRate.store (segmentSampleRate, std::memory_order_relaxed);
+
+    conversionSequence.store (sequence + 2, std::memory_order_release);
+}
+
+bool SyncStream::readConversion (int64& baseSampleNumber, double& baseTimestamp, double& sampleRate) const
+{
+    for (;;)
+    {
+        const uint32 sequence = conversionSequence.load (std::memory_order_acquire);
+
+        if (sequence & 1)
+            continue; // publish in progress
+
+        const bool synchronized = conversionSynchronized.load (std::memory_order_relaxed);
+        baseSampleNumber = conversionBaseSampleNumber.load (std::memory_order_relaxed);
+        baseTimestamp = conversionBaseTimestamp.load (std::memory_order_relaxed);
+        sampleRate = conversionSampleRate.load (std::memory_order_relaxed);
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (conversionSequence.load (std::memory_order_relaxed) == sequence)
+            return synchronized;
+    }
+}
+
+double SyncStream::toTimestamp (int64 sampleNumber) const
+{
+    int64 baseSampleNumber;
+    double baseTimestamp, sampleRate;
+
+    if (! readConversion (baseSampleNumber, baseTimestamp, sampleRate))
+        return -1.0;
+
+    return double (sampleNumber - baseSampleNumber) / sampleRate + baseTimestamp;
+}
+
+int64 SyncStream::toSampleNumber (double timestamp) const
+{
+    int64 baseSampleNumber;
+    double baseTimestamp, sampleRate;
+
+    if (! readConversion (baseSampleNumber, baseTimestamp, sampleRate))
+        return -1;
+
+    return int64 ((timestamp - baseTimestamp) * sampleRate) + baseSampleNumber;
+}
+
+bool SyncStream::toTimestampRamp (int64 sampleNumber, double& timestamp, double& secondsPerSample) const
+{
+    int64 baseSampleNumber;
+    double baseTimestamp, sampleRate;
+
+    if (! readConversion (baseSampleNumber, baseTimestamp, sampleRate))
+        return false;
+
+    timestamp = double (sampleNumber - baseSampleNumber) / sampleRate + baseTimestamp;
+    secondsPerSample = 1.0 / sampleRate;
+
+    return true;
+}
+
+bool SyncStream::hasSynchronizedConversion() const
+{
+    int64 baseSampleNumber;
+    double baseTimestamp, sampleRate;
+
+    return readConversion (baseSampleNumber, baseTimestamp, sampleRate);
+}
+
+void SyncStream::addEvent (int64 sampleNumber, bool state, int64 computerTimeMillis)
 {
     //LOGD ("[+] Adding event for stream ", streamKey, " (", sampleNumber, ")");
 
@@ -72,7 +352,7 @@ void SyncStream::addEvent (int64 sampleNumber, bool state)
         SyncPulse latestPulse;
         latestPulse.localSampleNumber = sampleNumber;
         latestPulse.localTimestamp = double(sampleNumber) / expectedSampleRate;
-        latestPulse.computerTimeMillis = Time::currentTimeMillis();
+        latestPulse.computerTimeMillis = computerTimeMillis;
 
         pulses.insert (pulses.begin(), latestPulse);
     }
@@ -120,6 +400,9 @@ double SyncStream::getLatestSyncTime()
 
 double SyncStream::getSyncAccuracy()
 {
+    if (fitIsValid)
+        return fitResidualRms * 1000;
+
     if (pulses.size() > 0)
     {
 
@@ -185,6 +468,8 @@ void SyncStream::syncWith (const SyncStream* mainStream)
                                 latestSyncSampleNumber = pulse.localSampleNumber;
                                 latestGlobalSyncTime = pulse.globalTimestamp;
                                 latestSyncMillis = pulse.computerTimeMillis;
+
+                                addMatchedPulse (pulse.localSampleNumber, mainPulse.localTimestamp);
                                 //LOGD ("Pulse at ", pulse.localTimestamp, " matches with 4 main pulses at ", index);
                                 //LOGD ("latestSyncSampleNumber: ", latestSyncSampleNumber, ", latestGlobalSyncTime: ", latestGlobalSyncTime);
 
@@ -347,7 +632,11 @@ Synchronizer::Synchronizer()
 
 void Synchronizer::reset()
 {
-    for (auto [id, stream] : streams)
+    const ScopedLock sl (synchronizerLock);
+
+    mainStreamHandle = getStreamHandle (mainStreamKey);
+
+    for (auto stream : dataStreamObjects)
         stream->reset (mainStreamKey);
 }
 
@@ -355,6 +644,7 @@ void Synchronizer::prepareForUpdate()
 {
     previousMainStreamKey = mainStreamKey;
     mainStreamKey = String();
+    mainStreamHandle = -1;
     dataStreamObjects.clear();
     streams.clear();
     streamCount = 0;
@@ -379,7 +669,7 @@ void Synchronizer::finishedUpdate()
     reset();
 }
 
-void Synchronizer::addDataStream (String streamKey, float expectedSampleRate, int syncLine, bool generatesTimestamps)
+int Synchronizer::addDataStream (String streamKey, float expectedSampleRate, int syncLine, bool generatesTimestamps)
 {
     LOGD ("Synchronizer adding ", streamKey, " with sample rate ", expectedSampleRate);
 
@@ -391,11 +681,25 @@ void Synchronizer::addDataStream (String streamKey, float expectedSampleRate, in
         mainStreamKey = previousMainStreamKey;
 
     //std::cout << "Creating new Stream object" << std::endl;
-    dataStreamObjects.add (new SyncStream (streamKey, expectedSampleRate, this, generatesTimestamps));
-    streams[streamKey] = dataStreamObjects.getLast();
-    streams[streamKey]->syncLine = syncLine;
+    SyncStream* stream = dataStreamObjects.add (new SyncStream (streamKey, expectedSampleRate, this, generatesTimestamps));
+    stream->syncLine = syncLine;
+    streams[streamKey] = dataStreamObjects.size() - 1;
 
     streamCount++;
+
+    return streams[streamKey];
+}
+
+int Synchronizer::getStreamHandle (const String& streamKey) const
+{
+    auto it = streams.find (streamKey);
+
+    return it != streams.end() ? it->second : -1;
+}
+
+SyncStream* Synchronizer::getStream (const String& streamKey) const
+{
+    return getStream (getStreamHandle (streamKey));
 }
 
 void Synchronizer::setMainDataStream (String streamKey)
@@ -412,17 +716,32 @@ void Synchronizer::setMainDataStream (String streamKey)
 
 void Synchronizer::setSyncLine (String streamKey, int ttlLine)
 {
-    streams[streamKey]->syncLine = ttlLine;
+    SyncStream* stream = getStream (streamKey);
+
+    if (stream == nullptr)
+        return;
+
+    const ScopedLock sl (synchronizerLock);
+
+    stream->syncLine = ttlLine;
 
     if (streamKey == mainStreamKey)
         reset();
     else
-        streams[streamKey]->reset (mainStreamKey);
+        stream->reset (mainStreamKey);
 }
 
 int Synchronizer::getSyncLine (String streamKey)
 {
-    return streams[streamKey]->syncLine;
+    return getSyncLine (getStreamHandle (streamKey));
+}
+
+int Synchronizer::getSyncLine (int streamHandle) const
+{
+    if (SyncStream* stream = getStream (streamHandle))
+        return stream->syncLine;
+
+    return -1;
 }
 
 void Synchronizer::startAcquisition()
@@ -446,61 +765,83 @@ void Synchronizer::addEvent (String streamKey,
                              int64 sampleNumber,
                              bool state)
 {
-    const ScopedLock sl (synchronizerLock);
+    addEvent (getStreamHandle (streamKey), ttlLine, sampleNumber, state);
+}
 
+void Synchronizer::addEvent (int streamHandle,
+                             int ttlLine,
+                             int64 sampleNumber,
+                             bool state)
+{
     if (streamCount == 1 || sampleNumber < 1000)
         return;
 
-    if (streams[streamKey]->syncLine == ttlLine)
-    {
-        streams[streamKey]->addEvent (sampleNumber, state);
-    }
+    SyncStream* stream = getStream (streamHandle);
+
+    // queued for the timer thread, so that the sync estimator never holds up processing
+    if (stream != nullptr && stream->syncLine == ttlLine)
+        stream->queueEvent (sampleNumber, state);
 }
 
 double Synchronizer::convertSampleNumberToTimestamp (String streamKey, int64 sampleNumber)
 {
-    if (streams[streamKey]->isSynchronized)
-    {
-        return double(sampleNumber - streams[streamKey]->baselineMatchingPulse.localSampleNumber) 
-            / streams[streamKey]->actualSampleRate 
-            + streams[streamKey]->baselineMatchingPulse.globalTimestamp;
-    }
-    else
+    return convertSampleNumberToTimestamp (getStreamHandle (streamKey), sampleNumber);
+}
+
+double Synchronizer::convertSampleNumberToTimestamp (int streamHandle, int64 sampleNumber) const
+{
+    if (SyncStream* stream = getStream (streamHandle))
+        return stream->toTimestamp (sampleNumber);
+
+    return -1.0;
+}
+
+bool Synchronizer::getTimestampConversion (int streamHandle, int64 sampleNumber, double& timestamp, double& secondsPerSample) const
+{
+    if (SyncStream* stream = getStream (streamHandle))
     {
-        return (double) -1.0f;
+        if (stream->toTimestampRamp (sampleNumber, timestamp, secondsPerSample))
+            return true;
     }
+
+    timestamp = -1.0;
+    secondsPerSample = 0.0;
+
+    return false;
 }
 
 int64 Synchronizer::convertTimestampToSampleNumber (String streamKey, double timestamp)
 {
-    if (streams[streamKey]->isSynchronized)
-    {
-        int64 t = int64 ((timestamp - streams[streamKey]->baselineMatchingPulse.globalTimestamp) 
-            * streams[streamKey]->actualSampleRate)
-                  + streams[streamKey]->baselineMatchingPulse.localSampleNumber;
+    return convertTimestampToSampleNumber (getStreamHandle (streamKey), timestamp);
+}
 
-        return t;
-    }
-    else
-    {
-        return -1;
-    }
+int64 Synchronizer::convertTimestampToSampleNumber (int streamHandle, double timestamp) const
+{
+    if (SyncStream* stream = getStream (streamHandle))
+        return stream->toSampleNumber (timestamp);
+
+    return -1;
 }
 
 double Synchronizer::getStartTime (String streamKey)
 {
-	return streams[streamKey]->globalStartTime * 1000;
+    SyncStream* stream = getStream (streamKey);
+
+	return stream != nullptr ? stream->globalStartTime * 1000 : 0.0;
 }
 
 double Synchronizer::getLastSyncEvent (String streamKey)
 {
-    return streams[streamKey]->getLatestSyncTime();
+    SyncStream* stream = getStream (streamKey);
+
+    return stream != nullptr ? stream->getLatestSyncTime() : -1.0;
 }
 
 double Synchronizer::getAccuracy (String streamKey)
 {
+    SyncStream* stream = getStream (streamKey);
 
-    if(! streams[streamKey]->isSynchronized)
+    if (stream == nullptr || ! stream->isSynchronized)
 		return 0.0;
     else
     {
@@ -508,7 +849,7 @@ double Synchronizer::getAccuracy (String streamKey)
 			return 0.0;
         else
         {
-            return streams[streamKey]->getSyncAccuracy();
+            return stream->getSyncAccuracy();
         }
         
     }
@@ -517,15 +858,29 @@ double Synchronizer::getAccuracy (String streamKey)
 
 bool Synchronizer::isStreamSynced (String streamKey)
 {
-    return streams[streamKey]->isSynchronized;
+    return isStreamSynced (getStreamHandle (streamKey));
+}
+
+bool Synchronizer::isStreamSynced (int streamHandle) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    return stream != nullptr && stream->hasSynchronizedConversion();
 }
 
 bool Synchronizer::streamGeneratesTimestamps (String streamKey)
 {
-    if (streams.count (streamKey) == 0)
+    return streamGeneratesTimestamps (getStreamHandle (streamKey));
+}
+
+bool Synchronizer::streamGeneratesTimestamps (int streamHandle) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
         return false;
 
-    return streams[streamKey]->generatesTimestamps && ! streams[streamKey]->overrideHardwareTimestamps;
+    return stream->generatesTimestamps && ! stream->overrideHardwareTimestamps;
 }
 
 SyncStatus Synchronizer::getStatus (String streamKey)
@@ -549,15 +904,25 @@ void Synchronizer::hiResTimerCallback()
 
     const ScopedLock sl (synchronizerLock);
 
-    for (auto [key, stream] : streams)
+    SyncStream* mainStream = getStream (mainStreamKey);
+
+    if (mainStream == nullptr)
+        return;
+
+    for (auto stream : dataStreamObjects)
+        stream->addQueuedEvents();
+
+    for (int handle = 0; handle < dataStreamObjects.size(); handle++)
     {
-        if (key != mainStreamKey && ! streamGeneratesTimestamps (key))
+        SyncStream* stream = dataStreamObjects[handle];
+
+        if (stream != mainStream && ! streamGeneratesTimestamps (handle))
         {
-            stream->syncWith (streams[mainStreamKey]);
+            stream->syncWith (mainStream);
+            stream->publishConversion();
         }
     }
 }
-
 // called by RecordNodeEditor (when loading), SyncControlButton
 void SynchronizingProcessor::setMainDataStream (String streamKey)
 {
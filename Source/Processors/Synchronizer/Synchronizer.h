@@ -25,6 +25,7 @@
 #define SYNCHRONIZER_H_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <math.h>
@@ -32,6 +33,7 @@
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../../Utils/Utils.h"
+#include "../../TestableExport.h"
 
 class Synchronizer;
 
@@ -75,7 +77,7 @@ struct SyncPulse
  * Represents an incoming data stream
  *
  * */
-class SyncStream
+class TESTABLE SyncStream
 {
 public:
     /** Constructor */
@@ -88,7 +90,30 @@ public:
     bool isMainStream;
 
     /** Adds a sync event with a particular sample number and state*/
-    void addEvent (int64 sampleNumber, bool state);
+    void addEvent (int64 sampleNumber, bool state, int64 computerTimeMillis);
+
+    /** Queues a sync event from the processing thread, without locking */
+    void queueEvent (int64 sampleNumber, bool state);
+
+    /** Moves queued sync events into the pulse buffer (timer thread) */
+    void addQueuedEvents();
+
+    /** Publishes the current sample number <-> timestamp conversion to the processing thread */
+    void publishConversion();
+
+    /** Converts a sample number to a timestamp with the published conversion; returns -1 if not synchronized.
+        Never waits on a lock: it only retries if it overlaps a publish. */
+    double toTimestamp (int64 sampleNumber) const;
+
+    /** Converts a timestamp to a sample number with the published conversion; returns -1 if not synchronized */
+    int64 toSampleNumber (double timestamp) const;
+
+    /** Gets the timestamp of a sample and the seconds per sample from one snapshot of the published
+        conversion, so a block's timestamps stay on a single segment; returns false if not synchronized */
+    bool toTimestampRamp (int64 sampleNumber, double& timestamp, double& secondsPerSample) const;
+
+    /** Returns true if the published conversion is synchronized */
+    bool hasSynchronizedConversion() const;
 
     /** Global start time of this stream */
     double globalStartTime;
@@ -96,7 +121,8 @@ public:
     /** Returns time of latest sync pulse */
     double getLatestSyncTime();
 
-    /** Returns difference between actual and expected sync times */
+    /** Returns the RMS residual of the clock regression in ms, or the difference between
+        actual and expected times of the latest sync pulse before the regression is ready */
     double getSyncAccuracy();
 
     /** Synchronize this stream with another one */
@@ -160,12 +186,94 @@ public:
     /** Threshold of calling intervals equal */
     const double MAX_INTERVAL_DIFFERENCE_MS = 2;
 
+    /** Number of matched pulses in the clock regression window */
+    static const int REGRESSION_WINDOW_PULSES = 600;
+
+    /** Matched pulses needed before the regression replaces the two-pulse estimate */
+    const int MIN_REGRESSION_PULSES = 3;
+
+    /** Residuals below this are never treated as outliers */
+    const double MIN_OUTLIER_RESIDUAL_S = 0.002;
+
+    /** Consecutive outliers after which the regression restarts (e.g. after a clock reset) */
+    const int MAX_CONSECUTIVE_OUTLIERS = 3;
+
+    /** Number of sync events that can wait for the timer thread */
+    static const int EVENT_QUEUE_SIZE = 256;
+
 private:
+    /** Reads a consistent copy of the published conversion; returns whether it is synchronized */
+    bool readConversion (int64& baseSampleNumber, double& baseTimestamp, double& sampleRate) const;
+
+    /* Affine conversion published by the timer thread, guarded by a sequence
+       number that is odd while a publish is in progress */
+    std::atomic<uint32> conversionSequence { 0 };
+    std::atomic<bool> conversionSynchronized { false };
+    std::atomic<int64> conversionBaseSampleNumber { 0 };
+    std::atomic<double> conversionBaseTimestamp { 0.0 };
+    std::atomic<double> conversionSampleRate { -1.0 };
+
+    /* Sync events from the processing thread, waiting for the timer thread */
+    struct QueuedEvent
+    {
+        int64 sampleNumber;
+        int64 computerTimeMillis;
+        bool state;
+    };
+
+    AbstractFifo eventFifo { EVENT_QUEUE_SIZE };
+    QueuedEvent queuedEvents[EVENT_QUEUE_SIZE];
 
     int64 latestSyncSampleNumber = 0;
     double latestGlobalSyncTime = 0.0;
     int64 latestSyncMillis = -1;
 
+    /** Adds a matched pulse to the clock regression, in O(1) */
+    void addMatchedPulse (int64 localSampleNumber, double globalTimestamp);
+
+    /** Clears the clock regression */
+    void resetRegression();
+
+    /** Recomputes the regression sums relative to the oldest matched pulse */
+    void rebaseRegression();
+
+    /** Returns the global time the regression predicts for a local sample number */
+    double predictGlobalTime (int64 localSampleNumber) const;
+
+    /** Points the published conversion at the regression, continuing the current segment
+        at each new pulse, or at the two-pulse estimate */
+    void updateConversionSegment();
+
+    /* Least-squares fit of global time against local sample number over a sliding
+       window of matched pulses. Sums are kept relative to an origin pulse so that
+       they stay well conditioned over multi-hour sessions. */
+    struct MatchedPulse
+    {
+        int64 localSampleNumber;
+        double globalTimestamp;
+    };
+
+    MatchedPulse regressionWindow[REGRESSION_WINDOW_PULSES];
+    int regressionStart = 0;
+    int regressionCount = 0;
+    int64 regressionOriginSample = 0;
+    double regressionOriginTime = 0.0;
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0, sumYY = 0;
+    int64 lastMatchedSampleNumber = -1;
+    int consecutiveOutliers = 0;
+
+    bool fitIsValid = false;
+    double fitIntercept = 0.0;
+    double fitSecondsPerSample = 0.0;
+    double fitResidualRms = 0.0;
+
+    /* Segment of the piecewise-linear sample number -> global time mapping in use;
+       segments that follow the regression join end to end at matched pulses */
+    int64 segmentSampleNumber = 0;
+    double segmentTimestamp = 0.0;
+    double segmentSampleRate = -1.0;
+    bool segmentFromFit = false;
+
     Synchronizer* synchronizer;
 };
 
@@ -188,6 +296,13 @@ enum PLUGIN_API SyncStatus
     truth, and all other streams clocks are scaled
     to align with this one.
 
+    Streams can be addressed by key or by an integer handle
+    (see getStreamHandle()). The handle methods are meant for the
+    processing thread: they do no string building or map lookups,
+    never take the lock held by the sync estimator, and convert
+    timestamps with a conversion that the estimator publishes
+    atomically after every update.
+
     The synchronizer works best when the sync line
     has a TTL pulse with a relatively slow inter-event
     interval (e.g. 1 Hz). This interval does not have
@@ -203,12 +318,29 @@ public:
     /** Destructor */
     ~Synchronizer() {}
 
+    /** Returns the handle of a stream, or -1 if it has not been added.
+        Handles stay valid until the next call to prepareForUpdate(). */
+    int getStreamHandle (const String& streamKey) const;
+
+    /** Returns the handle of the main stream, or -1 if there is none */
+    int getMainStreamHandle() const { return mainStreamHandle.load(); }
+
     /** Converts an int64 sample number to a double timestamp */
     double convertSampleNumberToTimestamp (String streamKey, int64 sampleNumber);
 
+    /** Converts an int64 sample number to a double timestamp, for a stream handle */
+    double convertSampleNumberToTimestamp (int streamHandle, int64 sampleNumber) const;
+
+    /** Gets the timestamp of a sample and the seconds per sample for a stream handle, consistently;
+        sets them to -1 and 0 and returns false if the stream is not synchronized */
+    bool getTimestampConversion (int streamHandle, int64 sampleNumber, double& timestamp, double& secondsPerSample) const;
+
     /** Converts a double timestamp to an int64 sample number */
     int64 convertTimestampToSampleNumber (String streamKey, double timestamp);
 
+    /** Converts a double timestamp to an int64 sample number, for a stream handle */
+    int64 convertTimestampToSampleNumber (int streamHandle, double timestamp) const;
+
     /** Returns offset (relative start time) for stream in ms */
     double getStartTime (String streamKey);
 
@@ -224,8 +356,9 @@ public:
     /** Sets main stream ID to 0 and stream count to 0*/
     void prepareForUpdate();
 
-    /** Adds a new data stream with an expected sample rate, a synchronization line, and a flag indicating whether it generates its own timestamps */
-    void addDataStream (String streamKey, float expectedSampleRate, int synLine = 0, bool generatesTimestamps = false);
+    /** Adds a new data stream with an expected sample rate, a synchronization line, and a flag indicating whether it generates its own timestamps.
+        Returns the stream's handle. */
+    int addDataStream (String streamKey, float expectedSampleRate, int synLine = 0, bool generatesTimestamps = false);
 
     /** Checks if there is only one stream */
     void finishedUpdate();
@@ -239,18 +372,30 @@ public:
     /** Returns the TTL line to use for synchronization (0-based indexing)*/
     int getSyncLine (String streamKey);
 
+    /** Returns the TTL line to use for synchronization, for a stream handle */
+    int getSyncLine (int streamHandle) const;
+
     /** Returns true if a stream is synchronized */
     bool isStreamSynced (String streamKey);
 
+    /** Returns true if a stream is synchronized, for a stream handle */
+    bool isStreamSynced (int streamHandle) const;
+
     /** Returns true if the stream genrates its own timestamps and overriding hardware timestamps is disabled */
     bool streamGeneratesTimestamps (String streamKey);
 
+    /** Returns true if the stream generates its own timestamps, for a stream handle */
+    bool streamGeneratesTimestamps (int streamHandle) const;
+
     /** Returns the status (OFF / SYNCING / SYNCED) of a given stream*/
     SyncStatus getStatus (String streamKey);
 
     /** Adds an event for a stream ID / line combination */
     void addEvent (String streamKey, int ttlLine, int64 sampleNumber, bool state);
 
+    /** Adds an event for a stream handle / line combination, without locking */
+    void addEvent (int streamHandle, int ttlLine, int64 sampleNumber, bool state);
+
     /** Signals start of acquisition */
     void startAcquisition();
 
@@ -267,11 +412,21 @@ private:
     int eventCount = 0;
     bool acquisitionIsActive = false;
 
+    /* Handle of mainStreamKey, updated on every reset */
+    std::atomic<int> mainStreamHandle { -1 };
+
     void hiResTimerCallback();
 
+    /** Returns the stream with a given key, or nullptr */
+    SyncStream* getStream (const String& streamKey) const;
+
+    /** Returns the stream with a given handle, or nullptr */
+    SyncStream* getStream (int streamHandle) const { return dataStreamObjects[streamHandle]; }
+
     CriticalSection synchronizerLock;
 
-    std::map<String, SyncStream*> streams;
+    /* Stream handles are indices into dataStreamObjects */
+    std::map<String, int> streams;
     OwnedArray<SyncStream> dataStreamObjects;
 
 };
@@ -25,6 +25,7 @@
 #define __PROCESSORGRAPHHTTPSERVER_H_124F8B50__
 
 #include "../Processors/GenericProcessor/GenericProcessor.h"
+#include "../Processors/MessageCenter/MessageCenter.h"
 #include "../Processors/Parameter/Parameter.h"
 #include "../Processors/ProcessorGraph/ProcessorGraphActions.h"
 #include "../Processors/ProcessorManager/ProcessorManager.h"
@@ -468,6 +469,7 @@ public:
         svr_->Put ("/api/message", [this] (const httplib::Request& req, httplib::Response& res)
                    {
             std::string message_str;
+            int64 sample_number = -1;
             LOGD("Received PUT request");
             try {
                 LOGD( "Trying to decode" );
@@ -476,6 +478,10 @@ public:
                 LOGD( "Parsed" );
                 message_str = request_json["text"];
                 LOGD( "Message string: ", message_str );
+
+                // optional: the message stream sample (system time in ms) at which to send the message
+                if (request_json.contains("sample_number"))
+                    sample_number = request_json["sample_number"];
             }
             catch (json::exception& e) {
                 LOGD( "Hit exception" );
@@ -484,7 +490,10 @@ public:
                 return;
             }
 
-            graph_->broadcastMessage(String(message_str));
+            if (sample_number >= 0)
+                AccessClass::getMessageCenter()->broadcastMessage(String(message_str), CoreServices::getSystemTime(), sample_number);
+            else
+                graph_->broadcastMessage(String(message_str));
 
             json ret;
             status_to_json(graph_, &ret);
@@ -248,4 +248,34 @@ TEST_F(EventTests, GetBinaryDataPointer)
     EXPECT_EQ(data[1], 1);
     EXPECT_EQ(data[2], 2);
     EXPECT_EQ(data[3], 3);
-}
\ No newline at end of file
+}
+
+/*
+Spike features should give each channel's largest-magnitude sample, and the
+trough-to-peak width of the channel with the largest amplitude.
+*/
+TEST_F(EventTests, ComputeSpikeFeatures)
+{
+    SpikeChannel::Settings settings {
+        SpikeChannel::Type::STEREOTRODE,
+        "Stereotrode",
+        "Spike features test",
+        "spike.features",
+        { 0, 1 },
+        2, // pre-peak samples
+        4  // post-peak samples
+    };
+    SpikeChannel spikeChannel(settings);
+
+    const float data[12] = {
+        0, -10, -30, -5, 20, 0,  // trough at 2, peak at 4
+        0, -50, -20, 10, 15, 5   // largest amplitude: trough at 1, peak at 4
+    };
+
+    float peakAmplitudes[2];
+    int troughToPeak = Spike::computeFeatures(&spikeChannel, data, peakAmplitudes);
+
+    EXPECT_EQ(peakAmplitudes[0], -30);
+    EXPECT_EQ(peakAmplitudes[1], -50);
+    EXPECT_EQ(troughToPeak, 3);
+}
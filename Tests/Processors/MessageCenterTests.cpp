@@ -3,6 +3,8 @@
 #include <ProcessorHeaders.h>
 #include <Processors/MessageCenter/MessageCenter.h>
 #include <memory>
+#include <thread>
+#include <vector>
 
 class MessageCenterTests : public testing::Test
 {
@@ -63,4 +65,28 @@ TEST_F(MessageCenterTests, ClearSavedMessages)
 
     messageCenter->clearSavedMessages();
     EXPECT_EQ(messageCenter->getSavedMessages().size(), 0);
-}
\ No newline at end of file
+}
+
+TEST_F(MessageCenterTests, QueuesMessagesFromManyThreads)
+{
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < 4; t++)
+    {
+        producers.emplace_back ([this, t]
+                                {
+            for (int i = 0; i < MESSAGE_QUEUE_SIZE / 4; i++)
+                messageCenter->broadcastMessage ("Thread " + String (t) + " message " + String (i), 100); });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    EXPECT_EQ(messageCenter->getNumQueuedMessages(), MESSAGE_QUEUE_SIZE);
+
+    // no block drains the queue here, so one more message is dropped and counted at once
+    EXPECT_EQ(messageCenter->getNumDroppedMessages(), 0);
+    EXPECT_FALSE(messageCenter->broadcastMessage ("One too many", 100, 200));
+    EXPECT_EQ(messageCenter->getNumQueuedMessages(), MESSAGE_QUEUE_SIZE);
+    EXPECT_EQ(messageCenter->getNumDroppedMessages(), 1);
+}
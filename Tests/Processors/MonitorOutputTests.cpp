@@ -0,0 +1,61 @@
+#include "gtest/gtest.h"
+
+#include <Audio/MonitorOutput.h>
+
+#include <vector>
+
+/*
+Playback waits until the jitter buffer holds the largest chunk written so far, plays the audio
+to the selected outputs in order, and counts an underrun (padding with silence) when the ring runs dry.
+*/
+TEST(MonitorOutputTest, BuffersAndCountsUnderruns)
+{
+    MonitorOutput output;
+
+    std::vector<float> chunk (100);
+    for (int i = 0; i < 100; i++)
+        chunk[i] = float (i + 1);
+
+    std::vector<float> left (64), right (64);
+
+    output.read (left.data(), right.data(), 64);
+    EXPECT_EQ(left[0], 0.0f);
+
+    EXPECT_EQ(output.write (chunk.data(), 50, true, false), 50);
+    EXPECT_EQ(output.write (chunk.data() + 50, 50, true, false), 50);
+
+    output.read (left.data(), right.data(), 64);
+    EXPECT_EQ(left[0], 1.0f);
+    EXPECT_EQ(left[63], 64.0f);
+    EXPECT_EQ(right[63], 0.0f);
+    EXPECT_EQ(output.getNumUnderruns(), 0);
+
+    output.read (left.data(), right.data(), 64);
+    EXPECT_EQ(left[35], 100.0f);
+    EXPECT_EQ(left[36], 0.0f);
+    EXPECT_EQ(output.getNumUnderruns(), 1);
+}
+
+/*
+If more than twice the jitter buffer has queued up, the oldest audio is skipped.
+*/
+TEST(MonitorOutputTest, SkipsExcessBacklog)
+{
+    MonitorOutput output;
+
+    std::vector<float> chunk (32);
+    std::vector<float> left (16), right (16);
+
+    for (int n = 0; n < 4; n++)
+    {
+        for (int i = 0; i < 32; i++)
+            chunk[i] = float (n * 32 + i);
+
+        output.write (chunk.data(), 32, true, true);
+    }
+
+    output.read (left.data(), right.data(), 16);
+
+    EXPECT_EQ(left[0], 96.0f);
+    EXPECT_EQ(right[15], 111.0f);
+}
@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include <Processors/AudioMonitor/PolyphaseResampler.h>
+
+#include <cmath>
+#include <vector>
+
+/*
+A constant input must come out at the same level: every polyphase branch has unity gain at DC.
+*/
+TEST(PolyphaseResamplerTest, PreservesConstantInput)
+{
+    PolyphaseResampler resampler;
+    resampler.prepare (30000.0, 44100.0, 2048, 512);
+
+    float* input = resampler.getInputWritePointer (1000);
+    for (int i = 0; i < 1000; i++)
+        input[i] = 1.0f;
+    resampler.finishedInput (1000);
+
+    std::vector<float> output (512, 0.0f);
+    ASSERT_EQ(resampler.addOutput (output.data(), 512), 512);
+
+    for (int i = 64; i < 512; i++)
+        EXPECT_NEAR(output[i], 1.0f, 1e-4);
+}
+
+/*
+A tone well below both Nyquist frequencies is resampled to the output rate with its phase aligned
+to the first input sample, while a tone above the output Nyquist frequency is filtered out.
+*/
+TEST(PolyphaseResamplerTest, ResamplesAndFiltersTones)
+{
+    PolyphaseResampler resampler;
+    resampler.prepare (30000.0, 44100.0, 4096, 1024);
+
+    float* input = resampler.getInputWritePointer (1500);
+    for (int i = 0; i < 1500; i++)
+        input[i] = (float) std::sin (2.0 * MathConstants<double>::pi * 1000.0 * i / 30000.0);
+    resampler.finishedInput (1500);
+
+    std::vector<float> output (1024, 0.0f);
+    ASSERT_EQ(resampler.addOutput (output.data(), 1024), 1024);
+
+    for (int i = 100; i < 1000; i++)
+        EXPECT_NEAR(output[i], std::sin (2.0 * MathConstants<double>::pi * 1000.0 * i / 44100.0), 1e-3);
+
+    resampler.prepare (48000.0, 44100.0, 8192, 1024);
+
+    input = resampler.getInputWritePointer (1500);
+    for (int i = 0; i < 1500; i++)
+        input[i] = (float) std::sin (2.0 * MathConstants<double>::pi * 23500.0 * i / 48000.0);
+    resampler.finishedInput (1500);
+
+    std::fill (output.begin(), output.end(), 0.0f);
+    resampler.addOutput (output.data(), 1024);
+
+    for (int i = 100; i < 1000; i++)
+        EXPECT_LT(std::abs (output[i]), 0.01f);
+}
+
+/*
+Output waits until a block's worth of input is buffered, and stops where the input runs out.
+*/
+TEST(PolyphaseResamplerTest, StopsWhenInputRunsOut)
+{
+    PolyphaseResampler resampler;
+    resampler.prepare (44100.0, 44100.0, 1024, 256);
+
+    std::vector<float> output (256, 0.0f);
+
+    resampler.getInputWritePointer (100);
+    resampler.finishedInput (100);
+    EXPECT_EQ(resampler.addOutput (output.data(), 256), 0);
+
+    resampler.getInputWritePointer (300);
+    resampler.finishedInput (300);
+    EXPECT_EQ(resampler.addOutput (output.data(), 256), 256);
+    EXPECT_EQ(resampler.addOutput (output.data(), 256), 400 - 256 - resampler.getNumTaps() / 2);
+}
@@ -3,6 +3,10 @@
 #include "gtest/gtest.h"
 
 #include <Processors/RecordNode/RecordNode.h>
+#include <Processors/RecordNode/CompressedFormat/DeltaCodec.h>
+#include <Processors/FileReader/BinaryFileSource/BinaryFileSource.h>
+#include <Processors/FileReader/FileReader.h>
+#include <Processors/FileReader/OverviewPyramid.h>
 #include <ModelProcessors.h>
 #include <ModelApplication.h>
 #include <TestFixtures.h>
@@ -21,7 +25,10 @@ protected:
                                                    (FakeSourceNodeParams{
             numChannels,
             sampleRate,
-            bitVolts
+            bitVolts,
+            1,
+            0,
+            numSpikeChannels
         }));
 
         parentRecordingDir = std::filesystem::temp_directory_path() / "record_node_tests";
@@ -55,8 +62,8 @@ protected:
         return inputBuffer;
     }
 
-    void writeBlock(AudioBuffer<float> &buffer, TTLEvent* maybeTtlEvent = nullptr) {
-        auto outBuffer = tester->processBlock(processor, buffer, maybeTtlEvent);
+    void writeBlock(AudioBuffer<float> &buffer, TTLEvent* maybeTtlEvent = nullptr, Spike* maybeSpike = nullptr) {
+        auto outBuffer = tester->processBlock(processor, buffer, maybeTtlEvent, maybeSpike);
         // Assert the buffer hasn't changed after process()
         ASSERT_EQ(outBuffer.getNumSamples(), buffer.getNumSamples());
         ASSERT_EQ(outBuffer.getNumChannels(), buffer.getNumChannels());
@@ -69,15 +76,23 @@ protected:
         }
     }
 
+    std::filesystem::path recordingPath(const std::string& recording = "recording1") {
+        auto recordingDir = std::filesystem::directory_iterator(parentRecordingDir)->path();
+        std::stringstream ss;
+        ss << "Record Node " << processor->getNodeId();
+        return recordingDir / ss.str() / "experiment1" / recording;
+    }
+
+    std::filesystem::path structureOebinPath() {
+        return recordingPath() / "structure.oebin";
+    }
+
     bool subRecordingPathFor(
         const std::string& subrecording_dirname,
         const std::string& basename,
         std::filesystem::path* path) {
         // Do verifications:
-        auto recordingDir = std::filesystem::directory_iterator(parentRecordingDir)->path();
-        std::stringstream ss;
-        ss << "Record Node " << processor->getNodeId();
-        auto recordingDir2 = recordingDir / ss.str() / "experiment1" / "recording1" / subrecording_dirname;
+        auto recordingDir2 = recordingPath() / subrecording_dirname;
         if (!std::filesystem::exists(recordingDir2)) {
             return false;
         }
@@ -216,6 +231,7 @@ protected:
     std::unique_ptr<ProcessorTester> tester;
     std::filesystem::path parentRecordingDir;
     float sampleRate = 1.0;
+    int numSpikeChannels = 0;
 };
 
 TEST_F(RecordNodeTests, TestInputOutput_Continuous_Single) {
@@ -522,3 +538,1084 @@ TEST_F(RecordNodeTests, Test_PersistsEvents) {
         "20202020202020202020202020202020200a0400000000000000";
     compareBinaryFilesHex("full_words.npy", fullWordsBin, expectedFullWordsHex);
 }
+
+TEST_F(RecordNodeTests, Test_PersistsDroppedEventCounts) {
+    processor->setRecordEvents(true);
+    processor->updateSettings();
+
+    tester->startAcquisition(true);
+    int numSamples = 5;
+
+    auto streamId = processor->getDataStreams()[0]->getStreamId();
+    auto eventChannels = tester->getSourceNodeDataStream(streamId)->getEventChannels();
+    ASSERT_GE(eventChannels.size(), 1);
+    for (int i = 0; i < 3; i++) {
+        TTLEventPtr eventPtr = TTLEvent::createTTLEvent(eventChannels[0], i, 2, i % 2 == 0);
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer, eventPtr.get());
+    }
+    tester->stopAcquisition();
+
+    ASSERT_EQ(processor->getDroppedEventsForStream(streamId), 0);
+
+    auto structureOeBinFn = structureOebinPath();
+    ASSERT_TRUE(std::filesystem::exists(structureOeBinFn));
+
+    auto jsonParsed = JSON::parse(juce::File(structureOeBinFn.string()));
+    ASSERT_TRUE(jsonParsed["events"].isArray());
+    ASSERT_GE(jsonParsed["events"].getArray()->size(), 1);
+
+    for (const auto& jsonEvent : *jsonParsed["events"].getArray()) {
+        ASSERT_TRUE(jsonEvent.hasProperty("dropped_events"));
+        ASSERT_EQ((int64) jsonEvent["dropped_events"], 0);
+    }
+}
+
+class Spikes_RecordNodeTests : public RecordNodeTests {
+    void SetUp() override {
+        numSpikeChannels = 1;
+        RecordNodeTests::SetUp();
+    }
+};
+
+TEST_F(Spikes_RecordNodeTests, Test_PersistsEventAndSpikeBatches) {
+    processor->setRecordEvents(true);
+    processor->setRecordSpikes(true);
+    processor->updateSettings();
+
+    tester->startAcquisition(true);
+
+    auto streamId = processor->getDataStreams()[0]->getStreamId();
+    auto sourceStream = tester->getSourceNodeDataStream(streamId);
+    auto eventChannels = sourceStream->getEventChannels();
+    auto spikeChannels = sourceStream->getSpikeChannels();
+    ASSERT_GE(eventChannels.size(), 1);
+    ASSERT_EQ(spikeChannels.size(), 1);
+
+    // More than one 4096-record batch, so every file is flushed during the recording and again on close
+    const int numRecords = 4096 + 100;
+    for (int i = 0; i < numRecords; i++) {
+        TTLEventPtr eventPtr = TTLEvent::createTTLEvent(eventChannels[0], i, 2, i % 2 == 0);
+
+        Spike::Buffer spikeBuffer(spikeChannels[0]);
+        for (int s = 0; s < spikeChannels[0]->getTotalSamples(); s++) {
+            spikeBuffer.set(0, s, float(i % 100));
+        }
+        Array<float> thresholds;
+        thresholds.add(50.0f);
+        SpikePtr spikePtr = Spike::createSpike(spikeChannels[0], i, thresholds, spikeBuffer, uint16(i % 3));
+
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, 1);
+        writeBlock(inputBuffer, eventPtr.get(), spikePtr.get());
+    }
+    tester->stopAcquisition();
+
+    ASSERT_EQ(processor->getDroppedEventsForStream(streamId), 0);
+
+    // Checks the header shape of a finalized .npy file and returns a pointer to its first record
+    auto checkNpy = [](const std::vector<char>& npyBin, const std::string& shape) -> const char* {
+        std::string contents(npyBin.begin(), npyBin.end());
+        EXPECT_NE(contents.find("'shape': (" + shape + ")"), std::string::npos) << "expected shape " << shape;
+        uint16_t headerLength;
+        memcpy(&headerLength, npyBin.data() + 8, sizeof(uint16_t));
+        return npyBin.data() + 10 + headerLength;
+    };
+
+    const std::string numRecordsShape = std::to_string(numRecords) + ",";
+
+    std::filesystem::path eventSamplesPath, eventStatesPath;
+    ASSERT_TRUE(eventsPathFor("sample_numbers.npy", &eventSamplesPath));
+    ASSERT_TRUE(eventsPathFor("states.npy", &eventStatesPath));
+    auto eventSamplesBin = loadNpyFileBinaryFullpath(eventSamplesPath.string());
+    auto eventStatesBin = loadNpyFileBinaryFullpath(eventStatesPath.string());
+    ASSERT_EQ(eventSamplesBin.size() - (checkNpy(eventSamplesBin, numRecordsShape) - eventSamplesBin.data()), numRecords * sizeof(int64_t));
+    ASSERT_EQ(eventStatesBin.size() - (checkNpy(eventStatesBin, numRecordsShape) - eventStatesBin.data()), numRecords * sizeof(int16_t));
+
+    const char* eventSamples = checkNpy(eventSamplesBin, numRecordsShape);
+    const char* eventStates = checkNpy(eventStatesBin, numRecordsShape);
+    for (int i = 0; i < numRecords; i++) {
+        int64_t sampleNumber;
+        int16_t state;
+        memcpy(&sampleNumber, eventSamples + i * sizeof(int64_t), sizeof(int64_t));
+        memcpy(&state, eventStates + i * sizeof(int16_t), sizeof(int16_t));
+        ASSERT_EQ(sampleNumber, i);
+        ASSERT_EQ(state, i % 2 == 0 ? 3 : -3);
+    }
+
+    std::filesystem::path spikeDir;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(recordingPath() / "spikes")) {
+        if (entry.path().filename() == "sample_numbers.npy") {
+            spikeDir = entry.path().parent_path();
+        }
+    }
+    ASSERT_FALSE(spikeDir.empty());
+
+    auto spikeSamplesBin = loadNpyFileBinaryFullpath((spikeDir / "sample_numbers.npy").string());
+    auto clustersBin = loadNpyFileBinaryFullpath((spikeDir / "clusters.npy").string());
+    auto waveformsBin = loadNpyFileBinaryFullpath((spikeDir / "waveforms.npy").string());
+
+    const int waveformSamples = spikeChannels[0]->getTotalSamples();
+    const char* spikeSamples = checkNpy(spikeSamplesBin, numRecordsShape);
+    const char* clusters = checkNpy(clustersBin, numRecordsShape);
+    const char* waveforms = checkNpy(waveformsBin, numRecordsShape + " " + std::to_string(waveformSamples));
+    ASSERT_EQ(spikeSamplesBin.size() - (spikeSamples - spikeSamplesBin.data()), numRecords * sizeof(int64_t));
+    ASSERT_EQ(clustersBin.size() - (clusters - clustersBin.data()), numRecords * sizeof(uint16_t));
+    ASSERT_EQ(waveformsBin.size() - (waveforms - waveformsBin.data()), numRecords * waveformSamples * sizeof(int16_t));
+
+    for (int i = 0; i < numRecords; i++) {
+        int64_t sampleNumber;
+        uint16_t cluster;
+        int16_t waveformSample;
+        memcpy(&sampleNumber, spikeSamples + i * sizeof(int64_t), sizeof(int64_t));
+        memcpy(&cluster, clusters + i * sizeof(uint16_t), sizeof(uint16_t));
+        memcpy(&waveformSample, waveforms + (i + 1) * waveformSamples * sizeof(int16_t) - sizeof(int16_t), sizeof(int16_t));
+        ASSERT_EQ(sampleNumber, i);
+        ASSERT_EQ(cluster, i % 3);
+        ASSERT_EQ(waveformSample, i % 100);
+    }
+}
+
+TEST_F(RecordNodeTests, Test_PersistsCompactTimestamps) {
+    EngineParameter compactTimestamps(EngineParameter::BOOL, 1, "Compact timestamps", true);
+    processor->recordEngine->setParameter(compactTimestamps);
+
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    for (int i = 0; i < 3; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    std::filesystem::path unusedPath;
+    ASSERT_FALSE(continuousPathFor("sample_numbers.npy", &unusedPath));
+    ASSERT_FALSE(continuousPathFor("timestamps.npy", &unusedPath));
+
+    bool success = false;
+    std::vector<char> segmentsBin;
+    loadNpyFileBinary("timestamp_segments.npy", &segmentsBin, &success);
+    ASSERT_TRUE(success);
+
+    // Contiguous blocks with evenly spaced timestamps collapse into a single segment
+    // of (sample_number, timestamp, sample_rate, num_samples)
+    uint16_t headerLength;
+    memcpy(&headerLength, segmentsBin.data() + 8, sizeof(uint16_t));
+    size_t dataOffset = 10 + headerLength;
+    ASSERT_EQ(segmentsBin.size() - dataOffset, 32);
+
+    int64_t segmentSampleNumber, segmentNumSamples;
+    double segmentTimestamp, segmentSampleRate;
+    memcpy(&segmentSampleNumber, segmentsBin.data() + dataOffset, sizeof(int64_t));
+    memcpy(&segmentTimestamp, segmentsBin.data() + dataOffset + 8, sizeof(double));
+    memcpy(&segmentSampleRate, segmentsBin.data() + dataOffset + 16, sizeof(double));
+    memcpy(&segmentNumSamples, segmentsBin.data() + dataOffset + 24, sizeof(int64_t));
+
+    ASSERT_EQ(segmentSampleNumber, 0);
+    ASSERT_DOUBLE_EQ(segmentTimestamp, 0.0);
+    ASSERT_DOUBLE_EQ(segmentSampleRate, sampleRate);
+    ASSERT_EQ(segmentNumSamples, 15);
+}
+
+TEST_F(RecordNodeTests, Test_ReconstructsCompactTimestampsInBinarySource) {
+    EngineParameter compactTimestamps(EngineParameter::BOOL, 1, "Compact timestamps", true);
+    processor->recordEngine->setParameter(compactTimestamps);
+
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    for (int i = 0; i < 3; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    // Replace the recorded segment with two: 10 samples at 1 Hz, then a jump to
+    // sample 20 at 10 s with 2 Hz
+    std::filesystem::path segmentsPath;
+    ASSERT_TRUE(continuousPathFor("timestamp_segments.npy", &segmentsPath));
+    {
+        Array<NpyType> segmentTypes;
+        segmentTypes.add(NpyType("sample_number", BaseType::INT64, 1));
+        segmentTypes.add(NpyType("timestamp", BaseType::DOUBLE, 1));
+        segmentTypes.add(NpyType("sample_rate", BaseType::DOUBLE, 1));
+        segmentTypes.add(NpyType("num_samples", BaseType::INT64, 1));
+        NpyFile segmentsFile(String(segmentsPath.string()), segmentTypes);
+
+        struct { int64 sampleNumber; double timestamp; double sampleRate; int64 numSamples; } segments[] = {
+            { 0, 0.0, 1.0, 10 },
+            { 20, 10.0, 2.0, 5 }
+        };
+        segmentsFile.writeData(segments, sizeof(segments));
+        segmentsFile.increaseRecordCount(2);
+    }
+
+    BinarySource::BinaryFileSource source;
+    ASSERT_TRUE(source.openFile(juce::File(structureOebinPath().string())));
+    source.setActiveRecord(0);
+
+    // Start inside the first segment and cross into the second
+    std::vector<int64> sampleNumbers(10);
+    std::vector<double> timestamps(10);
+    ASSERT_TRUE(source.reconstructTimestamps(5, 10, sampleNumbers.data(), timestamps.data()));
+
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(sampleNumbers[i], 5 + i);
+        ASSERT_DOUBLE_EQ(timestamps[i], 5.0 + i);
+    }
+    for (int i = 5; i < 10; i++) {
+        ASSERT_EQ(sampleNumbers[i], 20 + (i - 5));
+        ASSERT_DOUBLE_EQ(timestamps[i], 10.0 + (i - 5) / 2.0);
+    }
+}
+
+TEST_F(RecordNodeTests, Test_PersistsChannelMajorChunks) {
+    // 3 s chunks at 1 Hz hold 3 samples per channel
+    EngineParameter chunkLength(EngineParameter::INT, 3, "Channel-major chunk", 3000, 0, 5000);
+    processor->recordEngine->setParameter(chunkLength);
+
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    std::vector<AudioBuffer<float>> inputBuffers;
+    for (int i = 0; i < 2; i++) {
+        inputBuffers.push_back(createBuffer(1000.0 + i * 500.0, 20.0, numChannels, numSamples));
+        writeBlock(inputBuffers.back());
+    }
+    tester->stopAcquisition();
+
+    std::filesystem::path dataPath;
+    ASSERT_TRUE(continuousPathFor("continuous.dat", &dataPath));
+    auto dataBin = loadNpyFileBinaryFullpath(dataPath.string());
+    ASSERT_EQ(dataBin.size(), 2 * numSamples * numChannels * sizeof(int16_t));
+
+    // Chunks of 3, 3, 3 and 1 samples, each holding every channel contiguously
+    const int16_t* data = reinterpret_cast<const int16_t*>(dataBin.data());
+    const int totalSamples = 2 * numSamples;
+    for (int chunkStart = 0; chunkStart < totalSamples; chunkStart += 3) {
+        int chunkLength = std::min(3, totalSamples - chunkStart);
+        for (int chidx = 0; chidx < numChannels; chidx++) {
+            for (int i = 0; i < chunkLength; i++) {
+                int sampleIdx = chunkStart + i;
+                float expected = inputBuffers[sampleIdx / numSamples].getSample(chidx, sampleIdx % numSamples);
+                ASSERT_EQ(data[chunkStart * numChannels + chidx * chunkLength + i], expected);
+            }
+        }
+    }
+
+    auto structureOeBinFn = structureOebinPath();
+    auto jsonParsed = JSON::parse(juce::File(structureOeBinFn.string()));
+
+    var layout = jsonParsed["continuous"][0]["layout"];
+    ASSERT_TRUE(layout.isObject());
+    ASSERT_EQ(layout["order"].toString(), "channel_major");
+    ASSERT_EQ((int) layout["samples_per_chunk"], 3);
+
+    // One channel reads back across chunk boundaries, up to the short last chunk
+    BinarySource::BinaryFileSource source;
+    ASSERT_TRUE(source.openFile(juce::File(structureOeBinFn.string())));
+    source.setActiveRecord(0);
+
+    const int channel = 2;
+    std::vector<float> channelData(totalSamples);
+    ASSERT_EQ(source.readChannel(channel, 1, totalSamples, channelData.data()), totalSamples - 1);
+    for (int i = 0; i < totalSamples - 1; i++) {
+        int sampleIdx = i + 1;
+        ASSERT_NEAR(channelData[i], inputBuffers[sampleIdx / numSamples].getSample(channel, sampleIdx % numSamples), bitVolts);
+    }
+}
+
+TEST_F(RecordNodeTests, Test_ReadsPlanarDataFromBinarySource) {
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    std::vector<AudioBuffer<float>> inputBuffers;
+    for (int i = 0; i < 4; i++) {
+        inputBuffers.push_back(createBuffer(1000.0 + i * 100.0, 20.0, numChannels, numSamples));
+        writeBlock(inputBuffers.back());
+    }
+    tester->stopAcquisition();
+
+    auto structureOeBinFn = structureOebinPath();
+
+    BinarySource::BinaryFileSource source;
+    ASSERT_TRUE(source.openFile(juce::File(structureOeBinFn.string())));
+    source.setActiveRecord(0);
+    ASSERT_EQ(source.getActiveNumChannels(), numChannels);
+
+    // 20 samples of 8 channels covers both the transposed 8x8 blocks and the scalar tail
+    const int totalSamples = 4 * numSamples;
+    std::vector<float> interleaved(totalSamples * numChannels);
+    ASSERT_EQ(source.readData(interleaved.data(), totalSamples), totalSamples);
+
+    AudioBuffer<float> planar(numChannels, totalSamples);
+    source.seekTo(0);
+    ASSERT_EQ(source.readPlanarData(planar.getArrayOfWritePointers(), totalSamples), totalSamples);
+
+    for (int chidx = 0; chidx < numChannels; chidx++) {
+        for (int i = 0; i < totalSamples; i++) {
+            ASSERT_EQ(planar.getSample(chidx, i), interleaved[i * numChannels + chidx]);
+            ASSERT_NEAR(planar.getSample(chidx, i), inputBuffers[i / numSamples].getSample(chidx, i % numSamples), bitVolts);
+        }
+    }
+}
+
+TEST_F(RecordNodeTests, Test_BuildsOverviewOfBinarySource) {
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    for (int i = 0; i < 4; i++) {
+        auto inputBuffer = createBuffer(1000.0 + i * 100.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    auto structureOeBinFn = structureOebinPath();
+
+    auto source = std::make_unique<BinarySource::BinaryFileSource>();
+    ASSERT_TRUE(source->openFile(juce::File(structureOeBinFn.string())));
+    source->setActiveRecord(0);
+
+    // Read every sample back for the expected extremes
+    const int totalSamples = 4 * numSamples;
+    AudioBuffer<float> data(numChannels, totalSamples);
+    ASSERT_EQ(source->readPlanarData(data.getArrayOfWritePointers(), totalSamples), totalSamples);
+    source->seekTo(0);
+
+    float expectedMin = data.getSample(0, 0), expectedMax = expectedMin;
+    for (int chidx = 0; chidx < numChannels; chidx++) {
+        auto range = data.findMinMax(chidx, 0, totalSamples);
+        expectedMin = std::min(expectedMin, range.getStart());
+        expectedMax = std::max(expectedMax, range.getEnd());
+    }
+
+    juce::File cacheFile = juce::File(structureOeBinFn.string()).getSiblingFile("test.overview");
+    OverviewPyramid overview(source.release(), cacheFile);
+    overview.startThread();
+
+    for (int i = 0; i < 100 && overview.getProgress() < 1.0f; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(overview.getProgress(), 1.0f);
+
+    std::vector<OverviewPyramid::Bin> pixels;
+    ASSERT_EQ(overview.getOverview(0, totalSamples, 1, pixels), 1);
+    ASSERT_NEAR(pixels[0].min, expectedMin, bitVolts);
+    ASSERT_NEAR(pixels[0].max, expectedMax, bitVolts);
+    ASSERT_GE(pixels[0].rms, std::min(std::abs(expectedMin), std::abs(expectedMax)) - bitVolts);
+    ASSERT_LE(pixels[0].rms, std::max(std::abs(expectedMin), std::abs(expectedMax)) + bitVolts);
+
+    // Nothing beyond the end of the recording
+    ASSERT_EQ(overview.getOverview(totalSamples + OVERVIEW_BIN_SAMPLES, totalSamples + 2 * OVERVIEW_BIN_SAMPLES, 4, pixels), 0);
+}
+
+TEST_F(RecordNodeTests, Test_LooksUpEventsInRangeFromBinarySource) {
+    processor->setRecordEvents(true);
+    processor->updateSettings();
+
+    tester->startAcquisition(true);
+    int numSamples = 5;
+
+    auto streamId = processor->getDataStreams()[0]->getStreamId();
+    auto eventChannels = tester->getSourceNodeDataStream(streamId)->getEventChannels();
+    ASSERT_GE(eventChannels.size(), 1);
+    for (int i = 0; i < 4; i++) {
+        TTLEventPtr eventPtr = TTLEvent::createTTLEvent(eventChannels[0], i * numSamples + 1, 2, i % 2 == 0);
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer, eventPtr.get());
+    }
+    tester->stopAcquisition();
+
+    auto structureOeBinFn = structureOebinPath();
+
+    BinarySource::BinaryFileSource source;
+    ASSERT_TRUE(source.openFile(juce::File(structureOeBinFn.string())));
+    source.setActiveRecord(0);
+
+    EventInfo all;
+    source.processEventData(all, 0, 4 * numSamples);
+    ASSERT_EQ(all.sampleNumbers, std::vector<int64>({1, 6, 11, 16}));
+    ASSERT_EQ(all.channels, std::vector<int16>({2, 2, 2, 2}));
+    ASSERT_EQ(all.channelStates, std::vector<int16>({1, 0, 1, 0}));
+
+    // Half-open range
+    EventInfo middle;
+    source.processEventData(middle, 6, 11);
+    ASSERT_EQ(middle.sampleNumbers, std::vector<int64>({6}));
+
+    // A range running past the end of the recording wraps to its start
+    EventInfo wrapped;
+    source.processEventData(wrapped, 16, 24);
+    ASSERT_EQ(wrapped.sampleNumbers, std::vector<int64>({16, 1}));
+}
+
+TEST_F(RecordNodeTests, Test_PersistsDecimatedLfpStream) {
+    EngineParameter decimationFactor(EngineParameter::INT, 4, "LFP decimation factor", 2, 1, 100);
+    processor->recordEngine->setParameter(decimationFactor);
+
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    for (int i = 0; i < 2; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    auto recording = recordingPath();
+
+    std::filesystem::path lfpDir;
+    for (const auto& subdir : std::filesystem::directory_iterator(recording / "continuous")) {
+        auto name = subdir.path().filename().string();
+        if (name.size() > 4 && name.substr(name.size() - 4) == "-LFP") {
+            lfpDir = subdir.path();
+        }
+    }
+    ASSERT_FALSE(lfpDir.empty());
+
+    // Every second sample of the 10 recorded samples is kept
+    const int numKept = 5;
+    ASSERT_EQ(std::filesystem::file_size(lfpDir / "continuous.dat"), numKept * numChannels * sizeof(int16_t));
+
+    auto sampleNumbersBin = loadNpyFileBinaryFullpath((lfpDir / "sample_numbers.npy").string());
+    uint16_t headerLength;
+    memcpy(&headerLength, sampleNumbersBin.data() + 8, sizeof(uint16_t));
+    size_t dataOffset = 10 + headerLength;
+    ASSERT_EQ(sampleNumbersBin.size() - dataOffset, numKept * sizeof(int64_t));
+
+    for (int i = 0; i < numKept; i++) {
+        int64_t sampleNumber;
+        memcpy(&sampleNumber, sampleNumbersBin.data() + dataOffset + i * sizeof(int64_t), sizeof(int64_t));
+        ASSERT_EQ(sampleNumber, 2 * i);
+    }
+
+    auto jsonParsed = JSON::parse(juce::File((recording / "structure.oebin").string()));
+    ASSERT_EQ(jsonParsed["continuous"].size(), 2);
+
+    var lfpStream = jsonParsed["continuous"][1];
+    ASSERT_EQ((int) lfpStream["decimation_factor"], 2);
+    ASSERT_DOUBLE_EQ((double) lfpStream["sample_rate"], sampleRate / 2);
+    ASSERT_EQ((int) lfpStream["num_channels"], numChannels);
+}
+
+TEST_F(RecordNodeTests, Test_PersistsCompressedContinuous) {
+    processor->setEngine("COMPRESSED");
+    ASSERT_EQ(processor->getEngineId(), "COMPRESSED");
+
+    tester->startAcquisition(true);
+
+    int numSamples = 100;
+    auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+    writeBlock(inputBuffer);
+    tester->stopAcquisition();
+
+    std::filesystem::path unusedPath;
+    ASSERT_FALSE(continuousPathFor("continuous.dat", &unusedPath));
+
+    bool success = false;
+    std::vector<char> indexBin;
+    loadNpyFileBinary("chunk_index.npy", &indexBin, &success);
+    ASSERT_TRUE(success);
+
+    // A recording shorter than one chunk is written as a single chunk of
+    // (byte_offset, num_bytes, sample_offset, num_samples)
+    uint16_t headerLength;
+    memcpy(&headerLength, indexBin.data() + 8, sizeof(uint16_t));
+    size_t dataOffset = 10 + headerLength;
+    ASSERT_EQ(indexBin.size() - dataOffset, 32);
+
+    int64_t chunk[4];
+    memcpy(chunk, indexBin.data() + dataOffset, sizeof(chunk));
+    ASSERT_EQ(chunk[0], 0);
+    ASSERT_EQ(chunk[2], 0);
+    ASSERT_EQ(chunk[3], numSamples);
+
+    std::filesystem::path dataPath;
+    ASSERT_TRUE(continuousPathFor("continuous.zdat", &dataPath));
+    auto dataBin = loadNpyFileBinaryFullpath(dataPath.string());
+    ASSERT_EQ(dataBin.size(), chunk[1]);
+
+    // Each chunk starts with the encoded size of every channel, followed by the channel payloads
+    std::vector<uint32_t> encodedSizes(numChannels);
+    memcpy(encodedSizes.data(), dataBin.data(), numChannels * sizeof(uint32_t));
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(dataBin.data()) + numChannels * sizeof(uint32_t);
+
+    std::vector<int16_t> decoded(numSamples);
+    for (int chidx = 0; chidx < numChannels; chidx++) {
+        ASSERT_EQ(DeltaCodec::decodeChannel(payload, numSamples, decoded.data(), 1), encodedSizes[chidx]);
+        for (int sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
+            ASSERT_EQ(decoded[sampleIdx], inputBuffer.getSample(chidx, sampleIdx));
+        }
+        payload += encodedSizes[chidx];
+    }
+}
+
+TEST_F(RecordNodeTests, Test_WritesSecondaryEngineChannelSubset) {
+    auto secondaryDir = std::filesystem::temp_directory_path() / "record_node_tests_secondary";
+    std::error_code ec;
+    std::filesystem::remove_all(secondaryDir, ec);
+    std::filesystem::create_directory(secondaryDir);
+
+    ASSERT_EQ(processor->addSecondaryEngine("BINARY", juce::File(secondaryDir.string()), {1, 3}), 0);
+    ASSERT_EQ(processor->getNumSecondaryEngines(), 1);
+
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+    writeBlock(inputBuffer);
+    tester->stopAcquisition();
+
+    // The main engine still records every channel
+    std::filesystem::path mainPath;
+    ASSERT_TRUE(continuousPathFor("continuous.dat", &mainPath));
+    ASSERT_EQ(std::filesystem::file_size(mainPath), numSamples * numChannels * sizeof(int16_t));
+
+    // The secondary engine mirrors the main directory layout under its own root
+    std::stringstream ss;
+    ss << "Record Node " << processor->getNodeId();
+    auto secondaryRecording = std::filesystem::directory_iterator(secondaryDir)->path() / ss.str() / "experiment1" / "recording1";
+    ASSERT_TRUE(std::filesystem::exists(secondaryRecording / "structure.oebin"));
+
+    std::filesystem::path secondaryPath;
+    for (const auto &subdir : std::filesystem::directory_iterator(secondaryRecording / "continuous")) {
+        secondaryPath = subdir.path() / "continuous.dat";
+    }
+    ASSERT_TRUE(std::filesystem::exists(secondaryPath));
+
+    auto secondaryBin = loadNpyFileBinaryFullpath(secondaryPath.string());
+    ASSERT_EQ(secondaryBin.size(), numSamples * 2 * sizeof(int16_t));
+
+    const int16_t* samples = reinterpret_cast<const int16_t*>(secondaryBin.data());
+    for (int sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
+        ASSERT_EQ(samples[sampleIdx * 2], inputBuffer.getSample(1, sampleIdx));
+        ASSERT_EQ(samples[sampleIdx * 2 + 1], inputBuffer.getSample(3, sampleIdx));
+    }
+
+    std::filesystem::remove_all(secondaryDir, ec);
+}
+
+TEST_F(RecordNodeTests, Test_ConfiguresSecondaryEngineFromManager) {
+    auto secondaryDir = std::filesystem::temp_directory_path() / "record_node_tests_secondary";
+    std::error_code ec;
+    std::filesystem::remove_all(secondaryDir, ec);
+    std::filesystem::create_directory(secondaryDir);
+
+    RecordEngineManager* binaryManager = nullptr;
+    for (auto manager : CoreServices::getAvailableRecordEngines()) {
+        if (manager->getID() == "BINARY") {
+            binaryManager = manager;
+        }
+    }
+    ASSERT_NE(binaryManager, nullptr);
+
+    // "Compact timestamps" is parameter 1 of the Binary engine
+    EngineParameter& compactTimestamps = binaryManager->getParameter(1);
+    compactTimestamps.boolParam.value = true;
+
+    int index = processor->addSecondaryEngine("BINARY", juce::File(secondaryDir.string()));
+
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+    writeBlock(inputBuffer);
+    tester->stopAcquisition();
+
+    compactTimestamps.boolParam.value = false;
+    ASSERT_EQ(index, 0);
+
+    std::stringstream ss;
+    ss << "Record Node " << processor->getNodeId();
+    auto secondaryRecording = std::filesystem::directory_iterator(secondaryDir)->path() / ss.str() / "experiment1" / "recording1";
+
+    std::filesystem::path secondaryStream;
+    for (const auto &subdir : std::filesystem::directory_iterator(secondaryRecording / "continuous")) {
+        secondaryStream = subdir.path();
+    }
+    ASSERT_TRUE(std::filesystem::exists(secondaryStream / "timestamp_segments.npy"));
+    ASSERT_FALSE(std::filesystem::exists(secondaryStream / "sample_numbers.npy"));
+
+    std::filesystem::remove_all(secondaryDir, ec);
+}
+
+TEST_F(RecordNodeTests, Test_RolloverIsGapless) {
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    for (int i = 0; i < 3; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+
+    // Rollover becomes available once the Record Thread is writing
+    bool rolledOver = false;
+    for (int i = 0; i < 100 && !rolledOver; i++) {
+        rolledOver = processor->handleConfigMessage("rollover").startsWith("Record Node: rolling over");
+        if (!rolledOver) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ASSERT_TRUE(rolledOver);
+
+    for (int i = 0; i < 100 && processor->recordThread->isRolloverPending(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(processor->recordThread->isRolloverPending());
+
+    for (int i = 0; i < 3; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    // Both recordings together hold every sample number exactly once
+    std::vector<int64_t> sampleNumbers;
+    size_t firstRolloverSample = 0;
+    for (auto recording : {"recording1", "recording2"}) {
+        firstRolloverSample = sampleNumbers.size();
+        auto continuousDir = recordingPath(recording) / "continuous";
+        ASSERT_TRUE(std::filesystem::exists(continuousDir));
+
+        for (const auto &subdir : std::filesystem::directory_iterator(continuousDir)) {
+            auto sampleNumbersBin = loadNpyFileBinaryFullpath((subdir.path() / "sample_numbers.npy").string());
+
+            uint16_t headerLength;
+            memcpy(&headerLength, sampleNumbersBin.data() + 8, sizeof(uint16_t));
+            size_t dataOffset = 10 + headerLength;
+
+            for (size_t offset = dataOffset; offset < sampleNumbersBin.size(); offset += sizeof(int64_t)) {
+                int64_t sampleNumber;
+                memcpy(&sampleNumber, sampleNumbersBin.data() + offset, sizeof(int64_t));
+                sampleNumbers.push_back(sampleNumber);
+            }
+        }
+    }
+
+    ASSERT_EQ(sampleNumbers.size(), 6 * numSamples);
+    for (size_t i = 1; i < sampleNumbers.size(); i++) {
+        ASSERT_EQ(sampleNumbers[i], sampleNumbers[i - 1] + 1);
+    }
+
+    // The rollover recording gets its own sync texts, starting at its first sample
+    std::ifstream syncFile(recordingPath("recording2") / "sync_messages.txt");
+    std::string syncMessages((std::istreambuf_iterator<char>(syncFile)), std::istreambuf_iterator<char>());
+    ASSERT_NE(syncMessages.find("Software Time"), std::string::npos);
+    ASSERT_NE(syncMessages.find("Start Time for"), std::string::npos);
+    ASSERT_NE(syncMessages.find(": " + std::to_string(sampleNumbers[firstRolloverSample]) + "\r\n"), std::string::npos);
+}
+
+TEST_F(RecordNodeTests, Test_PreTriggerWindowIsWrittenFirst) {
+    // sampleRate is 1 Hz, so this keeps the last 10 samples before recording starts
+    processor->getParameter("pre_trigger")->setNextValue(10.0f, false);
+
+    tester->startAcquisition(false);
+
+    int numSamples = 5;
+    for (int i = 0; i < 6; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+
+    CoreServices::setRecordingStatus(true);
+
+    for (int i = 0; i < 2; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    std::filesystem::path sampleNumbersPath;
+    ASSERT_TRUE(continuousPathFor("sample_numbers.npy", &sampleNumbersPath));
+    auto sampleNumbersBin = loadNpyFileBinaryFullpath(sampleNumbersPath.string());
+
+    uint16_t headerLength;
+    memcpy(&headerLength, sampleNumbersBin.data() + 8, sizeof(uint16_t));
+    size_t dataOffset = 10 + headerLength;
+
+    // 10 pre-trigger samples followed by the 10 recorded ones
+    ASSERT_EQ(sampleNumbersBin.size() - dataOffset, 20 * sizeof(int64_t));
+
+    std::vector<int64_t> sampleNumbers(20);
+    memcpy(sampleNumbers.data(), sampleNumbersBin.data() + dataOffset, 20 * sizeof(int64_t));
+    for (size_t i = 1; i < sampleNumbers.size(); i++) {
+        ASSERT_EQ(sampleNumbers[i], sampleNumbers[i - 1] + 1);
+    }
+
+    // The stream's sync text refers to the first pre-trigger sample, not the trigger block
+    auto syncPath = sampleNumbersPath.parent_path().parent_path().parent_path() / "sync_messages.txt";
+    std::ifstream syncFile(syncPath);
+    std::string syncMessages((std::istreambuf_iterator<char>(syncFile)), std::istreambuf_iterator<char>());
+    ASSERT_NE(syncMessages.find("Start Time for"), std::string::npos);
+    ASSERT_NE(syncMessages.find(": " + std::to_string(sampleNumbers[0]) + "\r\n"), std::string::npos);
+
+    std::filesystem::path dataPath;
+    ASSERT_TRUE(continuousPathFor("continuous.dat", &dataPath));
+    auto dataBin = loadNpyFileBinaryFullpath(dataPath.string());
+    ASSERT_EQ(dataBin.size(), 20 * numChannels * sizeof(int16_t));
+
+    // The window starts on a block boundary, so it opens with the first sample of a block
+    auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+    const int16_t* samples = reinterpret_cast<const int16_t*>(dataBin.data());
+    for (int chidx = 0; chidx < numChannels; chidx++) {
+        ASSERT_EQ(samples[chidx], inputBuffer.getSample(chidx, 0));
+    }
+}
+
+TEST_F(RecordNodeTests, Test_PreTriggerWindowShrinksToFitBudget) {
+    // The budget leaves no room for a window on top of the headroom
+    processor->setRecordBufferBudget(1);
+    processor->getParameter("pre_trigger")->setNextValue(10.0f, false);
+
+    tester->startAcquisition(false);
+
+    int numSamples = 5;
+    for (int i = 0; i < 6; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+
+    CoreServices::setRecordingStatus(true);
+
+    for (int i = 0; i < 2; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    std::filesystem::path sampleNumbersPath;
+    ASSERT_TRUE(continuousPathFor("sample_numbers.npy", &sampleNumbersPath));
+    auto sampleNumbersBin = loadNpyFileBinaryFullpath(sampleNumbersPath.string());
+
+    uint16_t headerLength;
+    memcpy(&headerLength, sampleNumbersBin.data() + 8, sizeof(uint16_t));
+    size_t dataOffset = 10 + headerLength;
+
+    // Only the recorded samples are written, and none of them were dropped
+    ASSERT_EQ(sampleNumbersBin.size() - dataOffset, 2 * numSamples * sizeof(int64_t));
+}
+
+class HighSampleRate_RecordNodeTests : public RecordNodeTests {
+    void SetUp() override {
+        sampleRate = 40000.0;
+        RecordNodeTests::SetUp();
+    }
+};
+
+TEST_F(HighSampleRate_RecordNodeTests, Test_LongPreTriggerWindowKeepsRecording) {
+    int numSamples = 4000;
+
+    // Time enough writes for the buffer to be sized from the write latency, which leaves
+    // about 2 s of headroom instead of the default size
+    tester->startAcquisition(true);
+    for (int i = 0; i < 1000 && processor->recordThread->getNumTimedWrites() < DATA_BUFFER_MIN_TIMED_WRITES; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    tester->stopAcquisition();
+    ASSERT_GE(processor->recordThread->getNumTimedWrites(), DATA_BUFFER_MIN_TIMED_WRITES);
+
+    // The window fills more than 90% of the buffer when recording starts
+    processor->getParameter("pre_trigger")->setNextValue(30.0f, false);
+    tester->startAcquisition(false);
+
+    const int windowSamples = 30 * int(sampleRate);
+    for (int i = 0; i < windowSamples / numSamples + 10; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+
+    CoreServices::setRecordingStatus(true);
+
+    for (int i = 0; i < 2; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+
+    ASSERT_TRUE(processor->getRecordingStatus());
+    tester->stopAcquisition();
+
+    // The second recording holds the whole window followed by the recorded blocks
+    const uintmax_t expectedSize = uintmax_t(windowSamples + 2 * numSamples) * numChannels * sizeof(int16_t);
+    bool found = false;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(parentRecordingDir)) {
+        if (entry.path().filename() == "continuous.dat" && std::filesystem::file_size(entry.path()) == expectedSize) {
+            found = true;
+        }
+    }
+    ASSERT_TRUE(found);
+}
+
+class AudioRate_RecordNodeTests : public RecordNodeTests {
+    void SetUp() override {
+        sampleRate = 44100.0;
+        RecordNodeTests::SetUp();
+    }
+};
+
+TEST_F(AudioRate_RecordNodeTests, Test_FileReaderPlaysAllStreams) {
+    // The File Reader plays one file sample per device sample only at the device's rate
+    if (tester->audioComponent->getSampleRate() != int(sampleRate))
+        GTEST_SKIP() << "needs a 44.1 kHz audio device";
+
+    // 100 ms at 44.1 kHz, plus a second stream at half that rate
+    EngineParameter decimationFactor(EngineParameter::INT, 4, "LFP decimation factor", 2, 1, 100);
+    processor->recordEngine->setParameter(decimationFactor);
+
+    tester->startAcquisition(true);
+    int numSamples = 490;
+    for (int i = 0; i < 9; i++) {
+        auto inputBuffer = createBuffer(1000.0 + i * 100.0, 1.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+    tester->stopAcquisition();
+
+    // Each stream as stored in its files
+    const juce::File oebin(structureOebinPath().string());
+    BinarySource::BinaryFileSource source;
+    ASSERT_TRUE(source.openFile(oebin));
+    ASSERT_EQ(source.getNumRecords(), 2);
+
+    std::vector<AudioBuffer<float>> files;
+    for (int record = 0; record < 2; record++) {
+        source.setActiveRecord(record);
+        source.seekTo(0);
+        files.emplace_back(source.getActiveNumChannels(), int(source.getActiveNumSamples()));
+        ASSERT_EQ(source.readPlanarData(files.back().getArrayOfWritePointers(), files.back().getNumSamples()), files.back().getNumSamples());
+    }
+    ASSERT_EQ(files[0].getNumSamples(), 9 * numSamples);
+    ASSERT_EQ(files[1].getNumSamples(), 9 * numSamples / 2);
+
+    // A File Reader beside the record chain, playing both streams
+    FileReader* reader = new FileReader();
+    reader->setProcessorType(Plugin::Processor::SOURCE);
+    reader->setHeadlessMode(true);
+    const int readerId = tester->nextProcessorId++;
+    reader->setNodeId(readerId);
+    reader->registerParameters();
+    tester->processorGraph->addNode(std::unique_ptr<AudioProcessor>(reader), juce::AudioProcessorGraph::NodeID(readerId));
+    reader = (FileReader*) tester->processorGraph->getProcessorWithNodeId(readerId);
+    reader->initialize(true);
+
+    reader->getParameter("all_streams")->setNextValue(true, false);
+    ASSERT_TRUE(reader->setFile(oebin.getFullPathName(), false));
+    ASSERT_EQ(reader->getDataStreams().size(), 2);
+    ASSERT_EQ(reader->getPlaybackStop() - reader->getPlaybackStart(), files[0].getNumSamples());
+
+    const int blockSize = tester->audioComponent->getBufferSize();
+    AudioBuffer<float> output(files[0].getNumChannels() + files[1].getNumChannels(), blockSize);
+    std::vector<int64> positions = { 0, 0 };
+
+    // Plays one block, and checks each stream's sample numbers and data against its file
+    auto checkBlock = [&]() {
+        // let the reader thread refill its buffers, so nothing is padded
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        MidiBuffer events;
+        output.clear();
+        ((AudioProcessor*) reader)->processBlock(output, events);
+
+        std::map<uint16, std::pair<int64, uint32>> blocks;
+        for (const auto meta : events) {
+            const uint8* data = meta.data;
+            if (static_cast<Event::Type>(data[0]) == Event::Type::SYSTEM_EVENT
+                && static_cast<SystemEvent::Type>(data[1]) == SystemEvent::Type::TIMESTAMP_AND_SAMPLES) {
+                blocks[*reinterpret_cast<const uint16*>(data + 4)] = { *reinterpret_cast<const int64*>(data + 8),
+                                                                        *reinterpret_cast<const uint32*>(data + 24) };
+            }
+        }
+
+        int channelOffset = 0;
+        for (int s = 0; s < 2; s++) {
+            const AudioBuffer<float>& file = files[s];
+            const int length = file.getNumSamples();
+
+            // the second stream runs at half the rate; without looping, each stream stops at its end
+            int expectedSamples = blockSize >> s;
+            if (! reader->loopPlayback)
+                expectedSamples = int(std::min(int64(expectedSamples), length - positions[s]));
+
+            auto block = blocks[reader->getDataStreams()[s]->getStreamId()];
+            ASSERT_EQ(block.first, positions[s]);
+            ASSERT_EQ(int(block.second), expectedSamples);
+
+            for (int ch = 0; ch < file.getNumChannels(); ch++) {
+                for (int i = 0; i < expectedSamples; i++) {
+                    ASSERT_EQ(output.getSample(channelOffset + ch, i), file.getSample(ch, int((positions[s] + i) % length)));
+                }
+            }
+
+            positions[s] = (positions[s] + expectedSamples) % length;
+            channelOffset += file.getNumChannels();
+        }
+    };
+
+    reader->loopPlayback = true;
+    ASSERT_TRUE(reader->startAcquisition());
+
+    // Past the end of both streams, which loop together
+    for (int i = 0; i < 6; i++)
+        ASSERT_NO_FATAL_FAILURE(checkBlock());
+    ASSERT_LT(positions[0], 2 * blockSize);
+
+    // A seek moves the second stream to the same time
+    reader->setCurrentSample(1000);
+    positions = { 1000, 500 };
+    for (int i = 0; i < 2; i++)
+        ASSERT_NO_FATAL_FAILURE(checkBlock());
+
+    // Without looping, both streams stop at their ends
+    reader->loopPlayback = false;
+    while (! reader->hasFinishedPlayback())
+        ASSERT_NO_FATAL_FAILURE(checkBlock());
+    ASSERT_EQ(positions[0], 0);
+    ASSERT_EQ(positions[1], 0);
+
+    ASSERT_EQ(reader->getNumBufferUnderruns(), 0);
+    reader->stopAcquisition();
+}
+
+TEST_F(RecordNodeTests, Test_RecordBufferFollowsBudgetAndLatency) {
+    processor->recordThread->resetWriteLatencies();
+    processor->setRecordBufferBudget(1);
+
+    tester->startAcquisition(true);
+
+    // The budget is below what any buffer needs, so the smallest buffer is used
+    ASSERT_EQ(processor->getRecordBufferBlocks(), DATA_BUFFER_MIN_NBLOCKS);
+
+    int numSamples = 5;
+    for (int i = 0; i < 3; i++) {
+        auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+        writeBlock(inputBuffer);
+    }
+
+    for (int i = 0; i < 100 && processor->recordThread->getNumTimedWrites() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    tester->stopAcquisition();
+
+    // Writes that moved samples to disk were timed
+    ASSERT_GT(processor->recordThread->getNumTimedWrites(), 0);
+    ASSERT_GE(processor->recordThread->getWriteLatencyPercentile(0.5), 1.0);
+    ASSERT_LE(processor->recordThread->getWriteLatencyPercentile(0.5),
+              processor->recordThread->getWriteLatencyPercentile(1.0));
+
+    std::filesystem::path dataPath;
+    ASSERT_TRUE(continuousPathFor("continuous.dat", &dataPath));
+    ASSERT_EQ(std::filesystem::file_size(dataPath), 3 * numSamples * numChannels * sizeof(int16_t));
+}
+
+TEST_F(RecordNodeTests, Test_MeasuresWriteBandwidth) {
+    // 8 channels at 1 Hz, plus a sample number and a timestamp per sample
+    ASSERT_DOUBLE_EQ(processor->getRequiredWriteBandwidth(), numChannels * sizeof(int16_t) + sizeof(int64_t) + sizeof(double));
+    ASSERT_TRUE(processor->checkWriteBandwidth());
+
+    File directory(parentRecordingDir.string());
+    ASSERT_GT(DiskSpaceChecker::measureWriteBandwidth(directory, 4 * DISK_BENCHMARK_CHUNK_BYTES), 0.0);
+    ASSERT_EQ(DiskSpaceChecker::measureWriteBandwidth(directory.getChildFile("missing"), DISK_BENCHMARK_CHUNK_BYTES), 0.0);
+
+    // A new directory is measured in the background rather than by the caller
+    DiskSpaceChecker* checker = processor->getDiskSpaceChecker();
+    double bandwidth = checker->getWriteBandwidth(directory);
+    for (int i = 0; i < 3000 && bandwidth == 0.0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        bandwidth = checker->getWriteBandwidth(directory);
+    }
+    ASSERT_GT(bandwidth, 0.0);
+
+    // The benchmark leaves nothing behind
+    ASSERT_EQ(directory.findChildFiles(File::findFiles, false, "write_benchmark*").size(), 0);
+
+    const int64 bytesBefore = processor->recordThread->getBytesWritten();
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+    writeBlock(inputBuffer);
+    tester->stopAcquisition();
+
+    ASSERT_EQ(processor->recordThread->getBytesWritten() - bytesBefore, numSamples * numChannels * sizeof(int16_t));
+}
+
+TEST_F(RecordNodeTests, Test_ChecksWriteBandwidthPerDestination) {
+    auto secondaryDir = std::filesystem::temp_directory_path() / "record_node_tests_bandwidth";
+    std::error_code ec;
+    std::filesystem::remove_all(secondaryDir, ec);
+    std::filesystem::create_directory(secondaryDir);
+
+    File mainDirectory = processor->getDataDirectory();
+    File secondaryDirectory(secondaryDir.string());
+    ASSERT_EQ(processor->addSecondaryEngine("COMPRESSED", secondaryDirectory, {1, 3}), 0);
+
+    Array<File> destinations = processor->getRecordingDestinations();
+    ASSERT_EQ(destinations.size(), 2);
+    ASSERT_EQ(destinations[0], mainDirectory);
+    ASSERT_EQ(destinations[1], secondaryDirectory);
+
+    // The main engine's disk only carries the main engine's channels
+    const double timestampBytes = sizeof(int64_t) + sizeof(double);
+    const double mainBandwidth = processor->getRequiredWriteBandwidth(mainDirectory);
+    ASSERT_DOUBLE_EQ(mainBandwidth, numChannels * sizeof(int16_t) + timestampBytes);
+
+    // The compressed engine's two channels take less than their raw size
+    const double secondaryBandwidth = processor->getRequiredWriteBandwidth(secondaryDirectory);
+    ASSERT_GT(secondaryBandwidth, timestampBytes);
+    ASSERT_LT(secondaryBandwidth, 2 * sizeof(int16_t) + timestampBytes);
+
+    ASSERT_DOUBLE_EQ(processor->getRequiredWriteBandwidth(), mainBandwidth + secondaryBandwidth);
+    ASSERT_TRUE(processor->checkWriteBandwidth());
+
+    processor->clearSecondaryEngines();
+    std::filesystem::remove_all(secondaryDir, ec);
+}
+
+TEST_F(RecordNodeTests, Test_FinalizesBufferedNpyRecordsOnClose) {
+    std::filesystem::path npyPath = parentRecordingDir / "finalize_on_close.npy";
+
+    {
+        NpyFile npy(String(npyPath.string()), NpyType(BaseType::INT64, 1));
+        npy.setHeaderMode(NpyFile::FINALIZE_ON_CLOSE);
+
+        for (int64 i = 0; i < 3; i++)
+            npy.bufferRecord(&i, sizeof(int64));
+
+        // still buffered when the file is closed
+        ASSERT_EQ(npy.getNumBufferedRecords(), 3);
+    }
+
+    auto npyBin = loadNpyFileBinaryFullpath(npyPath.string());
+    std::string contents(npyBin.begin(), npyBin.end());
+    ASSERT_NE(contents.find("'shape': (3,)"), std::string::npos);
+
+    int64_t lastRecord;
+    std::memcpy(&lastRecord, npyBin.data() + npyBin.size() - sizeof(int64_t), sizeof(int64_t));
+    ASSERT_EQ(lastRecord, 2);
+}
+
+TEST_F(RecordNodeTests, Test_RepairsUnfinalizedNpyHeader) {
+    tester->startAcquisition(true);
+
+    int numSamples = 5;
+    auto inputBuffer = createBuffer(1000.0, 20.0, numChannels, numSamples);
+    writeBlock(inputBuffer);
+    tester->stopAcquisition();
+
+    std::filesystem::path sampleNumbersPath;
+    ASSERT_TRUE(continuousPathFor("sample_numbers.npy", &sampleNumbersPath));
+    auto finalized = loadNpyFileBinaryFullpath(sampleNumbersPath.string());
+
+    // Simulate a crash: the shape was never updated and a partial record was left at the end
+    std::string contents(finalized.begin(), finalized.end());
+    size_t shapePos = contents.find("'shape': (5,)");
+    ASSERT_NE(shapePos, std::string::npos);
+    contents.replace(shapePos, 13, "'shape': (0,)");
+    contents += "abc";
+    {
+        std::ofstream out(sampleNumbersPath, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), contents.size());
+    }
+
+    ASSERT_EQ(NpyFile::repairHeader(File(sampleNumbersPath.string())), numSamples);
+    ASSERT_EQ(loadNpyFileBinaryFullpath(sampleNumbersPath.string()), finalized);
+}
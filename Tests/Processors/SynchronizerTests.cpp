@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+
+#include <Processors/Synchronizer/Synchronizer.h>
+
+/*
+Streams added to the Synchronizer get integer handles in the order they were added.
+The first stream that does not generate its own timestamps becomes the main stream.
+*/
+TEST(SynchronizerTest, AssignsStreamHandles)
+{
+    Synchronizer synchronizer;
+
+    synchronizer.prepareForUpdate();
+    int mainHandle = synchronizer.addDataStream ("100|main", 30000.0f, 0);
+    int otherHandle = synchronizer.addDataStream ("101|other", 2500.0f, 0);
+    synchronizer.finishedUpdate();
+
+    EXPECT_EQ(mainHandle, 0);
+    EXPECT_EQ(otherHandle, 1);
+    EXPECT_EQ(synchronizer.getStreamHandle ("101|other"), otherHandle);
+    EXPECT_EQ(synchronizer.getStreamHandle ("102|missing"), -1);
+    EXPECT_EQ(synchronizer.getMainStreamHandle(), mainHandle);
+    EXPECT_EQ(synchronizer.getSyncLine (otherHandle), 0);
+    EXPECT_EQ(synchronizer.getSyncLine (-1), -1);
+}
+
+/*
+The main stream's clock defines global time, so its timestamps are its sample numbers
+over its sample rate, whether it is addressed by key or by handle. Other streams convert
+to -1 until they have been synchronized.
+*/
+TEST(SynchronizerTest, ConvertsTimestampsByHandle)
+{
+    Synchronizer synchronizer;
+
+    synchronizer.prepareForUpdate();
+    int mainHandle = synchronizer.addDataStream ("100|main", 30000.0f, 0);
+    int otherHandle = synchronizer.addDataStream ("101|other", 2500.0f, 0);
+    synchronizer.finishedUpdate();
+
+    EXPECT_TRUE(synchronizer.isStreamSynced (mainHandle));
+    EXPECT_DOUBLE_EQ(synchronizer.convertSampleNumberToTimestamp (mainHandle, 45000), 1.5);
+    EXPECT_DOUBLE_EQ(synchronizer.convertSampleNumberToTimestamp (String ("100|main"), 45000), 1.5);
+    EXPECT_EQ(synchronizer.convertTimestampToSampleNumber (mainHandle, 2.0), 60000);
+
+    EXPECT_FALSE(synchronizer.isStreamSynced (otherHandle));
+    EXPECT_DOUBLE_EQ(synchronizer.convertSampleNumberToTimestamp (otherHandle, 45000), -1.0);
+    EXPECT_EQ(synchronizer.convertTimestampToSampleNumber (otherHandle, 2.0), -1);
+    EXPECT_DOUBLE_EQ(synchronizer.convertSampleNumberToTimestamp (-1, 45000), -1.0);
+}
+
+/*
+A stream whose clock runs slightly fast is mapped onto the main clock by a regression
+over its matched sync pulses: converted timestamps track global time to well within a
+millisecond, and the reported accuracy is the RMS residual of the fit.
+*/
+TEST(SynchronizerTest, EstimatesClockDrift)
+{
+    Synchronizer synchronizer;
+
+    SyncStream mainStream ("100|main", 30000.0f, &synchronizer);
+    SyncStream otherStream ("101|other", 2500.0f, &synchronizer);
+    mainStream.reset ("100|main");
+    otherStream.reset ("100|main");
+
+    const double otherRate = 2500.5; // 200 ppm fast
+
+    for (int i = 0; i < 40; i++)
+    {
+        const double onTime = 0.5 + i;
+        const int64 millis = 1000 + i * 1000;
+
+        mainStream.addEvent (int64 (onTime * 30000), true, millis);
+        mainStream.addEvent (int64 ((onTime + 0.5) * 30000), false, millis);
+        otherStream.addEvent (int64 (onTime * otherRate), true, millis);
+        otherStream.addEvent (int64 ((onTime + 0.5) * otherRate), false, millis);
+
+        otherStream.syncWith (&mainStream);
+        otherStream.publishConversion();
+    }
+
+    ASSERT_TRUE(otherStream.hasSynchronizedConversion());
+
+    double timestamp, secondsPerSample;
+    ASSERT_TRUE(otherStream.toTimestampRamp (int64 (30.0 * otherRate), timestamp, secondsPerSample));
+
+    EXPECT_NEAR(timestamp, 30.0, 0.001);
+    EXPECT_NEAR(1.0 / secondsPerSample, otherRate, 0.05);
+    EXPECT_LT(std::abs (otherStream.getSyncAccuracy()), 1.0);
+}
+
+/*
+Each newly matched pulse starts a new conversion segment. The segment continues from
+where the previous one reached that pulse, so converted timestamps never step, even
+though every pulse nudges the regression; the segments still converge on the drifting clock.
+*/
+TEST(SynchronizerTest, JoinsConversionSegmentsAtPulses)
+{
+    Synchronizer synchronizer;
+
+    SyncStream mainStream ("100|main", 30000.0f, &synchronizer);
+    SyncStream otherStream ("101|other", 2500.0f, &synchronizer);
+    mainStream.reset ("100|main");
+    otherStream.reset ("100|main");
+
+    const double otherRate = 2500.5; // 200 ppm fast
+    std::vector<int64> pulseSamples;
+
+    for (int i = 0; i < 40; i++)
+    {
+        const double onTime = 0.5 + i;
+        const int64 millis = 1000 + i * 1000;
+
+        pulseSamples.push_back (int64 (onTime * otherRate));
+
+        mainStream.addEvent (int64 (onTime * 30000), true, millis);
+        mainStream.addEvent (int64 ((onTime + 0.5) * 30000), false, millis);
+        otherStream.addEvent (pulseSamples.back(), true, millis);
+        otherStream.addEvent (int64 ((onTime + 0.5) * otherRate), false, millis);
+
+        double secondsPerSample;
+        std::vector<double> before (pulseSamples.size());
+        bool wasSynchronized = true;
+
+        for (size_t p = 0; p < pulseSamples.size(); p++)
+            wasSynchronized &= otherStream.toTimestampRamp (pulseSamples[p], before[p], secondsPerSample);
+
+        otherStream.syncWith (&mainStream);
+        otherStream.publishConversion();
+
+        // once the regression drives the conversion, the new segment meets the previous one at a pulse
+        if (wasSynchronized && i > 10)
+        {
+            bool joined = false;
+
+            for (size_t p = 0; p < pulseSamples.size(); p++)
+            {
+                double after;
+                ASSERT_TRUE(otherStream.toTimestampRamp (pulseSamples[p], after, secondsPerSample));
+                joined |= std::abs (after - before[p]) < 1e-9;
+            }
+
+            EXPECT_TRUE(joined);
+        }
+    }
+
+    double timestamp, secondsPerSample;
+    ASSERT_TRUE(otherStream.toTimestampRamp (int64 (39.5 * otherRate), timestamp, secondsPerSample));
+    EXPECT_NEAR(timestamp, 39.5, 0.001);
+}
@@ -72,6 +72,21 @@ void FakeSourceNode::updateSettings()
             "FakeSourceNodeMetadata",
             "identifier"));
     }
+
+    for (int index = 0; index < params.spikeChannels; index++)
+    {
+        SpikeChannel::Settings spikeSettings {
+            SpikeChannel::Type::SINGLE,
+            "Electrode" + String (index + 1),
+            "description",
+            "identifier.spikes",
+            { index % params.channels }
+        };
+
+        spikeChannels.add (new SpikeChannel (spikeSettings));
+        spikeChannels.getLast()->addProcessor (this);
+        spikeChannels.getLast()->setDataStream (dataStreams.getFirst(), true);
+    }
 }
 
 void FakeSourceNode::setParams (const FakeSourceNodeParams& params)
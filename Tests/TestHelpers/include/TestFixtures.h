@@ -205,7 +205,8 @@ public:
     AudioBuffer<float> processBlock (
         GenericProcessor* processor,
         const AudioBuffer<float>& buffer,
-        TTLEvent* maybeTtlEvent = nullptr)
+        TTLEvent* maybeTtlEvent = nullptr,
+        Spike* maybeSpike = nullptr)
     {
         auto audioProcessor = (AudioProcessor*) processor;
         auto dataStreams = processor->getDataStreams();
@@ -233,6 +234,15 @@ public:
                 maybeTtlEvent->serialize (ttlBuffer, ttlSize);
                 eventBuffer.addEvent (ttlBuffer, ttlSize, 0);
             }
+
+            if (maybeSpike != nullptr)
+            {
+                const SpikeChannel* spikeChannel = maybeSpike->getChannelInfo();
+                size_t spikeSize = SPIKE_BASE_SIZE + spikeChannel->getDataSize() + spikeChannel->getTotalEventMetadataSize() + spikeChannel->getNumChannels() * sizeof (float);
+                HeapBlock<char> spikeBuffer (spikeSize);
+                maybeSpike->serialize (spikeBuffer, spikeSize);
+                eventBuffer.addEvent (spikeBuffer, int (spikeSize), 0);
+            }
         }
 
         // Copies the input buffer so that remains unmodified